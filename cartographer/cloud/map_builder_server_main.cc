@@ -32,12 +32,17 @@ DEFINE_string(configuration_directory, "",
 DEFINE_string(configuration_basename, "",
               "Basename, i.e. not containing any directory prefix, of the "
               "configuration file.");
+DEFINE_string(configuration_cache_filename, "",
+              "If non-empty, the compiled options are cached in this file and "
+              "reused on startup while the configuration files are "
+              "unchanged.");
 
 namespace cartographer {
 namespace cloud {
 
 void Run(const std::string& configuration_directory,
-         const std::string& configuration_basename) {
+         const std::string& configuration_basename,
+         const std::string& configuration_cache_filename) {
 #if USE_PROMETHEUS
   metrics::prometheus::FamilyFactory registry;
   ::cartographer::metrics::RegisterAllMetrics(&registry);
@@ -48,8 +53,12 @@ void Run(const std::string& configuration_directory,
 #endif
 //prometheus
   proto::MapBuilderServerOptions map_builder_server_options =
-      LoadMapBuilderServerOptions(configuration_directory,
-                                  configuration_basename);
+      configuration_cache_filename.empty()
+          ? LoadMapBuilderServerOptions(configuration_directory,
+                                        configuration_basename)
+          : LoadMapBuilderServerOptionsWithCache(configuration_directory,
+                                                 configuration_basename,
+                                                 configuration_cache_filename);
   auto map_builder = mapping::CreateMapBuilder(
       map_builder_server_options.map_builder_options());
   std::unique_ptr<MapBuilderServerInterface> map_builder_server =
@@ -75,5 +84,6 @@ int main(int argc, char** argv) {
     return EXIT_FAILURE;
   }
   cartographer::cloud::Run(FLAGS_configuration_directory,
-                           FLAGS_configuration_basename);
+                           FLAGS_configuration_basename,
+                           FLAGS_configuration_cache_filename);
 }
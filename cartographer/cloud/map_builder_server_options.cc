@@ -17,6 +17,7 @@
 #include "cartographer/cloud/map_builder_server_options.h"
 
 #include "absl/memory/memory.h"
+#include "cartographer/common/configuration_cache.h"
 #include "cartographer/common/configuration_file_resolver.h"
 #include "cartographer/mapping/map_builder_interface.h"
 
@@ -58,5 +59,14 @@ proto::MapBuilderServerOptions LoadMapBuilderServerOptions(
   return CreateMapBuilderServerOptions(&lua_parameter_dictionary);
 }
 
+proto::MapBuilderServerOptions LoadMapBuilderServerOptionsWithCache(
+    const std::string& configuration_directory,
+    const std::string& configuration_basename,
+    const std::string& cache_filename) {
+  return common::LoadOptionsWithCache<proto::MapBuilderServerOptions>(
+      {configuration_directory}, configuration_basename, cache_filename,
+      CreateMapBuilderServerOptions);
+}
+
 }  // namespace cloud
 }  // namespace cartographer
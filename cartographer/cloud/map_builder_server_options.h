@@ -32,6 +32,13 @@ proto::MapBuilderServerOptions LoadMapBuilderServerOptions(
     const std::string& configuration_directory,
     const std::string& configuration_basename);
 
+// Like 'LoadMapBuilderServerOptions', but reuses the options compiled into
+// 'cache_filename' while none of the configuration files changed.
+proto::MapBuilderServerOptions LoadMapBuilderServerOptionsWithCache(
+    const std::string& configuration_directory,
+    const std::string& configuration_basename,
+    const std::string& cache_filename);
+
 }  // namespace cloud
 }  // namespace cartographer
 
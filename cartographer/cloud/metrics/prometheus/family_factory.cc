@@ -16,12 +16,14 @@
 
 #include "cartographer/cloud/metrics/prometheus/family_factory.h"
 
-#include "absl/container/flat_hash_map.h"
+#include <functional>
+#include <limits>
+#include <map>
+
 #include "absl/memory/memory.h"
-#include "prometheus/counter.h"
-#include "prometheus/family.h"
-#include "prometheus/gauge.h"
-#include "prometheus/histogram.h"
+#include "absl/synchronization/mutex.h"
+#include "cartographer/metrics/sharded_cell.h"
+#include "prometheus/metric_family.h"
 
 namespace cartographer {
 namespace cloud {
@@ -30,164 +32,206 @@ namespace prometheus {
 namespace {
 
 using BucketBoundaries = ::cartographer::metrics::Histogram::BucketBoundaries;
-
-// Creates or looks up already existing objects from a wrapper map.
-template <typename WrapperMap,
-          typename ObjectPtr = typename WrapperMap::key_type,
-          typename Wrapper = typename WrapperMap::mapped_type::element_type>
-Wrapper* GetOrCreateWrapper(ObjectPtr object_ptr, WrapperMap* wrapper_map,
-                            std::mutex* wrapper_mutex) {
-  std::lock_guard<std::mutex> lock(*wrapper_mutex);
-  auto wrappers_itr = wrapper_map->find(object_ptr);
-  if (wrappers_itr == wrapper_map->end()) {
-    auto wrapper = absl::make_unique<Wrapper>(object_ptr);
-    auto* ptr = wrapper.get();
-    (*wrapper_map)[object_ptr] = std::unique_ptr<Wrapper>(std::move(wrapper));
-    return ptr;
+using Labels = std::map<std::string, std::string>;
+using ::cartographer::metrics::AtomicDoubleCell;
+using ::cartographer::metrics::ShardedDoubleCell;
+using ::cartographer::metrics::ShardedHistogramCell;
+
+std::vector<::prometheus::ClientMetric::Label> ToPrometheusLabels(
+    const Labels& labels) {
+  std::vector<::prometheus::ClientMetric::Label> result;
+  for (const auto& label : labels) {
+    ::prometheus::ClientMetric::Label prometheus_label;
+    prometheus_label.name = label.first;
+    prometheus_label.value = label.second;
+    result.push_back(prometheus_label);
   }
-  return wrappers_itr->second.get();
+  return result;
 }
 
 class Counter : public ::cartographer::metrics::Counter {
  public:
-  explicit Counter(::prometheus::Counter* prometheus)
-      : prometheus_(prometheus) {}
-
-  void Increment() override { prometheus_->Increment(); }
-  void Increment(double by_value) override { prometheus_->Increment(by_value); }
-
- private:
-  ::prometheus::Counter* prometheus_;
-};
+  using InterfaceType = ::cartographer::metrics::Counter;
 
-class CounterFamily
-    : public ::cartographer::metrics::Family<::cartographer::metrics::Counter> {
- public:
-  explicit CounterFamily(
-      ::prometheus::Family<::prometheus::Counter>* prometheus)
-      : prometheus_(prometheus) {}
+  void Increment() override { cell_.Add(1.); }
+  void Increment(double by_value) override {
+    // Like Prometheus, ignore attempts to decrease a counter.
+    if (by_value < 0.) return;
+    cell_.Add(by_value);
+  }
 
-  Counter* Add(const std::map<std::string, std::string>& labels) override {
-    ::prometheus::Counter* counter = &prometheus_->Add(labels);
-    return GetOrCreateWrapper<>(counter, &wrappers_, &wrappers_mutex_);
+  void Collect(::prometheus::ClientMetric* metric) const {
+    metric->counter.value = cell_.Value();
   }
 
  private:
-  ::prometheus::Family<::prometheus::Counter>* prometheus_;
-  std::mutex wrappers_mutex_;
-  absl::flat_hash_map<::prometheus::Counter*, std::unique_ptr<Counter>>
-      wrappers_;
+  ShardedDoubleCell cell_;
 };
 
 class Gauge : public ::cartographer::metrics::Gauge {
  public:
-  explicit Gauge(::prometheus::Gauge* prometheus) : prometheus_(prometheus) {}
+  using InterfaceType = ::cartographer::metrics::Gauge;
+
+  void Decrement() override { cell_.Add(-1.); }
+  void Decrement(double by_value) override { cell_.Add(-by_value); }
+  void Increment() override { cell_.Add(1.); }
+  void Increment(double by_value) override { cell_.Add(by_value); }
+  void Set(double value) override { cell_.Set(value); }
 
-  void Decrement() override { prometheus_->Decrement(); }
-  void Decrement(double by_value) override { prometheus_->Decrement(by_value); }
-  void Increment() override { prometheus_->Increment(); }
-  void Increment(double by_value) override { prometheus_->Increment(by_value); }
-  void Set(double value) override { prometheus_->Set(value); }
+  void Collect(::prometheus::ClientMetric* metric) const {
+    metric->gauge.value = cell_.Value();
+  }
 
  private:
-  ::prometheus::Gauge* prometheus_;
+  // Gauges are set from several threads, which requires a single cell.
+  AtomicDoubleCell cell_;
 };
 
-class GaugeFamily
-    : public ::cartographer::metrics::Family<::cartographer::metrics::Gauge> {
+class Histogram : public ::cartographer::metrics::Histogram {
  public:
-  explicit GaugeFamily(::prometheus::Family<::prometheus::Gauge>* prometheus)
-      : prometheus_(prometheus) {}
-
-  Gauge* Add(const std::map<std::string, std::string>& labels) override {
-    ::prometheus::Gauge* gauge = &prometheus_->Add(labels);
-    return GetOrCreateWrapper<>(gauge, &wrappers_, &wrappers_mutex_);
+  using InterfaceType = ::cartographer::metrics::Histogram;
+
+  explicit Histogram(const BucketBoundaries& boundaries) : cell_(boundaries) {}
+
+  void Observe(double value) override { cell_.Observe(value); }
+
+  void Collect(::prometheus::ClientMetric* metric) const {
+    const ShardedHistogramCell::Snapshot snapshot = cell_.Collect();
+    metric->histogram.sample_count = snapshot.sample_count;
+    metric->histogram.sample_sum = snapshot.sample_sum;
+    uint64 cumulative_count = 0;
+    for (size_t i = 0; i < snapshot.bucket_counts.size(); ++i) {
+      cumulative_count += snapshot.bucket_counts[i];
+      ::prometheus::ClientMetric::Bucket bucket;
+      bucket.cumulative_count = cumulative_count;
+      bucket.upper_bound = i < cell_.bucket_boundaries().size()
+                               ? cell_.bucket_boundaries()[i]
+                               : std::numeric_limits<double>::infinity();
+      metric->histogram.bucket.push_back(bucket);
+    }
   }
 
  private:
-  ::prometheus::Family<::prometheus::Gauge>* prometheus_;
-  std::mutex wrappers_mutex_;
-  absl::flat_hash_map<::prometheus::Gauge*, std::unique_ptr<Gauge>> wrappers_;
+  ShardedHistogramCell cell_;
 };
 
-class Histogram : public ::cartographer::metrics::Histogram {
+class CollectableFamily {
  public:
-  explicit Histogram(::prometheus::Histogram* prometheus)
-      : prometheus_(prometheus) {}
+  virtual ~CollectableFamily() = default;
+  virtual ::prometheus::MetricFamily Collect() = 0;
+};
 
-  void Observe(double value) override { prometheus_->Observe(value); }
+// A family whose metrics are backed by sharded cells. Looking up a metric by
+// its labels takes a lock, updating it afterwards does not. The shards are
+// only aggregated when the family is collected.
+template <typename MetricType>
+class ShardedFamily
+    : public ::cartographer::metrics::Family<
+          typename MetricType::InterfaceType>,
+      public CollectableFamily {
+ public:
+  using Factory = std::function<std::unique_ptr<MetricType>()>;
+
+  ShardedFamily(const std::string& name, const std::string& description,
+                ::prometheus::MetricType type, Factory factory)
+      : name_(name),
+        description_(description),
+        type_(type),
+        factory_(std::move(factory)) {}
+
+  MetricType* Add(const Labels& labels) override {
+    absl::MutexLock lock(&mutex_);
+    auto& metric = metrics_[labels];
+    if (metric == nullptr) {
+      metric = factory_();
+    }
+    return metric.get();
+  }
+
+  ::prometheus::MetricFamily Collect() override {
+    ::prometheus::MetricFamily family;
+    family.name = name_;
+    family.help = description_;
+    family.type = type_;
+    absl::MutexLock lock(&mutex_);
+    for (const auto& entry : metrics_) {
+      ::prometheus::ClientMetric metric;
+      metric.label = ToPrometheusLabels(entry.first);
+      entry.second->Collect(&metric);
+      family.metric.push_back(std::move(metric));
+    }
+    return family;
+  }
 
  private:
-  ::prometheus::Histogram* prometheus_;
+  const std::string name_;
+  const std::string description_;
+  const ::prometheus::MetricType type_;
+  const Factory factory_;
+  absl::Mutex mutex_;
+  std::map<Labels, std::unique_ptr<MetricType>> metrics_ GUARDED_BY(mutex_);
 };
 
-class HistogramFamily : public ::cartographer::metrics::Family<
-                            ::cartographer::metrics::Histogram> {
+}  // namespace
+
+// Owns all families and aggregates their sharded cells whenever Prometheus
+// scrapes.
+class FamilyFactory::Collectable : public ::prometheus::Collectable {
  public:
-  HistogramFamily(::prometheus::Family<::prometheus::Histogram>* prometheus,
-                  const BucketBoundaries& boundaries)
-      : prometheus_(prometheus), boundaries_(boundaries) {}
+  template <typename FamilyType>
+  FamilyType* AddFamily(std::unique_ptr<FamilyType> family) {
+    FamilyType* ptr = family.get();
+    absl::MutexLock lock(&mutex_);
+    families_.push_back(std::move(family));
+    return ptr;
+  }
 
-  Histogram* Add(const std::map<std::string, std::string>& labels) override {
-    ::prometheus::Histogram* histogram = &prometheus_->Add(labels, boundaries_);
-    return GetOrCreateWrapper<>(histogram, &wrappers_, &wrappers_mutex_);
+  std::vector<::prometheus::MetricFamily> Collect() override {
+    std::vector<::prometheus::MetricFamily> result;
+    absl::MutexLock lock(&mutex_);
+    for (const auto& family : families_) {
+      result.push_back(family->Collect());
+    }
+    return result;
   }
 
  private:
-  ::prometheus::Family<::prometheus::Histogram>* prometheus_;
-  std::mutex wrappers_mutex_;
-  absl::flat_hash_map<::prometheus::Histogram*, std::unique_ptr<Histogram>>
-      wrappers_;
-  const BucketBoundaries boundaries_;
+  absl::Mutex mutex_;
+  std::vector<std::unique_ptr<CollectableFamily>> families_ GUARDED_BY(mutex_);
 };
 
-}  // namespace
-
 FamilyFactory::FamilyFactory()
-    : registry_(std::make_shared<::prometheus::Registry>()) {}
+    : collectable_(std::make_shared<Collectable>()) {}
+
+FamilyFactory::~FamilyFactory() = default;
 
 ::cartographer::metrics::Family<::cartographer::metrics::Counter>*
 FamilyFactory::NewCounterFamily(const std::string& name,
                                 const std::string& description) {
-  auto& family = ::prometheus::BuildCounter()
-                     .Name(name)
-                     .Help(description)
-                     .Register(*registry_);
-  auto wrapper = absl::make_unique<CounterFamily>(&family);
-  auto* ptr = wrapper.get();
-  counters_.emplace_back(std::move(wrapper));
-  return ptr;
+  return collectable_->AddFamily(absl::make_unique<ShardedFamily<Counter>>(
+      name, description, ::prometheus::MetricType::Counter,
+      []() { return absl::make_unique<Counter>(); }));
 }
 
 ::cartographer::metrics::Family<::cartographer::metrics::Gauge>*
 FamilyFactory::NewGaugeFamily(const std::string& name,
                               const std::string& description) {
-  auto& family = ::prometheus::BuildGauge()
-                     .Name(name)
-                     .Help(description)
-                     .Register(*registry_);
-  auto wrapper = absl::make_unique<GaugeFamily>(&family);
-  auto* ptr = wrapper.get();
-  gauges_.emplace_back(std::move(wrapper));
-  return ptr;
+  return collectable_->AddFamily(absl::make_unique<ShardedFamily<Gauge>>(
+      name, description, ::prometheus::MetricType::Gauge,
+      []() { return absl::make_unique<Gauge>(); }));
 }
 
 ::cartographer::metrics::Family<::cartographer::metrics::Histogram>*
 FamilyFactory::NewHistogramFamily(const std::string& name,
                                   const std::string& description,
                                   const BucketBoundaries& boundaries) {
-  auto& family = ::prometheus::BuildHistogram()
-                     .Name(name)
-                     .Help(description)
-                     .Register(*registry_);
-  auto wrapper = absl::make_unique<HistogramFamily>(&family, boundaries);
-  auto* ptr = wrapper.get();
-  histograms_.emplace_back(std::move(wrapper));
-  return ptr;
+  return collectable_->AddFamily(absl::make_unique<ShardedFamily<Histogram>>(
+      name, description, ::prometheus::MetricType::Histogram,
+      [boundaries]() { return absl::make_unique<Histogram>(boundaries); }));
 }
 
 std::weak_ptr<::prometheus::Collectable> FamilyFactory::GetCollectable() const {
-  return registry_;
+  return collectable_;
 }
 
 }  // namespace prometheus
@@ -21,16 +21,21 @@
 #include <string>
 
 #include "cartographer/metrics/family_factory.h"
-#include "prometheus/registry.h"
+#include "prometheus/collectable.h"
 
 namespace cartographer {
 namespace cloud {
 namespace metrics {
 namespace prometheus {
 
+// Counters and histograms created by this factory are backed by thread-sharded
+// cells so that they can be updated from hot paths without contention. The
+// cells are aggregated lazily when the collectable is scraped. Gauges can be
+// set, so each is backed by a single atomic.
 class FamilyFactory : public ::cartographer::metrics::FamilyFactory {
  public:
   FamilyFactory();
+  ~FamilyFactory() override;
 
   ::cartographer::metrics::Family<::cartographer::metrics::Counter>*
   NewCounterFamily(const std::string& name,
@@ -46,16 +51,9 @@ class FamilyFactory : public ::cartographer::metrics::FamilyFactory {
   std::weak_ptr<::prometheus::Collectable> GetCollectable() const;
 
  private:
-  std::vector<std::unique_ptr<
-      ::cartographer::metrics::Family<::cartographer::metrics::Counter>>>
-      counters_;
-  std::vector<std::unique_ptr<
-      ::cartographer::metrics::Family<::cartographer::metrics::Gauge>>>
-      gauges_;
-  std::vector<std::unique_ptr<
-      ::cartographer::metrics::Family<::cartographer::metrics::Histogram>>>
-      histograms_;
-  std::shared_ptr<::prometheus::Registry> registry_;
+  class Collectable;
+
+  std::shared_ptr<Collectable> collectable_;
 };
 
 }  // namespace prometheus
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures the throughput of 'BlockingQueue' and 'LockFreeBlockingQueue'
+// under contention from several producer and consumer threads.
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "cartographer/common/internal/blocking_queue.h"
+#include "cartographer/common/internal/lock_free_blocking_queue.h"
+#include "cartographer/common/port.h"
+#include "cartographer/common/time.h"
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+
+DEFINE_int32(num_producers, 4, "Number of threads pushing values.");
+DEFINE_int32(num_consumers, 4, "Number of threads popping values.");
+DEFINE_int32(num_values_per_producer, 200000,
+             "Number of values each producer pushes.");
+DEFINE_int32(queue_size, 1024, "Capacity of the queues.");
+
+namespace cartographer {
+namespace common {
+namespace {
+
+struct Payload {
+  int64 value;
+};
+
+// Runs the producers and consumers on 'queue' and returns the elapsed time in
+// seconds.
+template <typename QueueType>
+double RunBenchmark(QueueType* queue) {
+  const int64 num_values =
+      int64{FLAGS_num_producers} * FLAGS_num_values_per_producer;
+  CHECK_EQ(num_values % FLAGS_num_consumers, 0)
+      << "The number of values must be divisible by the number of consumers.";
+  std::vector<std::thread> threads;
+  std::vector<int64> sums(FLAGS_num_consumers, 0);
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < FLAGS_num_producers; ++i) {
+    threads.emplace_back([queue]() {
+      for (int j = 0; j < FLAGS_num_values_per_producer; ++j) {
+        queue->Push(absl::make_unique<Payload>(Payload{j}));
+      }
+    });
+  }
+  for (int i = 0; i < FLAGS_num_consumers; ++i) {
+    threads.emplace_back([queue, num_values, &sums, i]() {
+      for (int64 j = 0; j < num_values / FLAGS_num_consumers; ++j) {
+        sums[i] += queue->Pop()->value;
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  const double elapsed_seconds =
+      ToSeconds(std::chrono::steady_clock::now() - start);
+  int64 total = 0;
+  for (const int64 sum : sums) {
+    total += sum;
+  }
+  CHECK_EQ(total, int64{FLAGS_num_producers} * FLAGS_num_values_per_producer *
+                      (FLAGS_num_values_per_producer - 1) / 2);
+  return elapsed_seconds;
+}
+
+void Report(const std::string& name, const double elapsed_seconds) {
+  const int64 num_values =
+      int64{FLAGS_num_producers} * FLAGS_num_values_per_producer;
+  std::cout << name << ": " << num_values << " values in " << elapsed_seconds
+            << " s, " << num_values / elapsed_seconds << " values/s"
+            << std::endl;
+}
+
+void Run() {
+  std::cout << FLAGS_num_producers << " producers, " << FLAGS_num_consumers
+            << " consumers, queue size " << FLAGS_queue_size << std::endl;
+  {
+    BlockingQueue<std::unique_ptr<Payload>> queue(FLAGS_queue_size);
+    Report("BlockingQueue", RunBenchmark(&queue));
+  }
+  {
+    LockFreeBlockingQueue<std::unique_ptr<Payload>> queue(FLAGS_queue_size);
+    Report("LockFreeBlockingQueue", RunBenchmark(&queue));
+  }
+}
+
+}  // namespace
+}  // namespace common
+}  // namespace cartographer
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  google::SetUsageMessage(
+      "Compares the throughput of the blocking queue implementations with "
+      "multiple producers and consumers.");
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  CHECK_GT(FLAGS_num_producers, 0);
+  CHECK_GT(FLAGS_num_consumers, 0);
+  CHECK_GT(FLAGS_queue_size, 0);
+  ::cartographer::common::Run();
+}
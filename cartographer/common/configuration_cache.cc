@@ -0,0 +1,174 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cartographer/common/configuration_cache.h"
+
+#include <cstdio>
+#include <fstream>
+#include <set>
+
+#include "absl/memory/memory.h"
+#include "google/protobuf/descriptor.pb.h"
+
+namespace cartographer {
+namespace common {
+namespace {
+
+void AppendSchema(const google::protobuf::Descriptor* descriptor,
+                  std::set<std::string>* visited, std::string* schema) {
+  if (!visited->insert(descriptor->full_name()).second) {
+    return;
+  }
+  google::protobuf::DescriptorProto descriptor_proto;
+  descriptor->CopyTo(&descriptor_proto);
+  schema->append(descriptor->full_name());
+  schema->append(descriptor_proto.SerializeAsString());
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    const google::protobuf::Descriptor* field_type =
+        descriptor->field(i)->message_type();
+    if (field_type != nullptr) {
+      AppendSchema(field_type, visited, schema);
+    }
+  }
+}
+
+bool ReadConfigurationCache(const std::string& cache_filename,
+                            proto::ConfigurationCache* cache) {
+  std::ifstream stream(cache_filename, std::ios::in | std::ios::binary);
+  return stream.good() && cache->ParseFromIstream(&stream);
+}
+
+void WriteConfigurationCache(const std::string& cache_filename,
+                             const proto::ConfigurationCache& cache) {
+  // Write to a temporary file first so that concurrently starting processes
+  // never read a partially written cache.
+  const std::string temporary_filename = cache_filename + ".tmp";
+  {
+    std::ofstream stream(temporary_filename, std::ios::out |
+                                                 std::ios::binary |
+                                                 std::ios::trunc);
+    if (!stream.good() || !cache.SerializeToOstream(&stream)) {
+      LOG(WARNING) << "Failed to write configuration cache '"
+                   << temporary_filename << "'.";
+      return;
+    }
+  }
+  if (std::rename(temporary_filename.c_str(), cache_filename.c_str()) != 0) {
+    LOG(WARNING) << "Failed to write configuration cache '" << cache_filename
+                 << "'.";
+  }
+}
+
+}  // namespace
+
+uint64 FingerprintString(const std::string& data) {
+  // 64-bit FNV-1a.
+  uint64 fingerprint = 14695981039346656037ull;
+  for (const char c : data) {
+    fingerprint ^= static_cast<uint8>(c);
+    fingerprint *= 1099511628211ull;
+  }
+  return fingerprint;
+}
+
+uint64 FingerprintSchema(const google::protobuf::Descriptor* descriptor) {
+  std::set<std::string> visited;
+  std::string schema;
+  AppendSchema(descriptor, &visited, &schema);
+  return FingerprintString(schema);
+}
+
+RecordingFileResolver::RecordingFileResolver(
+    std::unique_ptr<FileResolver> file_resolver,
+    proto::ConfigurationCache* const cache)
+    : file_resolver_(std::move(file_resolver)), cache_(cache) {}
+
+std::string RecordingFileResolver::GetFullPathOrDie(
+    const std::string& basename) {
+  return file_resolver_->GetFullPathOrDie(basename);
+}
+
+std::string RecordingFileResolver::GetFileContentOrDie(
+    const std::string& basename) {
+  const std::string content = file_resolver_->GetFileContentOrDie(basename);
+  proto::ConfigurationCache::File* file = cache_->add_files();
+  file->set_basename(basename);
+  file->set_content_fingerprint(FingerprintString(content));
+  return content;
+}
+
+bool IsConfigurationCacheFresh(
+    const proto::ConfigurationCache& cache,
+    const std::string& configuration_basename, const uint64 schema_fingerprint,
+    ConfigurationFileResolver* const file_resolver) {
+  if (cache.schema_fingerprint() != schema_fingerprint ||
+      cache.files_size() == 0 ||
+      cache.files(0).basename() != configuration_basename) {
+    return false;
+  }
+  // The Lua code is deterministic given the content of the files, so if all
+  // files up to some point are unchanged, the next file read is the same as
+  // well.
+  for (const auto& file : cache.files()) {
+    if (!file_resolver->HasFile(file.basename())) {
+      return false;
+    }
+    if (FingerprintString(file_resolver->GetFileContentOrDie(
+            file.basename())) != file.content_fingerprint()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string LoadSerializedOptionsWithCache(
+    const std::vector<std::string>& configuration_directories,
+    const std::string& configuration_basename,
+    const std::string& cache_filename,
+    const google::protobuf::Descriptor* const options_descriptor,
+    const std::function<std::string(LuaParameterDictionary*)>& compile) {
+  const uint64 schema_fingerprint = FingerprintSchema(options_descriptor);
+  proto::ConfigurationCache cache;
+  if (ReadConfigurationCache(cache_filename, &cache)) {
+    ConfigurationFileResolver file_resolver(configuration_directories);
+    if (IsConfigurationCacheFresh(cache, configuration_basename,
+                                  schema_fingerprint, &file_resolver)) {
+      VLOG(1) << "Using configuration cache '" << cache_filename << "'.";
+      return cache.options();
+    }
+  }
+
+  LOG(INFO) << "Configuration cache '" << cache_filename
+            << "' is missing or outdated, compiling the configuration.";
+  cache.Clear();
+  cache.set_schema_fingerprint(schema_fingerprint);
+  auto file_resolver = absl::make_unique<RecordingFileResolver>(
+      absl::make_unique<ConfigurationFileResolver>(configuration_directories),
+      &cache);
+  const std::string code =
+      file_resolver->GetFileContentOrDie(configuration_basename);
+  {
+    // Like the uncached path, the dictionary is reference counted, so that its
+    // destructor CHECKs that every key was used before the cache is written.
+    LuaParameterDictionary parameter_dictionary(code, std::move(file_resolver));
+    cache.set_options(compile(&parameter_dictionary));
+  }
+  WriteConfigurationCache(cache_filename, cache);
+  return cache.options();
+}
+
+}  // namespace common
+}  // namespace cartographer
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CARTOGRAPHER_COMMON_CONFIGURATION_CACHE_H_
+#define CARTOGRAPHER_COMMON_CONFIGURATION_CACHE_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cartographer/common/configuration_file_resolver.h"
+#include "cartographer/common/lua_parameter_dictionary.h"
+#include "cartographer/common/port.h"
+#include "cartographer/common/proto/configuration_cache.pb.h"
+#include "glog/logging.h"
+#include "google/protobuf/descriptor.h"
+
+namespace cartographer {
+namespace common {
+
+// Returns a fingerprint of 'data' which is stable across runs and platforms.
+uint64 FingerprintString(const std::string& data);
+
+// Returns a fingerprint of the schema of 'descriptor' and all message types
+// reachable through its fields.
+uint64 FingerprintSchema(const google::protobuf::Descriptor* descriptor);
+
+// A 'FileResolver' that forwards to another one and records the fingerprint
+// of every file read into 'cache'.
+class RecordingFileResolver : public FileResolver {
+ public:
+  RecordingFileResolver(std::unique_ptr<FileResolver> file_resolver,
+                        proto::ConfigurationCache* cache);
+
+  std::string GetFullPathOrDie(const std::string& basename) override;
+  std::string GetFileContentOrDie(const std::string& basename) override;
+
+ private:
+  const std::unique_ptr<FileResolver> file_resolver_;
+  proto::ConfigurationCache* const cache_;
+};
+
+// Returns true if 'cache' was compiled from 'configuration_basename' for the
+// schema 'schema_fingerprint' and none of the files it read changed since.
+// Files which can no longer be found make the cache stale.
+bool IsConfigurationCacheFresh(const proto::ConfigurationCache& cache,
+                               const std::string& configuration_basename,
+                               uint64 schema_fingerprint,
+                               ConfigurationFileResolver* file_resolver);
+
+// Returns the serialized options proto compiled from 'configuration_basename'.
+// If 'cache_filename' holds a fresh cache, its options are returned without
+// running any Lua code. Otherwise, the configuration is compiled using
+// 'compile' and the cache is rewritten.
+std::string LoadSerializedOptionsWithCache(
+    const std::vector<std::string>& configuration_directories,
+    const std::string& configuration_basename,
+    const std::string& cache_filename,
+    const google::protobuf::Descriptor* options_descriptor,
+    const std::function<std::string(LuaParameterDictionary*)>& compile);
+
+// Typed version of 'LoadSerializedOptionsWithCache'. The dictionary passed to
+// 'create_options' is reference counted, so a configuration with keys unused
+// by 'create_options' fails a CHECK instead of being cached.
+template <typename OptionsType>
+OptionsType LoadOptionsWithCache(
+    const std::vector<std::string>& configuration_directories,
+    const std::string& configuration_basename,
+    const std::string& cache_filename,
+    const std::function<OptionsType(LuaParameterDictionary*)>&
+        create_options) {
+  OptionsType options;
+  CHECK(options.ParseFromString(LoadSerializedOptionsWithCache(
+      configuration_directories, configuration_basename, cache_filename,
+      OptionsType::descriptor(),
+      [&create_options](LuaParameterDictionary* parameter_dictionary) {
+        return create_options(parameter_dictionary).SerializeAsString();
+      })));
+  return options;
+}
+
+}  // namespace common
+}  // namespace cartographer
+
+#endif  // CARTOGRAPHER_COMMON_CONFIGURATION_CACHE_H_
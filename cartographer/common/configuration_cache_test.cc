@@ -0,0 +1,151 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cartographer/common/configuration_cache.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "cartographer/common/proto/ceres_solver_options.pb.h"
+#include "gtest/gtest.h"
+
+namespace cartographer {
+namespace common {
+namespace {
+
+void WriteFile(const std::string& filename, const std::string& content) {
+  std::ofstream stream(filename, std::ios::out | std::ios::trunc);
+  stream << content;
+  ASSERT_TRUE(stream.good());
+}
+
+TEST(ConfigurationCacheTest, FingerprintIsStable) {
+  EXPECT_EQ(FingerprintString(""), 0xcbf29ce484222325ull);
+  EXPECT_EQ(FingerprintString("a"), 0xaf63dc4c8601ec8cull);
+}
+
+TEST(ConfigurationCacheTest, RecompilesOnlyWhenIncludedFilesChange) {
+  const std::string directory = ::testing::TempDir();
+  const std::string cache_filename =
+      directory + "/configuration_cache_test.cache";
+  std::remove(cache_filename.c_str());
+  WriteFile(directory + "/configuration_cache_test_included.lua",
+            "ITERATIONS = 3");
+  WriteFile(directory + "/configuration_cache_test.lua",
+            "include \"configuration_cache_test_included.lua\"\n"
+            "return { max_num_iterations = ITERATIONS }");
+
+  int num_compilations = 0;
+  const auto load = [&]() {
+    return LoadOptionsWithCache<proto::CeresSolverOptions>(
+        {directory}, "configuration_cache_test.lua", cache_filename,
+        [&num_compilations](LuaParameterDictionary* parameter_dictionary) {
+          ++num_compilations;
+          proto::CeresSolverOptions options;
+          options.set_max_num_iterations(
+              parameter_dictionary->GetInt("max_num_iterations"));
+          return options;
+        });
+  };
+
+  EXPECT_EQ(load().max_num_iterations(), 3);
+  EXPECT_EQ(num_compilations, 1);
+  EXPECT_EQ(load().max_num_iterations(), 3);
+  EXPECT_EQ(num_compilations, 1);
+
+  WriteFile(directory + "/configuration_cache_test_included.lua",
+            "ITERATIONS = 5");
+  EXPECT_EQ(load().max_num_iterations(), 5);
+  EXPECT_EQ(num_compilations, 2);
+  EXPECT_EQ(load().max_num_iterations(), 5);
+  EXPECT_EQ(num_compilations, 2);
+}
+
+TEST(ConfigurationCacheTest, RecompilesWhenIncludedFileIsDeleted) {
+  const std::string directory = ::testing::TempDir();
+  const std::string cache_filename =
+      directory + "/configuration_cache_deleted_test.cache";
+  const std::string included_filename =
+      directory + "/configuration_cache_deleted_test_included.lua";
+  std::remove(cache_filename.c_str());
+  WriteFile(included_filename, "ITERATIONS = 3");
+  WriteFile(directory + "/configuration_cache_deleted_test.lua",
+            "include \"configuration_cache_deleted_test_included.lua\"\n"
+            "return { max_num_iterations = ITERATIONS }");
+
+  int num_compilations = 0;
+  const auto load = [&]() {
+    return LoadOptionsWithCache<proto::CeresSolverOptions>(
+        {directory}, "configuration_cache_deleted_test.lua", cache_filename,
+        [&num_compilations](LuaParameterDictionary* parameter_dictionary) {
+          ++num_compilations;
+          proto::CeresSolverOptions options;
+          options.set_max_num_iterations(
+              parameter_dictionary->GetInt("max_num_iterations"));
+          return options;
+        });
+  };
+  EXPECT_EQ(load().max_num_iterations(), 3);
+  EXPECT_EQ(num_compilations, 1);
+
+  proto::ConfigurationCache cache;
+  {
+    std::ifstream stream(cache_filename, std::ios::in | std::ios::binary);
+    ASSERT_TRUE(cache.ParseFromIstream(&stream));
+  }
+  ASSERT_EQ(cache.files_size(), 2);
+  ConfigurationFileResolver file_resolver({directory});
+  const uint64 schema_fingerprint =
+      FingerprintSchema(proto::CeresSolverOptions::descriptor());
+  EXPECT_TRUE(IsConfigurationCacheFresh(
+      cache, "configuration_cache_deleted_test.lua", schema_fingerprint,
+      &file_resolver));
+
+  ASSERT_EQ(std::remove(included_filename.c_str()), 0);
+  EXPECT_FALSE(IsConfigurationCacheFresh(
+      cache, "configuration_cache_deleted_test.lua", schema_fingerprint,
+      &file_resolver));
+
+  WriteFile(directory + "/configuration_cache_deleted_test.lua",
+            "return { max_num_iterations = 7 }");
+  EXPECT_EQ(load().max_num_iterations(), 7);
+  EXPECT_EQ(num_compilations, 2);
+}
+
+TEST(ConfigurationCacheTest, RejectsUnusedKeys) {
+  const std::string directory = ::testing::TempDir();
+  const std::string cache_filename =
+      directory + "/configuration_cache_unused_test.cache";
+  std::remove(cache_filename.c_str());
+  WriteFile(directory + "/configuration_cache_unused_test.lua",
+            "return { max_num_iterations = 3, max_num_iteration = 5 }");
+  EXPECT_DEATH(LoadOptionsWithCache<proto::CeresSolverOptions>(
+                   {directory}, "configuration_cache_unused_test.lua",
+                   cache_filename,
+                   [](LuaParameterDictionary* parameter_dictionary) {
+                     proto::CeresSolverOptions options;
+                     options.set_max_num_iterations(
+                         parameter_dictionary->GetInt("max_num_iterations"));
+                     return options;
+                   }),
+               "max_num_iteration");
+  EXPECT_FALSE(std::ifstream(cache_filename).good());
+}
+
+}  // namespace
+}  // namespace common
+}  // namespace cartographer
@@ -34,15 +34,29 @@ ConfigurationFileResolver::ConfigurationFileResolver(
 
 std::string ConfigurationFileResolver::GetFullPathOrDie(
     const std::string& basename) {
+  std::string filename;
+  CHECK(FindFullPath(basename, &filename))
+      << "File '" << basename << "' was not found.";
+  LOG(INFO) << "Found '" << filename << "' for '" << basename << "'.";
+  return filename;
+}
+
+bool ConfigurationFileResolver::HasFile(const std::string& basename) const {
+  std::string filename;
+  return FindFullPath(basename, &filename);
+}
+
+bool ConfigurationFileResolver::FindFullPath(const std::string& basename,
+                                             std::string* full_path) const {
   for (const auto& path : configuration_files_directories_) {
     const std::string filename = path + "/" + basename;
     std::ifstream stream(filename.c_str());
     if (stream.good()) {
-      LOG(INFO) << "Found '" << filename << "' for '" << basename << "'.";
-      return filename;
+      *full_path = filename;
+      return true;
     }
   }
-  LOG(FATAL) << "File '" << basename << "' was not found.";
+  return false;
 }
 
 std::string ConfigurationFileResolver::GetFileContentOrDie(
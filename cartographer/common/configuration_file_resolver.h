@@ -39,7 +39,14 @@ class ConfigurationFileResolver : public FileResolver {
   std::string GetFullPathOrDie(const std::string& basename) override;
   std::string GetFileContentOrDie(const std::string& basename) override;
 
+  // Returns true if 'basename' is found in one of the directories.
+  bool HasFile(const std::string& basename) const;
+
  private:
+  // Sets 'full_path' to the first existing path of 'basename' in the
+  // directories and returns true, or returns false if there is none.
+  bool FindFullPath(const std::string& basename, std::string* full_path) const;
+
   std::vector<std::string> configuration_files_directories_;
 };
 
@@ -0,0 +1,267 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CARTOGRAPHER_COMMON_INTERNAL_LOCK_FREE_BLOCKING_QUEUE_H_
+#define CARTOGRAPHER_COMMON_INTERNAL_LOCK_FREE_BLOCKING_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "cartographer/common/port.h"
+#include "cartographer/common/time.h"
+#include "glog/logging.h"
+
+namespace cartographer {
+namespace common {
+
+// A bounded multi-producer multi-consumer queue with the same interface as
+// 'BlockingQueue'. Values are stored in a ring buffer of sequenced cells, so
+// pushing and popping never take a lock as long as the queue is neither full
+// nor empty. Threads that have to wait spin briefly, then yield and finally
+// park on a condition variable until they are notified or time out.
+// 'T' must be movable and default constructible.
+template <typename T>
+class LockFreeBlockingQueue {
+ public:
+  // Constructs a queue holding at most 'queue_size' values.
+  explicit LockFreeBlockingQueue(const size_t queue_size)
+      : queue_size_(queue_size), cells_(new Cell[queue_size]) {
+    CHECK_GT(queue_size_, 0);
+    for (size_t i = 0; i < queue_size_; ++i) {
+      cells_[i].sequence.store(2 * i, std::memory_order_relaxed);
+    }
+    enqueue_position_.store(0, std::memory_order_relaxed);
+    dequeue_position_.store(0, std::memory_order_relaxed);
+  }
+
+  LockFreeBlockingQueue(const LockFreeBlockingQueue&) = delete;
+  LockFreeBlockingQueue& operator=(const LockFreeBlockingQueue&) = delete;
+
+  // Pushes a value onto the queue. Blocks if the queue is full.
+  void Push(T t) { CHECK(PushUntil(&t, absl::InfiniteFuture())); }
+
+  // Like push, but returns false if 'timeout' is reached.
+  bool PushWithTimeout(T t, const common::Duration timeout) {
+    return PushUntil(&t, absl::Now() + absl::FromChrono(timeout));
+  }
+
+  // Pushes a value if the queue is not full and returns true. Otherwise,
+  // returns false and leaves '*t' untouched.
+  bool TryPush(T* t) {
+    if (!TryPushWithoutNotify(t)) {
+      return false;
+    }
+    Notify(&not_empty_);
+    return true;
+  }
+
+  // Pops the next value from the queue. Blocks until a value is available.
+  T Pop() {
+    T t;
+    CHECK(PopUntil(&t, absl::InfiniteFuture()));
+    return t;
+  }
+
+  // Like Pop, but can timeout. Returns nullptr in this case.
+  T PopWithTimeout(const common::Duration timeout) {
+    T t;
+    if (!PopUntil(&t, absl::Now() + absl::FromChrono(timeout))) {
+      return nullptr;
+    }
+    return t;
+  }
+
+  // Pops the next value into '*t' if the queue is not empty and returns true.
+  // Otherwise, returns false.
+  bool TryPop(T* t) {
+    if (!TryPopWithoutNotify(t)) {
+      return false;
+    }
+    Notify(&not_full_);
+    return true;
+  }
+
+  // Returns the number of items currently in the queue. Only a snapshot if
+  // other threads push or pop concurrently.
+  size_t Size() const {
+    const size_t dequeue_position =
+        dequeue_position_.load(std::memory_order_acquire);
+    const size_t enqueue_position =
+        enqueue_position_.load(std::memory_order_acquire);
+    return enqueue_position > dequeue_position
+               ? enqueue_position - dequeue_position
+               : 0;
+  }
+
+  // Blocks until the queue is empty.
+  void WaitUntilEmpty() {
+    // Every pop notifies 'not_full_', so we can wait on it for emptiness.
+    CHECK(Await([this]() { return Size() == 0; }, &not_full_,
+                absl::InfiniteFuture()));
+  }
+
+ private:
+  // Number of attempts before a waiting thread yields, and before it parks.
+  static constexpr int kNumBusySpins = 64;
+  static constexpr int kNumSpins = 128;
+  static constexpr size_t kCacheLineSize = 64;
+
+  // For the value at position 'p', 'sequence' is 2 * p while the cell is free
+  // and 2 * p + 1 once it holds the value. Doubling keeps the states distinct
+  // even for a queue size of one.
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+  // Threads parked until the queue is not empty, respectively not full.
+  struct Waiters {
+    std::atomic<int> num_parked{0};
+    absl::Mutex mutex;
+    absl::CondVar condition;
+  };
+
+  bool PushUntil(T* t, const absl::Time deadline) {
+    if (!Await([this, t]() { return TryPushWithoutNotify(t); }, &not_full_,
+               deadline)) {
+      return false;
+    }
+    Notify(&not_empty_);
+    return true;
+  }
+
+  bool PopUntil(T* t, const absl::Time deadline) {
+    if (!Await([this, t]() { return TryPopWithoutNotify(t); }, &not_empty_,
+               deadline)) {
+      return false;
+    }
+    Notify(&not_full_);
+    return true;
+  }
+
+  bool TryPushWithoutNotify(T* t) {
+    size_t position = enqueue_position_.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+      cell = &cells_[position % queue_size_];
+      const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      const intptr_t difference = static_cast<intptr_t>(sequence) -
+                                  static_cast<intptr_t>(2 * position);
+      if (difference == 0) {
+        if (enqueue_position_.compare_exchange_weak(
+                position, position + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (difference < 0) {
+        // The cell still holds the value from one round ago: queue is full.
+        return false;
+      } else {
+        position = enqueue_position_.load(std::memory_order_relaxed);
+      }
+    }
+    cell->value = std::move(*t);
+    cell->sequence.store(2 * position + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool TryPopWithoutNotify(T* t) {
+    size_t position = dequeue_position_.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+      cell = &cells_[position % queue_size_];
+      const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      const intptr_t difference = static_cast<intptr_t>(sequence) -
+                                  static_cast<intptr_t>(2 * position + 1);
+      if (difference == 0) {
+        if (dequeue_position_.compare_exchange_weak(
+                position, position + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (difference < 0) {
+        // The cell has not been written in this round: queue is empty.
+        return false;
+      } else {
+        position = dequeue_position_.load(std::memory_order_relaxed);
+      }
+    }
+    *t = std::move(cell->value);
+    cell->sequence.store(2 * (position + queue_size_),
+                         std::memory_order_release);
+    return true;
+  }
+
+  // Retries 'operation' until it succeeds or 'deadline' is reached. Returns
+  // whether it succeeded.
+  template <typename Operation>
+  static bool Await(const Operation& operation, Waiters* const waiters,
+                    const absl::Time deadline) {
+    for (int i = 0; i < kNumSpins; ++i) {
+      if (operation()) {
+        return true;
+      }
+      if (i >= kNumBusySpins) {
+        std::this_thread::yield();
+      }
+    }
+    absl::MutexLock lock(&waiters->mutex);
+    // Announce that we are about to park before retrying, so that a thread
+    // changing the queue after our last attempt is guaranteed to see us in
+    // 'Notify' and signal us once we wait.
+    waiters->num_parked.fetch_add(1, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    bool success = operation();
+    while (!success) {
+      const bool timed_out =
+          waiters->condition.WaitWithDeadline(&waiters->mutex, deadline);
+      success = operation();
+      if (timed_out) {
+        break;
+      }
+    }
+    waiters->num_parked.fetch_sub(1, std::memory_order_relaxed);
+    return success;
+  }
+
+  // Wakes up all threads parked on 'waiters'. Cheap if there are none.
+  static void Notify(Waiters* const waiters) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters->num_parked.load(std::memory_order_relaxed) > 0) {
+      absl::MutexLock lock(&waiters->mutex);
+      waiters->condition.SignalAll();
+    }
+  }
+
+  const size_t queue_size_;
+  const std::unique_ptr<Cell[]> cells_;
+  // Padded so that producers and consumers update separate cache lines.
+  char padding0_[kCacheLineSize];
+  std::atomic<size_t> enqueue_position_;
+  char padding1_[kCacheLineSize - sizeof(std::atomic<size_t>)];
+  std::atomic<size_t> dequeue_position_;
+  char padding2_[kCacheLineSize - sizeof(std::atomic<size_t>)];
+  Waiters not_empty_;
+  Waiters not_full_;
+};
+
+}  // namespace common
+}  // namespace cartographer
+
+#endif  // CARTOGRAPHER_COMMON_INTERNAL_LOCK_FREE_BLOCKING_QUEUE_H_
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cartographer/common/internal/lock_free_blocking_queue.h"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "cartographer/common/time.h"
+#include "gtest/gtest.h"
+
+namespace cartographer {
+namespace common {
+namespace {
+
+TEST(LockFreeBlockingQueueTest, testPushPop) {
+  LockFreeBlockingQueue<std::unique_ptr<int>> blocking_queue(2);
+  blocking_queue.Push(absl::make_unique<int>(42));
+  ASSERT_EQ(1, blocking_queue.Size());
+  blocking_queue.Push(absl::make_unique<int>(24));
+  ASSERT_EQ(2, blocking_queue.Size());
+  EXPECT_EQ(42, *blocking_queue.Pop());
+  ASSERT_EQ(1, blocking_queue.Size());
+  EXPECT_EQ(24, *blocking_queue.Pop());
+  ASSERT_EQ(0, blocking_queue.Size());
+}
+
+TEST(LockFreeBlockingQueueTest, testTryPushTryPop) {
+  LockFreeBlockingQueue<std::unique_ptr<int>> blocking_queue(1);
+  auto value = absl::make_unique<int>(42);
+  EXPECT_TRUE(blocking_queue.TryPush(&value));
+  EXPECT_EQ(nullptr, value);
+  value = absl::make_unique<int>(15);
+  EXPECT_FALSE(blocking_queue.TryPush(&value));
+  ASSERT_NE(nullptr, value);
+  EXPECT_EQ(15, *value);
+  std::unique_ptr<int> popped;
+  EXPECT_TRUE(blocking_queue.TryPop(&popped));
+  EXPECT_EQ(42, *popped);
+  EXPECT_FALSE(blocking_queue.TryPop(&popped));
+}
+
+TEST(LockFreeBlockingQueueTest, testPopWithTimeout) {
+  LockFreeBlockingQueue<std::unique_ptr<int>> blocking_queue(1);
+  EXPECT_EQ(nullptr,
+            blocking_queue.PopWithTimeout(common::FromMilliseconds(150)));
+}
+
+TEST(LockFreeBlockingQueueTest, testPushWithTimeout) {
+  LockFreeBlockingQueue<std::unique_ptr<int>> blocking_queue(1);
+  EXPECT_EQ(true,
+            blocking_queue.PushWithTimeout(absl::make_unique<int>(42),
+                                           common::FromMilliseconds(150)));
+  EXPECT_EQ(false,
+            blocking_queue.PushWithTimeout(absl::make_unique<int>(15),
+                                           common::FromMilliseconds(150)));
+  EXPECT_EQ(42, *blocking_queue.Pop());
+  EXPECT_EQ(0, blocking_queue.Size());
+}
+
+TEST(LockFreeBlockingQueueTest, testBlockingPop) {
+  LockFreeBlockingQueue<std::unique_ptr<int>> blocking_queue(1);
+  ASSERT_EQ(0, blocking_queue.Size());
+
+  int pop = 0;
+
+  std::thread thread([&blocking_queue, &pop] { pop = *blocking_queue.Pop(); });
+
+  std::this_thread::sleep_for(common::FromMilliseconds(100));
+  blocking_queue.Push(absl::make_unique<int>(42));
+  thread.join();
+  ASSERT_EQ(0, blocking_queue.Size());
+  EXPECT_EQ(42, pop);
+}
+
+TEST(LockFreeBlockingQueueTest, testBlockingPush) {
+  LockFreeBlockingQueue<std::unique_ptr<int>> blocking_queue(1);
+  blocking_queue.Push(absl::make_unique<int>(42));
+
+  std::thread thread(
+      [&blocking_queue] { blocking_queue.Push(absl::make_unique<int>(24)); });
+
+  std::this_thread::sleep_for(common::FromMilliseconds(100));
+  EXPECT_EQ(42, *blocking_queue.Pop());
+  thread.join();
+  EXPECT_EQ(24, *blocking_queue.Pop());
+  blocking_queue.WaitUntilEmpty();
+}
+
+TEST(LockFreeBlockingQueueTest, testMultipleProducersAndConsumers) {
+  constexpr int kNumProducers = 4;
+  constexpr int kNumConsumers = 4;
+  constexpr int kNumValuesPerProducer = 10000;
+  LockFreeBlockingQueue<std::unique_ptr<int>> blocking_queue(16);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumProducers; ++i) {
+    threads.emplace_back([&blocking_queue]() {
+      for (int j = 1; j <= kNumValuesPerProducer; ++j) {
+        blocking_queue.Push(absl::make_unique<int>(j));
+      }
+    });
+  }
+  std::vector<int64> sums(kNumConsumers, 0);
+  for (int i = 0; i < kNumConsumers; ++i) {
+    threads.emplace_back([&blocking_queue, &sums, i]() {
+      for (int j = 0; j < kNumProducers * kNumValuesPerProducer / kNumConsumers;
+           ++j) {
+        sums[i] += *blocking_queue.Pop();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  int64 total = 0;
+  for (const int64 sum : sums) {
+    total += sum;
+  }
+  EXPECT_EQ(int64{kNumProducers} * kNumValuesPerProducer *
+                (kNumValuesPerProducer + 1) / 2,
+            total);
+  EXPECT_EQ(0, blocking_queue.Size());
+}
+
+}  // namespace
+}  // namespace common
+}  // namespace cartographer
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CARTOGRAPHER_COMMON_PARALLEL_FOR_H_
+#define CARTOGRAPHER_COMMON_PARALLEL_FOR_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "cartographer/common/task.h"
+#include "cartographer/common/thread_pool.h"
+#include "glog/logging.h"
+
+namespace cartographer {
+namespace common {
+
+// Splits [0, 'size') into at most 'num_threads' contiguous batches and calls
+// 'function(begin, end)' for each of them, all but the first one on a new
+// thread. Returns once all batches are done. Batches are ordered, i.e. batch i
+// covers smaller indices than batch i + 1, so results written per index need
+// no synchronization.
+template <typename FunctionType>
+void ParallelFor(const size_t size, const int num_threads,
+                 const FunctionType& function) {
+  CHECK_GT(num_threads, 0);
+  const size_t num_batches =
+      std::max<size_t>(1, std::min<size_t>(num_threads, size));
+  std::vector<std::thread> threads;
+  for (size_t batch = 1; batch < num_batches; ++batch) {
+    threads.emplace_back([&function, size, num_batches, batch]() {
+      function(size * batch / num_batches, size * (batch + 1) / num_batches);
+    });
+  }
+  function(0, size / num_batches);
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+// Same as above, but all batches except the first one are scheduled on
+// 'thread_pool' instead of on new threads. Use this in code which runs often,
+// e.g. once per range data, so that threads are not started on every call.
+// Must not be called from a task running on 'thread_pool'.
+template <typename FunctionType>
+void ParallelFor(ThreadPoolInterface* const thread_pool, const size_t size,
+                 const int num_batches, const FunctionType& function) {
+  CHECK(thread_pool != nullptr);
+  CHECK_GT(num_batches, 0);
+  const size_t num_used_batches =
+      std::max<size_t>(1, std::min<size_t>(num_batches, size));
+  absl::BlockingCounter pending_batches(num_used_batches - 1);
+  for (size_t batch = 1; batch < num_used_batches; ++batch) {
+    auto task = absl::make_unique<Task>();
+    task->SetWorkItem([&function, &pending_batches, size, num_used_batches,
+                       batch]() {
+      function(size * batch / num_used_batches,
+               size * (batch + 1) / num_used_batches);
+      pending_batches.DecrementCount();
+    });
+    thread_pool->Schedule(std::move(task));
+  }
+  function(0, size / num_used_batches);
+  pending_batches.Wait();
+}
+
+}  // namespace common
+}  // namespace cartographer
+
+#endif  // CARTOGRAPHER_COMMON_PARALLEL_FOR_H_
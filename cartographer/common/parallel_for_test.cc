@@ -0,0 +1,65 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cartographer/common/parallel_for.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace cartographer {
+namespace common {
+namespace {
+
+TEST(ParallelForTest, VisitsEachIndexOnce) {
+  for (const int num_threads : {1, 3, 8}) {
+    for (const size_t size : {0, 1, 2, 7, 100}) {
+      std::vector<int> visits(size, 0);
+      ParallelFor(size, num_threads, [&visits](size_t begin, size_t end) {
+        EXPECT_LE(begin, end);
+        for (size_t i = begin; i < end; ++i) {
+          ++visits[i];
+        }
+      });
+      for (const int num_visits : visits) {
+        EXPECT_EQ(num_visits, 1);
+      }
+    }
+  }
+}
+
+TEST(ParallelForTest, VisitsEachIndexOnceOnThreadPool) {
+  ThreadPool thread_pool(2);
+  for (const int num_batches : {1, 3, 8}) {
+    for (const size_t size : {0, 1, 2, 7, 100}) {
+      std::vector<int> visits(size, 0);
+      ParallelFor(&thread_pool, size, num_batches,
+                  [&visits](size_t begin, size_t end) {
+                    EXPECT_LE(begin, end);
+                    for (size_t i = begin; i < end; ++i) {
+                      ++visits[i];
+                    }
+                  });
+      for (const int num_visits : visits) {
+        EXPECT_EQ(num_visits, 1);
+      }
+    }
+  }
+}
+
+}  // namespace
+}  // namespace common
+}  // namespace cartographer
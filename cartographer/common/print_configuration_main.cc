@@ -21,6 +21,7 @@
 #include "absl/strings/str_split.h"
 #include "cartographer/common/configuration_file_resolver.h"
 #include "cartographer/common/lua_parameter_dictionary.h"
+#include "cartographer/mapping/map_builder_interface.h"
 #include "gflags/gflags.h"
 #include "glog/logging.h"
 
@@ -34,6 +35,11 @@ DEFINE_string(configuration_basename, "",
 DEFINE_string(subdictionary, "",
               "Only print a subdictionary referenced by its Lua ID, e.g.: "
               "'--subdictionary trajectory_builder.trajectory_builder_3d'");
+DEFINE_string(configuration_cache_filename, "",
+              "If given, the 'map_builder' and 'trajectory_builder' entries are "
+              "compiled into options protos which are printed instead. They "
+              "are cached in this file and reused as long as none of the "
+              "included Lua files changed.");
 
 namespace cartographer {
 namespace common {
@@ -77,6 +83,8 @@ int main(int argc, char** argv) {
       "Resolves and compiles a Lua configuration and prints it to stdout.\n"
       "The output can be restricted to a subdictionary using the optional "
       "'--subdictionary' parameter, which can be given in Lua syntax.\n"
+      "With '--configuration_cache_filename', the compiled options protos are "
+      "printed and cached instead.\n"
       "The logs of the configuration file resolver are written to stderr if "
       "'--logtostderr' is given.");
   google::ParseCommandLineFlags(&argc, &argv, true);
@@ -90,6 +98,14 @@ int main(int argc, char** argv) {
   const std::vector<std::string> configuration_directories =
       absl::StrSplit(FLAGS_configuration_directories, ',', absl::SkipEmpty());
 
+  if (!FLAGS_configuration_cache_filename.empty()) {
+    std::cout << ::cartographer::mapping::LoadCompiledConfiguration(
+                     configuration_directories, FLAGS_configuration_basename,
+                     FLAGS_configuration_cache_filename)
+                     .DebugString();
+    return EXIT_SUCCESS;
+  }
+
   auto lua_dictionary = ::cartographer::common::LoadLuaDictionary(
       configuration_directories, FLAGS_configuration_basename);
 
@@ -26,10 +26,11 @@ namespace ground_truth {
 // Generates GroundTruth proto from the given pose graph using the specified
 // criteria parameters. See
 // 'https://google-cartographer.readthedocs.io/en/latest/evaluation.html' for
-// more details.
+// more details. The constraints are evaluated using 'num_threads'.
 proto::GroundTruth GenerateGroundTruth(
     const mapping::proto::PoseGraph& pose_graph, double min_covered_distance,
-    double outlier_threshold_meters, double outlier_threshold_radians);
+    double outlier_threshold_meters, double outlier_threshold_radians,
+    int num_threads);
 
 }  // namespace ground_truth
 }  // namespace cartographer
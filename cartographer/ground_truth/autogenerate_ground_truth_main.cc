@@ -14,11 +14,14 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <fstream>
 #include <string>
 
 #include "cartographer/common/port.h"
+#include "cartographer/common/time.h"
 #include "cartographer/ground_truth/autogenerate_ground_truth.h"
 #include "cartographer/ground_truth/proto/relations.pb.h"
 #include "cartographer/io/proto_stream.h"
@@ -41,6 +44,8 @@ DEFINE_double(outlier_threshold_meters, 0.15,
 DEFINE_double(outlier_threshold_radians, 0.02,
               "Distance in radians beyond which constraints are considered "
               "outliers.");
+DEFINE_int32(num_threads, 1,
+             "Number of threads used to evaluate the constraints.");
 
 namespace cartographer {
 namespace ground_truth {
@@ -49,15 +54,22 @@ namespace {
 void Run(const std::string& pose_graph_filename,
          const std::string& output_filename, const double min_covered_distance,
          const double outlier_threshold_meters,
-         const double outlier_threshold_radians) {
+         const double outlier_threshold_radians, const int num_threads) {
   LOG(INFO) << "Reading pose graph from '" << pose_graph_filename << "'...";
   mapping::proto::PoseGraph pose_graph =
       io::DeserializePoseGraphFromFile(pose_graph_filename);
 
   LOG(INFO) << "Autogenerating ground truth relations...";
-  const proto::GroundTruth ground_truth =
-      GenerateGroundTruth(pose_graph, min_covered_distance,
-                          outlier_threshold_meters, outlier_threshold_radians);
+  const auto start = std::chrono::steady_clock::now();
+  const proto::GroundTruth ground_truth = GenerateGroundTruth(
+      pose_graph, min_covered_distance, outlier_threshold_meters,
+      outlier_threshold_radians, num_threads);
+  const double elapsed_seconds =
+      common::ToSeconds(std::chrono::steady_clock::now() - start);
+  LOG(INFO) << "Evaluated " << pose_graph.constraint_size()
+            << " constraints in " << elapsed_seconds << " s ("
+            << pose_graph.constraint_size() / std::max(elapsed_seconds, 1e-9)
+            << " constraints/s) using " << num_threads << " threads.";
   LOG(INFO) << "Writing " << ground_truth.relation_size() << " relations to '"
             << output_filename << "'.";
   {
@@ -95,8 +107,9 @@ int main(int argc, char** argv) {
     google::ShowUsageWithFlagsRestrict(argv[0], "autogenerate_ground_truth");
     return EXIT_FAILURE;
   }
+  CHECK_GT(FLAGS_num_threads, 0);
   ::cartographer::ground_truth::Run(
       FLAGS_pose_graph_filename, FLAGS_output_filename,
       FLAGS_min_covered_distance, FLAGS_outlier_threshold_meters,
-      FLAGS_outlier_threshold_radians);
+      FLAGS_outlier_threshold_radians, FLAGS_num_threads);
 }
@@ -15,17 +15,21 @@
  */
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <numeric>
 #include <sstream>
 #include <string>
 #include <vector>
 
 #include "cartographer/common/math.h"
 #include "cartographer/common/port.h"
+#include "cartographer/common/time.h"
 #include "cartographer/ground_truth/proto/relations.pb.h"
+#include "cartographer/ground_truth/relations_metrics.h"
 #include "cartographer/ground_truth/relations_text_file.h"
 #include "cartographer/io/proto_stream.h"
 #include "cartographer/io/proto_stream_deserializer.h"
@@ -47,30 +51,13 @@ DEFINE_bool(read_text_file_with_unix_timestamps, false,
 DEFINE_bool(write_relation_metrics, false,
             "Enable exporting relation metrics as comma-separated values to "
             "[pose_graph_filename].relation_metrics.csv");
+DEFINE_int32(num_threads, 1,
+             "Number of threads used to look up poses and compute errors.");
 
 namespace cartographer {
 namespace ground_truth {
 namespace {
 
-struct Error {
-  double translational_squared;
-  double rotational_squared;
-};
-
-// TODO(whess): This gives different results for the translational error if
-// 'pose1' and 'pose2' are swapped and 'expected' is inverted. Consider a
-// different way to compute translational error. Maybe just look at the
-// absolute difference in translation norms of each relative transform as a
-// lower bound of the translational error.
-Error ComputeError(const transform::Rigid3d& pose1,
-                   const transform::Rigid3d& pose2,
-                   const transform::Rigid3d& expected) {
-  const transform::Rigid3d error =
-      (pose1.inverse() * pose2) * expected.inverse();
-  return Error{error.translation().squaredNorm(),
-               common::Pow2(transform::GetAngle(error))};
-}
-
 std::string MeanAndStdDevString(const std::vector<double>& values) {
   CHECK_GE(values.size(), 2);
   const double mean =
@@ -87,12 +74,12 @@ std::string MeanAndStdDevString(const std::vector<double>& values) {
   return std::string(out.str());
 }
 
-std::string StatisticsString(const std::vector<Error>& errors) {
+std::string StatisticsString(const std::vector<RelationError>& errors) {
   std::vector<double> translational_errors;
   std::vector<double> squared_translational_errors;
   std::vector<double> rotational_errors_degrees;
   std::vector<double> squared_rotational_errors_degrees;
-  for (const Error& error : errors) {
+  for (const RelationError& error : errors) {
     translational_errors.push_back(std::sqrt(error.translational_squared));
     squared_translational_errors.push_back(error.translational_squared);
     rotational_errors_degrees.push_back(
@@ -113,7 +100,7 @@ std::string StatisticsString(const std::vector<Error>& errors) {
          MeanAndStdDevString(squared_rotational_errors_degrees) + " deg^2\n";
 }
 
-void WriteRelationMetricsToFile(const std::vector<Error>& errors,
+void WriteRelationMetricsToFile(const std::vector<RelationError>& errors,
                                 const proto::GroundTruth& ground_truth,
                                 const std::string& relation_metrics_filename) {
   std::ofstream relation_errors_file;
@@ -129,7 +116,7 @@ void WriteRelationMetricsToFile(const std::vector<Error>& errors,
          "expected_rotation_y,expected_rotation_z,covered_distance\n";
   for (int relation_index = 0; relation_index < ground_truth.relation_size();
        ++relation_index) {
-    const Error& error = errors[relation_index];
+    const RelationError& error = errors[relation_index];
     const proto::Relation& relation = ground_truth.relation(relation_index);
     double translational_error = std::sqrt(error.translational_squared);
     double squared_translational_error = error.translational_squared;
@@ -153,25 +140,10 @@ void WriteRelationMetricsToFile(const std::vector<Error>& errors,
   relation_errors_file.close();
 }
 
-transform::Rigid3d LookupTransform(
-    const transform::TransformInterpolationBuffer&
-        transform_interpolation_buffer,
-    const common::Time time) {
-  const common::Time earliest_time =
-      transform_interpolation_buffer.earliest_time();
-  if (transform_interpolation_buffer.Has(time)) {
-    return transform_interpolation_buffer.Lookup(time);
-  } else if (time < earliest_time) {
-    return transform_interpolation_buffer.Lookup(earliest_time);
-  }
-  return transform_interpolation_buffer.Lookup(
-      transform_interpolation_buffer.latest_time());
-}
-
 void Run(const std::string& pose_graph_filename,
          const std::string& relations_filename,
          const bool read_text_file_with_unix_timestamps,
-         const bool write_relation_metrics) {
+         const bool write_relation_metrics, const int num_threads) {
   LOG(INFO) << "Reading pose graph from '" << pose_graph_filename << "'...";
   mapping::proto::PoseGraph pose_graph =
       io::DeserializePoseGraphFromFile(pose_graph_filename);
@@ -190,18 +162,15 @@ void Run(const std::string& pose_graph_filename,
     CHECK(ground_truth.ParseFromIstream(&ground_truth_stream));
   }
 
-  std::vector<Error> errors;
-  for (const auto& relation : ground_truth.relation()) {
-    const auto pose1 =
-        LookupTransform(transform_interpolation_buffer,
-                        common::FromUniversal(relation.timestamp1()));
-    const auto pose2 =
-        LookupTransform(transform_interpolation_buffer,
-                        common::FromUniversal(relation.timestamp2()));
-    const transform::Rigid3d expected =
-        transform::ToRigid3(relation.expected());
-    errors.push_back(ComputeError(pose1, pose2, expected));
-  }
+  const auto start = std::chrono::steady_clock::now();
+  const std::vector<RelationError> errors = ComputeRelationErrors(
+      transform_interpolation_buffer, ground_truth, num_threads);
+  const double elapsed_seconds =
+      common::ToSeconds(std::chrono::steady_clock::now() - start);
+  LOG(INFO) << "Evaluated " << errors.size() << " relations in "
+            << elapsed_seconds << " s ("
+            << errors.size() / std::max(elapsed_seconds, 1e-9)
+            << " relations/s) using " << num_threads << " threads.";
 
   const std::string relation_metrics_filename =
       pose_graph_filename + ".relation_metrics.csv";
@@ -231,8 +200,10 @@ int main(int argc, char** argv) {
     google::ShowUsageWithFlagsRestrict(argv[0], "compute_relations_metrics");
     return EXIT_FAILURE;
   }
+  CHECK_GT(FLAGS_num_threads, 0);
 
   ::cartographer::ground_truth::Run(
       FLAGS_pose_graph_filename, FLAGS_relations_filename,
-      FLAGS_read_text_file_with_unix_timestamps, FLAGS_write_relation_metrics);
+      FLAGS_read_text_file_with_unix_timestamps, FLAGS_write_relation_metrics,
+      FLAGS_num_threads);
 }
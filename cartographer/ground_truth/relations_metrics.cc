@@ -0,0 +1,95 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cartographer/ground_truth/relations_metrics.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include "cartographer/common/math.h"
+#include "cartographer/common/parallel_for.h"
+#include "cartographer/transform/transform.h"
+#include "glog/logging.h"
+
+namespace cartographer {
+namespace ground_truth {
+
+RelationError ComputeRelationError(const transform::Rigid3d& pose1,
+                                   const transform::Rigid3d& pose2,
+                                   const transform::Rigid3d& expected) {
+  const transform::Rigid3d error =
+      (pose1.inverse() * pose2) * expected.inverse();
+  return RelationError{error.translation().squaredNorm(),
+                       common::Pow2(transform::GetAngle(error))};
+}
+
+std::vector<transform::Rigid3d> LookupClampedPoses(
+    const transform::TransformInterpolationBuffer&
+        transform_interpolation_buffer,
+    const std::vector<common::Time>& times, const int num_threads) {
+  CHECK(!transform_interpolation_buffer.empty());
+  const common::Time earliest_time =
+      transform_interpolation_buffer.earliest_time();
+  const common::Time latest_time = transform_interpolation_buffer.latest_time();
+  std::vector<size_t> sorted_indices(times.size());
+  std::iota(sorted_indices.begin(), sorted_indices.end(), 0);
+  std::sort(sorted_indices.begin(), sorted_indices.end(),
+            [&times](const size_t lhs, const size_t rhs) {
+              return times[lhs] < times[rhs];
+            });
+
+  std::vector<transform::Rigid3d> poses(times.size());
+  common::ParallelFor(
+      sorted_indices.size(), num_threads,
+      [&](const size_t begin, const size_t end) {
+        transform::TransformInterpolationBuffer::SortedLookupCursor cursor(
+            &transform_interpolation_buffer);
+        for (size_t i = begin; i != end; ++i) {
+          const size_t index = sorted_indices[i];
+          poses[index] = cursor.Lookup(
+              std::min(std::max(times[index], earliest_time), latest_time));
+        }
+      });
+  return poses;
+}
+
+std::vector<RelationError> ComputeRelationErrors(
+    const transform::TransformInterpolationBuffer&
+        transform_interpolation_buffer,
+    const proto::GroundTruth& ground_truth, const int num_threads) {
+  std::vector<common::Time> times;
+  times.reserve(2 * ground_truth.relation_size());
+  for (const proto::Relation& relation : ground_truth.relation()) {
+    times.push_back(common::FromUniversal(relation.timestamp1()));
+    times.push_back(common::FromUniversal(relation.timestamp2()));
+  }
+  const std::vector<transform::Rigid3d> poses =
+      LookupClampedPoses(transform_interpolation_buffer, times, num_threads);
+
+  std::vector<RelationError> errors(ground_truth.relation_size());
+  common::ParallelFor(
+      errors.size(), num_threads, [&](const size_t begin, const size_t end) {
+        for (size_t i = begin; i != end; ++i) {
+          errors[i] = ComputeRelationError(
+              poses[2 * i], poses[2 * i + 1],
+              transform::ToRigid3(ground_truth.relation(i).expected()));
+        }
+      });
+  return errors;
+}
+
+}  // namespace ground_truth
+}  // namespace cartographer
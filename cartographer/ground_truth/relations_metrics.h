@@ -0,0 +1,65 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CARTOGRAPHER_GROUND_TRUTH_RELATIONS_METRICS_H_
+#define CARTOGRAPHER_GROUND_TRUTH_RELATIONS_METRICS_H_
+
+#include <vector>
+
+#include "cartographer/common/time.h"
+#include "cartographer/ground_truth/proto/relations.pb.h"
+#include "cartographer/transform/rigid_transform.h"
+#include "cartographer/transform/transform_interpolation_buffer.h"
+
+namespace cartographer {
+namespace ground_truth {
+
+struct RelationError {
+  double translational_squared;
+  double rotational_squared;
+};
+
+// Computes the error of the relative transform from 'pose1' to 'pose2' with
+// respect to the 'expected' one.
+//
+// TODO(whess): This gives different results for the translational error if
+// 'pose1' and 'pose2' are swapped and 'expected' is inverted. Consider a
+// different way to compute translational error. Maybe just look at the
+// absolute difference in translation norms of each relative transform as a
+// lower bound of the translational error.
+RelationError ComputeRelationError(const transform::Rigid3d& pose1,
+                                   const transform::Rigid3d& pose2,
+                                   const transform::Rigid3d& expected);
+
+// Returns the interpolated poses at 'times', which do not need to be sorted.
+// Times before or after the buffer are clamped to its first or last pose. The
+// lookups are done in time order, split across 'num_threads'.
+std::vector<transform::Rigid3d> LookupClampedPoses(
+    const transform::TransformInterpolationBuffer&
+        transform_interpolation_buffer,
+    const std::vector<common::Time>& times, int num_threads);
+
+// Returns the error of each relation in 'ground_truth' for the trajectory in
+// 'transform_interpolation_buffer', computed using 'num_threads'.
+std::vector<RelationError> ComputeRelationErrors(
+    const transform::TransformInterpolationBuffer&
+        transform_interpolation_buffer,
+    const proto::GroundTruth& ground_truth, int num_threads);
+
+}  // namespace ground_truth
+}  // namespace cartographer
+
+#endif  // CARTOGRAPHER_GROUND_TRUTH_RELATIONS_METRICS_H_
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cartographer/ground_truth/relations_metrics.h"
+
+#include <random>
+#include <vector>
+
+#include "cartographer/transform/transform.h"
+#include "gtest/gtest.h"
+
+namespace cartographer {
+namespace ground_truth {
+namespace {
+
+class RelationsMetricsTest : public ::testing::Test {
+ protected:
+  RelationsMetricsTest() {
+    for (int i = 0; i < 100; ++i) {
+      buffer_.Push(common::FromUniversal(1000 + 10 * i),
+                   transform::Rigid3d(
+                       Eigen::Vector3d(0.1 * i, std::sin(0.1 * i), 0.),
+                       transform::RollPitchYaw(0., 0., 0.05 * i)));
+    }
+  }
+
+  // Returns the pose at 'time' clamped to the buffer using 'Lookup'.
+  transform::Rigid3d LookupClampedPose(const common::Time time) const {
+    if (time < buffer_.earliest_time()) {
+      return buffer_.Lookup(buffer_.earliest_time());
+    }
+    if (time > buffer_.latest_time()) {
+      return buffer_.Lookup(buffer_.latest_time());
+    }
+    return buffer_.Lookup(time);
+  }
+
+  transform::TransformInterpolationBuffer buffer_;
+};
+
+TEST_F(RelationsMetricsTest, LookupClampedPosesMatchesLookup) {
+  std::mt19937 prng(42);
+  std::uniform_int_distribution<int64> distribution(900, 2100);
+  std::vector<common::Time> times;
+  for (int i = 0; i < 500; ++i) {
+    times.push_back(common::FromUniversal(distribution(prng)));
+  }
+  for (const int num_threads : {1, 4}) {
+    const std::vector<transform::Rigid3d> poses =
+        LookupClampedPoses(buffer_, times, num_threads);
+    ASSERT_EQ(poses.size(), times.size());
+    for (size_t i = 0; i < times.size(); ++i) {
+      const transform::Rigid3d expected = LookupClampedPose(times[i]);
+      EXPECT_NEAR((poses[i].translation() - expected.translation()).norm(), 0.,
+                  1e-9);
+      EXPECT_NEAR(poses[i].rotation().angularDistance(expected.rotation()), 0.,
+                  1e-9);
+    }
+  }
+}
+
+TEST_F(RelationsMetricsTest, ComputeRelationErrors) {
+  std::mt19937 prng(42);
+  std::uniform_int_distribution<int64> distribution(1000, 1990);
+  proto::GroundTruth ground_truth;
+  for (int i = 0; i < 200; ++i) {
+    proto::Relation* const relation = ground_truth.add_relation();
+    relation->set_timestamp1(distribution(prng));
+    relation->set_timestamp2(distribution(prng));
+    *relation->mutable_expected() = transform::ToProto(
+        transform::Rigid3d(Eigen::Vector3d(0.01 * i, 0., 0.),
+                           transform::RollPitchYaw(0., 0., 0.01 * i)));
+  }
+  const std::vector<RelationError> errors =
+      ComputeRelationErrors(buffer_, ground_truth, 3);
+  ASSERT_EQ(errors.size(), ground_truth.relation_size());
+  for (int i = 0; i < ground_truth.relation_size(); ++i) {
+    const proto::Relation& relation = ground_truth.relation(i);
+    const RelationError expected = ComputeRelationError(
+        LookupClampedPose(common::FromUniversal(relation.timestamp1())),
+        LookupClampedPose(common::FromUniversal(relation.timestamp2())),
+        transform::ToRigid3(relation.expected()));
+    EXPECT_NEAR(errors[i].translational_squared,
+                expected.translational_squared, 1e-9);
+    EXPECT_NEAR(errors[i].rotational_squared, expected.rotational_squared,
+                1e-9);
+  }
+}
+
+}  // namespace
+}  // namespace ground_truth
+}  // namespace cartographer
@@ -40,23 +40,36 @@ common::Time UnixToCommonTime(double unix_time) {
 proto::GroundTruth ReadRelationsTextFile(
     const std::string& relations_filename) {
   proto::GroundTruth ground_truth;
-  std::ifstream relations_stream(relations_filename.c_str());
-  double unix_time_1, unix_time_2, x, y, z, roll, pitch, yaw;
-  while (relations_stream >> unix_time_1 >> unix_time_2 >> x >> y >> z >>
-         roll >> pitch >> yaw) {
-    const common::Time common_time_1 = UnixToCommonTime(unix_time_1);
-    const common::Time common_time_2 = UnixToCommonTime(unix_time_2);
-    const transform::Rigid3d expected =
-        transform::Rigid3d(transform::Rigid3d::Vector(x, y, z),
-                           transform::RollPitchYaw(roll, pitch, yaw));
-    auto* const new_relation = ground_truth.add_relation();
-    new_relation->set_timestamp1(common::ToUniversal(common_time_1));
-    new_relation->set_timestamp2(common::ToUniversal(common_time_2));
-    *new_relation->mutable_expected() = transform::ToProto(expected);
+  RelationsTextFileReader reader(relations_filename);
+  proto::Relation relation;
+  while (reader.ReadNext(&relation)) {
+    *ground_truth.add_relation() = relation;
   }
-  CHECK(relations_stream.eof());
   return ground_truth;
 }
 
+RelationsTextFileReader::RelationsTextFileReader(
+    const std::string& relations_filename)
+    : relations_stream_(relations_filename.c_str()) {}
+
+bool RelationsTextFileReader::ReadNext(proto::Relation* const relation) {
+  double unix_time_1, unix_time_2, x, y, z, roll, pitch, yaw;
+  if (!(relations_stream_ >> unix_time_1 >> unix_time_2 >> x >> y >> z >>
+        roll >> pitch >> yaw)) {
+    CHECK(relations_stream_.eof());
+    return false;
+  }
+  const common::Time common_time_1 = UnixToCommonTime(unix_time_1);
+  const common::Time common_time_2 = UnixToCommonTime(unix_time_2);
+  const transform::Rigid3d expected =
+      transform::Rigid3d(transform::Rigid3d::Vector(x, y, z),
+                         transform::RollPitchYaw(roll, pitch, yaw));
+  relation->Clear();
+  relation->set_timestamp1(common::ToUniversal(common_time_1));
+  relation->set_timestamp2(common::ToUniversal(common_time_2));
+  *relation->mutable_expected() = transform::ToProto(expected);
+  return true;
+}
+
 }  // namespace ground_truth
 }  // namespace cartographer
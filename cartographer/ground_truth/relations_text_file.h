@@ -17,6 +17,7 @@
 #ifndef CARTOGRAPHER_GROUND_TRUTH_RELATIONS_TEXT_FILE_H_
 #define CARTOGRAPHER_GROUND_TRUTH_RELATIONS_TEXT_FILE_H_
 
+#include <fstream>
 #include <string>
 
 #include "cartographer/common/port.h"
@@ -35,6 +36,23 @@ namespace ground_truth {
 // Robots, vol. 27, no. 4, pp. 387–407, 2009.
 proto::GroundTruth ReadRelationsTextFile(const std::string& relations_filename);
 
+// Reads the relations of a text file as above one at a time, so that they can
+// be processed without holding the whole file in memory.
+class RelationsTextFileReader {
+ public:
+  explicit RelationsTextFileReader(const std::string& relations_filename);
+
+  RelationsTextFileReader(const RelationsTextFileReader&) = delete;
+  RelationsTextFileReader& operator=(const RelationsTextFileReader&) = delete;
+
+  // Reads the next relation into 'relation'. Returns false once the end of the
+  // file is reached. CHECK()s that the file is well-formed.
+  bool ReadNext(proto::Relation* relation);
+
+ private:
+  std::ifstream relations_stream_;
+};
+
 }  // namespace ground_truth
 }  // namespace cartographer
 
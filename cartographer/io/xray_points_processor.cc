@@ -30,6 +30,7 @@
 #include "cartographer/mapping/3d/hybrid_grid.h"
 #include "cartographer/mapping/detect_floors.h"
 #include "cartographer/transform/transform.h"
+#include "cartographer/transform/transform_points.h"
 
 namespace cartographer {
 namespace io {
@@ -221,10 +222,13 @@ void XRayPointsProcessor::WriteVoxels(const Aggregation& aggregation,
 void XRayPointsProcessor::Insert(const PointsBatch& batch,
                                  Aggregation* const aggregation) {
   constexpr FloatColor kDefaultColor = {{0.f, 0.f, 0.f}};
-  for (size_t i = 0; i < batch.points.size(); ++i) {
-    const sensor::RangefinderPoint camera_point = transform_ * batch.points[i];
+  std::vector<sensor::RangefinderPoint> camera_points(batch.points.size());
+  transform::TransformPointPositions(transform_, batch.points.data(),
+                                     batch.points.size(),
+                                     camera_points.data());
+  for (size_t i = 0; i < camera_points.size(); ++i) {
     const Eigen::Array3i cell_index =
-        aggregation->voxels.GetCellIndex(camera_point.position);
+        aggregation->voxels.GetCellIndex(camera_points[i].position);
     *aggregation->voxels.mutable_value(cell_index) = true;
     bounding_box_.extend(cell_index.matrix());
     ColumnData& column_data =
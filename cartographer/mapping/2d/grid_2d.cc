@@ -82,27 +82,38 @@ Grid2D::Grid2D(const proto::Grid2D& proto,
           max_correspondence_cost_, min_correspondence_cost_,
           max_correspondence_cost_)) {
   CHECK_LT(min_correspondence_cost_, max_correspondence_cost_);
+  correspondence_cost_cells_.reserve(proto.cells_size());
+  for (const auto& cell : proto.cells()) {
+    CHECK_LE(cell, std::numeric_limits<uint16>::max());
+    correspondence_cost_cells_.push_back(cell);
+  }
   if (proto.has_known_cells_box()) {
     const auto& box = proto.known_cells_box();
     known_cells_box_ =
         Eigen::AlignedBox2i(Eigen::Vector2i(box.min_x(), box.min_y()),
                             Eigen::Vector2i(box.max_x(), box.max_y()));
-  }
-  correspondence_cost_cells_.reserve(proto.cells_size());
-  for (const auto& cell : proto.cells()) {
-    CHECK_LE(cell, std::numeric_limits<uint16>::max());
-    correspondence_cost_cells_.push_back(cell);
+  } else {
+    // Older streams do not contain the box. Recover it once here, so that
+    // cropping never has to look at the cells again.
+    for (const Eigen::Array2i& xy_index :
+         XYIndexRangeIterator(limits_.cell_limits())) {
+      if (IsKnown(xy_index)) {
+        known_cells_box_.extend(xy_index.matrix());
+      }
+    }
   }
 }
 
 // Finishes the update sequence.
 void Grid2D::FinishUpdate() {
-  while (!update_indices_.empty()) {
-    DCHECK_GE(correspondence_cost_cells_[update_indices_.back()],
-              kUpdateMarker);
-    correspondence_cost_cells_[update_indices_.back()] -= kUpdateMarker;
-    update_indices_.pop_back();
+  for (const int flat_index : update_indices_) {
+    DCHECK_GE(correspondence_cost_cells_[flat_index], kUpdateMarker);
+    correspondence_cost_cells_[flat_index] -= kUpdateMarker;
   }
+  // The indices are kept for 'last_update_indices()'. Swapping lets the next
+  // update reuse the memory of the previous one.
+  last_update_indices_.swap(update_indices_);
+  update_indices_.clear();
 }
 
 // Fills in 'offset' and 'limits' to define a subregion of that contains all
@@ -157,6 +168,7 @@ void Grid2D::GrowLimits(const Eigen::Vector2f& point,
       *grids[grid_index] = new_cells;
     }
     limits_ = new_limits;
+    last_update_indices_.clear();
     if (!known_cells_box_.isEmpty()) {
       known_cells_box_.translate(Eigen::Vector2i(x_offset, y_offset));
     }
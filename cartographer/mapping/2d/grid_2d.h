@@ -71,6 +71,12 @@ class Grid2D : public GridInterface {
                kUnknownCorrespondenceValue;
   }
 
+  // Returns the indices of the cells changed by the last finished update, as
+  // 'x + num_x_cells * y'. They are cleared when the limits grow.
+  const std::vector<int>& last_update_indices() const {
+    return last_update_indices_;
+  }
+
   // Fills in 'offset' and 'limits' to define a subregion of that contains all
   // known cells.
   void ComputeCroppedLimits(Eigen::Array2i* const offset,
@@ -121,6 +127,7 @@ class Grid2D : public GridInterface {
   float min_correspondence_cost_;
   float max_correspondence_cost_;
   std::vector<int> update_indices_;
+  std::vector<int> last_update_indices_;
 
   // Bounding box of known cells to efficiently compute cropping limits.
   Eigen::AlignedBox2i known_cells_box_;
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cartographer/mapping/2d/probability_grid_pyramid.h"
+
+#include <algorithm>
+
+#include "absl/memory/memory.h"
+#include "cartographer/mapping/2d/xy_index.h"
+#include "cartographer/mapping/probability_values.h"
+#include "glog/logging.h"
+
+namespace cartographer {
+namespace mapping {
+namespace {
+
+// Returns the limits of a grid with twice the cell size of 'limits' covering
+// the same area.
+MapLimits CoarserLimits(const MapLimits& limits) {
+  return MapLimits(2. * limits.resolution(), limits.max(),
+                   CellLimits((limits.cell_limits().num_x_cells + 1) / 2,
+                              (limits.cell_limits().num_y_cells + 1) / 2));
+}
+
+bool HaveSameCells(const MapLimits& lhs, const MapLimits& rhs) {
+  return lhs.resolution() == rhs.resolution() && lhs.max() == rhs.max() &&
+         lhs.cell_limits().num_x_cells == rhs.cell_limits().num_x_cells &&
+         lhs.cell_limits().num_y_cells == rhs.cell_limits().num_y_cells;
+}
+
+// Maps the 'flat_indices' of a grid with 'num_x_cells' columns to the sorted
+// and unique flat indices of the cells containing them one level up.
+std::vector<int> ComputeCoarserFlatIndices(const std::vector<int>& flat_indices,
+                                           const int num_x_cells,
+                                           const int coarser_num_x_cells) {
+  std::vector<int> coarser_flat_indices;
+  coarser_flat_indices.reserve(flat_indices.size());
+  for (const int flat_index : flat_indices) {
+    const int x = flat_index % num_x_cells;
+    const int y = flat_index / num_x_cells;
+    coarser_flat_indices.push_back(x / 2 + coarser_num_x_cells * (y / 2));
+  }
+  std::sort(coarser_flat_indices.begin(), coarser_flat_indices.end());
+  coarser_flat_indices.erase(
+      std::unique(coarser_flat_indices.begin(), coarser_flat_indices.end()),
+      coarser_flat_indices.end());
+  return coarser_flat_indices;
+}
+
+}  // namespace
+
+class ProbabilityGridPyramid::Level : public ProbabilityGrid {
+ public:
+  Level(const MapLimits& limits, ValueConversionTables* conversion_tables)
+      : ProbabilityGrid(limits, conversion_tables) {}
+
+  // Sets the cell at 'cell_index' to the lowest correspondence cost, i.e. the
+  // highest probability, of the known cells of 'finer' it covers.
+  void UpdateCell(const Grid2D& finer, const Eigen::Array2i& cell_index) {
+    bool any_known = false;
+    float min_correspondence_cost = kMaxCorrespondenceCost;
+    for (const Eigen::Array2i& finer_index :
+         XYIndexRangeIterator(2 * cell_index, 2 * cell_index + 1)) {
+      if (!finer.IsKnown(finer_index)) continue;
+      any_known = true;
+      min_correspondence_cost = std::min(
+          min_correspondence_cost, finer.GetCorrespondenceCost(finer_index));
+    }
+    if (!any_known) return;
+    (*mutable_correspondence_cost_cells())[ToFlatIndex(cell_index)] =
+        CorrespondenceCostToValue(min_correspondence_cost);
+    mutable_known_cells_box()->extend(cell_index.matrix());
+  }
+};
+
+ProbabilityGridPyramid::ProbabilityGridPyramid(
+    const ProbabilityGrid& grid, const int num_levels,
+    ValueConversionTables* const conversion_tables)
+    : conversion_tables_(conversion_tables),
+      grid_limits_(grid.limits()),
+      levels_(num_levels) {
+  CHECK_GT(num_levels, 0);
+  Rebuild(grid);
+}
+
+ProbabilityGridPyramid::~ProbabilityGridPyramid() {}
+
+void ProbabilityGridPyramid::Update(const ProbabilityGrid& grid) {
+  if (!HaveSameCells(grid.limits(), grid_limits_)) {
+    Rebuild(grid);
+    return;
+  }
+  std::vector<int> flat_indices = grid.last_update_indices();
+  const Grid2D* finer = &grid;
+  for (const std::unique_ptr<Level>& level : levels_) {
+    const int num_x_cells = level->limits().cell_limits().num_x_cells;
+    flat_indices = ComputeCoarserFlatIndices(
+        flat_indices, finer->limits().cell_limits().num_x_cells, num_x_cells);
+    for (const int flat_index : flat_indices) {
+      level->UpdateCell(*finer, Eigen::Array2i(flat_index % num_x_cells,
+                                               flat_index / num_x_cells));
+    }
+    finer = level.get();
+  }
+}
+
+const ProbabilityGrid& ProbabilityGridPyramid::level(
+    const int level_index) const {
+  return *levels_.at(level_index);
+}
+
+void ProbabilityGridPyramid::Rebuild(const ProbabilityGrid& grid) {
+  grid_limits_ = grid.limits();
+  const Grid2D* finer = &grid;
+  for (std::unique_ptr<Level>& level : levels_) {
+    level = absl::make_unique<Level>(CoarserLimits(finer->limits()),
+                                     conversion_tables_);
+    Eigen::Array2i offset;
+    CellLimits cell_limits;
+    finer->ComputeCroppedLimits(&offset, &cell_limits);
+    const Eigen::Array2i max_index =
+        offset +
+        Eigen::Array2i(cell_limits.num_x_cells, cell_limits.num_y_cells) - 1;
+    for (const Eigen::Array2i& xy_index :
+         XYIndexRangeIterator(offset / 2, max_index / 2)) {
+      level->UpdateCell(*finer, xy_index);
+    }
+    finer = level.get();
+  }
+}
+
+}  // namespace mapping
+}  // namespace cartographer
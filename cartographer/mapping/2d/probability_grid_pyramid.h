@@ -0,0 +1,69 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CARTOGRAPHER_MAPPING_2D_PROBABILITY_GRID_PYRAMID_H_
+#define CARTOGRAPHER_MAPPING_2D_PROBABILITY_GRID_PYRAMID_H_
+
+#include <memory>
+#include <vector>
+
+#include "cartographer/mapping/2d/map_limits.h"
+#include "cartographer/mapping/2d/probability_grid.h"
+#include "cartographer/mapping/value_conversion_tables.h"
+
+namespace cartographer {
+namespace mapping {
+
+// Coarser resolution versions of a ProbabilityGrid. Each level halves the
+// resolution of the one below it, and each of its cells holds the highest
+// probability of the 2x2 cells below it. Matching against the coarse levels
+// first widens the basin of convergence of the Ceres scan matcher.
+class ProbabilityGridPyramid {
+ public:
+  ProbabilityGridPyramid(const ProbabilityGrid& grid, int num_levels,
+                         ValueConversionTables* conversion_tables);
+  ~ProbabilityGridPyramid();
+
+  ProbabilityGridPyramid(const ProbabilityGridPyramid&) = delete;
+  ProbabilityGridPyramid& operator=(const ProbabilityGridPyramid&) = delete;
+
+  // Brings the pyramid up to date after an update of 'grid'. Only the cells
+  // covering 'grid.last_update_indices()' are recomputed, unless the limits of
+  // 'grid' grew, in which case all levels are rebuilt. Cells set through
+  // ProbabilityGrid::SetProbability() are only picked up by a rebuild.
+  void Update(const ProbabilityGrid& grid);
+
+  int num_levels() const { return levels_.size(); }
+
+  // Returns the level with 2^('level_index' + 1) times the cell size of the
+  // grid, i.e. 0 is the finest level.
+  const ProbabilityGrid& level(int level_index) const;
+
+ private:
+  class Level;
+
+  void Rebuild(const ProbabilityGrid& grid);
+
+  ValueConversionTables* const conversion_tables_;
+  // The limits of the grid the levels were built for.
+  MapLimits grid_limits_;
+  std::vector<std::unique_ptr<Level>> levels_;
+};
+
+}  // namespace mapping
+}  // namespace cartographer
+
+#endif  // CARTOGRAPHER_MAPPING_2D_PROBABILITY_GRID_PYRAMID_H_
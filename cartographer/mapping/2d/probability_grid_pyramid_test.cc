@@ -0,0 +1,108 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cartographer/mapping/2d/probability_grid_pyramid.h"
+
+#include <random>
+#include <vector>
+
+#include "cartographer/mapping/probability_values.h"
+#include "gtest/gtest.h"
+
+namespace cartographer {
+namespace mapping {
+namespace {
+
+using Eigen::Array2i;
+
+TEST(ProbabilityGridPyramidTest, LevelsHoldHighestProbability) {
+  ValueConversionTables conversion_tables;
+  ProbabilityGrid grid(
+      MapLimits(0.1, Eigen::Vector2d(1., 1.), CellLimits(5, 5)),
+      &conversion_tables);
+  grid.SetProbability(Array2i(0, 0), 0.2f);
+  grid.SetProbability(Array2i(1, 1), 0.7f);
+  grid.SetProbability(Array2i(4, 4), 0.6f);
+  ProbabilityGridPyramid pyramid(grid, 2 /* num_levels */, &conversion_tables);
+  ASSERT_EQ(2, pyramid.num_levels());
+
+  const ProbabilityGrid& level_0 = pyramid.level(0);
+  EXPECT_NEAR(0.2, level_0.limits().resolution(), 1e-9);
+  EXPECT_EQ(3, level_0.limits().cell_limits().num_x_cells);
+  EXPECT_EQ(3, level_0.limits().cell_limits().num_y_cells);
+  EXPECT_NEAR(0.7f, level_0.GetProbability(Array2i(0, 0)), 1e-3);
+  EXPECT_FALSE(level_0.IsKnown(Array2i(1, 0)));
+  EXPECT_NEAR(0.6f, level_0.GetProbability(Array2i(2, 2)), 1e-3);
+
+  const ProbabilityGrid& level_1 = pyramid.level(1);
+  EXPECT_EQ(2, level_1.limits().cell_limits().num_x_cells);
+  EXPECT_NEAR(0.7f, level_1.GetProbability(Array2i(0, 0)), 1e-3);
+  EXPECT_NEAR(0.6f, level_1.GetProbability(Array2i(1, 1)), 1e-3);
+  EXPECT_TRUE((level_1.limits().GetCellIndex(grid.limits().GetCellCenter(
+                   Array2i(4, 4))) == Array2i(1, 1))
+                  .all());
+}
+
+TEST(ProbabilityGridPyramidTest, UpdatesMatchRebuild) {
+  constexpr int kNumLevels = 3;
+  std::mt19937 prng(42);
+  std::uniform_real_distribution<float> position_distribution(-4.f, 4.f);
+  std::uniform_real_distribution<float> probability_distribution(0.1f, 0.9f);
+  ValueConversionTables conversion_tables;
+  ProbabilityGrid grid(
+      MapLimits(0.1, Eigen::Vector2d(1., 1.), CellLimits(20, 20)),
+      &conversion_tables);
+  ProbabilityGridPyramid pyramid(grid, kNumLevels, &conversion_tables);
+  for (int update = 0; update < 50; ++update) {
+    // Stay within the initial limits at first, then make the grid grow.
+    const float scale = update < 25 ? 0.2f : 1.f;
+    std::vector<Eigen::Vector2f> points;
+    for (int i = 0; i < 30; ++i) {
+      points.emplace_back(scale * position_distribution(prng),
+                          scale * position_distribution(prng));
+    }
+    for (const Eigen::Vector2f& point : points) {
+      grid.GrowLimits(point);
+    }
+    const std::vector<uint16> table =
+        ComputeLookupTableToApplyCorrespondenceCostOdds(
+            Odds(probability_distribution(prng)));
+    for (const Eigen::Vector2f& point : points) {
+      grid.ApplyLookupTable(grid.limits().GetCellIndex(point), table);
+    }
+    grid.FinishUpdate();
+    pyramid.Update(grid);
+  }
+
+  const ProbabilityGridPyramid expected(grid, kNumLevels, &conversion_tables);
+  for (int level_index = 0; level_index < kNumLevels; ++level_index) {
+    const ProbabilityGrid& expected_level = expected.level(level_index);
+    const ProbabilityGrid& actual_level = pyramid.level(level_index);
+    ASSERT_EQ(ToProto(expected_level.limits()).DebugString(),
+              ToProto(actual_level.limits()).DebugString());
+    for (const Array2i& xy_index :
+         XYIndexRangeIterator(expected_level.limits().cell_limits())) {
+      EXPECT_EQ(expected_level.IsKnown(xy_index),
+                actual_level.IsKnown(xy_index));
+      EXPECT_EQ(expected_level.GetProbability(xy_index),
+                actual_level.GetProbability(xy_index));
+    }
+  }
+}
+
+}  // namespace
+}  // namespace mapping
+}  // namespace cartographer
@@ -201,6 +201,28 @@ TEST(ProbabilityGridTest, CorrectCropping) {
   EXPECT_EQ(limits.num_y_cells, 200);
 }
 
+TEST(ProbabilityGridTest, CorrectCroppingFromProtoWithoutKnownCellsBox) {
+  ValueConversionTables conversion_tables;
+  ProbabilityGrid probability_grid(
+      MapLimits(0.05, Eigen::Vector2d(10., 10.), CellLimits(400, 400)),
+      &conversion_tables);
+  for (const Array2i& xy_index :
+       XYIndexRangeIterator(Array2i(120, 80), Array2i(219, 329))) {
+    probability_grid.SetProbability(xy_index, 0.5f);
+  }
+  proto::Grid2D proto = probability_grid.ToProto();
+  ASSERT_TRUE(proto.has_known_cells_box());
+  proto.clear_known_cells_box();
+
+  ProbabilityGrid grid_from_proto(proto, &conversion_tables);
+  Array2i offset;
+  CellLimits limits;
+  grid_from_proto.ComputeCroppedLimits(&offset, &limits);
+  EXPECT_TRUE((offset == Array2i(120, 80)).all());
+  EXPECT_EQ(limits.num_x_cells, 100);
+  EXPECT_EQ(limits.num_y_cells, 250);
+}
+
 }  // namespace
 }  // namespace mapping
 }  // namespace cartographer
@@ -26,12 +26,26 @@
 #include "absl/memory/memory.h"
 #include "cartographer/common/port.h"
 #include "cartographer/mapping/2d/probability_grid_range_data_inserter_2d.h"
+#include "cartographer/mapping/internal/2d/scan_matching/scan_descriptor_2d.h"
 #include "cartographer/mapping/internal/2d/tsdf_range_data_inserter_2d.h"
 #include "cartographer/mapping/range_data_inserter_interface.h"
 #include "glog/logging.h"
 
 namespace cartographer {
 namespace mapping {
+namespace {
+
+Eigen::VectorXf ScanDescriptorFromProto(const proto::Submap2D& submap_2d) {
+  Eigen::VectorXf scan_descriptor =
+      Eigen::VectorXf::Zero(submap_2d.scan_descriptor_size());
+  for (Eigen::VectorXf::Index i = 0; i != submap_2d.scan_descriptor_size();
+       ++i) {
+    scan_descriptor(i) = submap_2d.scan_descriptor(i);
+  }
+  return scan_descriptor;
+}
+
+}  // namespace
 
 proto::SubmapsOptions2D CreateSubmapsOptions2D(
     common::LuaParameterDictionary* const parameter_dictionary) {
@@ -43,6 +57,8 @@ proto::SubmapsOptions2D CreateSubmapsOptions2D(
   *options.mutable_range_data_inserter_options() =
       CreateRangeDataInserterOptions(
           parameter_dictionary->GetDictionary("range_data_inserter").get());
+  options.set_num_pyramid_levels(
+      parameter_dictionary->GetNonNegativeInt("num_pyramid_levels"));
 
   bool valid_range_data_inserter_grid_combination = false;
   const proto::GridOptions2D_GridType& grid_type =
@@ -64,15 +80,31 @@ proto::SubmapsOptions2D CreateSubmapsOptions2D(
       << "Invalid combination grid_type " << grid_type
       << " with range_data_inserter_type " << range_data_inserter_type;
   CHECK_GT(options.num_range_data(), 0);
+  CHECK(options.num_pyramid_levels() == 0 ||
+        grid_type == proto::GridOptions2D::PROBABILITY_GRID)
+      << "num_pyramid_levels requires grid_type PROBABILITY_GRID.";
   return options;
 }
 
 Submap2D::Submap2D(const Eigen::Vector2f& origin, std::unique_ptr<Grid2D> grid,
                    ValueConversionTables* conversion_tables)
+    : Submap2D(origin, std::move(grid), 0 /* num_pyramid_levels */,
+               conversion_tables) {}
+
+Submap2D::Submap2D(const Eigen::Vector2f& origin, std::unique_ptr<Grid2D> grid,
+                   const int num_pyramid_levels,
+                   ValueConversionTables* conversion_tables)
     : Submap(transform::Rigid3d::Translation(
           Eigen::Vector3d(origin.x(), origin.y(), 0.))),
       conversion_tables_(conversion_tables) {
   grid_ = std::move(grid);
+  if (num_pyramid_levels > 0) {
+    CHECK(grid_->GetGridType() == GridType::PROBABILITY_GRID)
+        << "Grid pyramids require a probability grid.";
+    grid_pyramid_ = absl::make_unique<ProbabilityGridPyramid>(
+        static_cast<const ProbabilityGrid&>(*grid_), num_pyramid_levels,
+        conversion_tables_);
+  }
 }
 
 Submap2D::Submap2D(const proto::Submap2D& proto,
@@ -91,6 +123,8 @@ Submap2D::Submap2D(const proto::Submap2D& proto,
   }
   set_num_range_data(proto.num_range_data());
   set_insertion_finished(proto.finished());
+  absl::MutexLock lock(&scan_descriptor_mutex_);
+  scan_descriptor_ = ScanDescriptorFromProto(proto);
 }
 
 proto::Submap Submap2D::ToProto(const bool include_grid_data) const {
@@ -103,6 +137,12 @@ proto::Submap Submap2D::ToProto(const bool include_grid_data) const {
     CHECK(grid_);
     *submap_2d->mutable_grid() = grid_->ToProto();
   }
+  // Only a descriptor which was already computed is written. Readers compute
+  // missing ones from the grid.
+  absl::MutexLock lock(&scan_descriptor_mutex_);
+  for (Eigen::VectorXf::Index i = 0; i != scan_descriptor_.size(); ++i) {
+    submap_2d->add_scan_descriptor(scan_descriptor_(i));
+  }
   return proto;
 }
 
@@ -111,7 +151,13 @@ void Submap2D::UpdateFromProto(const proto::Submap& proto) {
   const auto& submap_2d = proto.submap_2d();
   set_num_range_data(submap_2d.num_range_data());
   set_insertion_finished(submap_2d.finished());
+  {
+    absl::MutexLock lock(&scan_descriptor_mutex_);
+    scan_descriptor_ = ScanDescriptorFromProto(submap_2d);
+  }
   if (proto.submap_2d().has_grid()) {
+    absl::MutexLock lock(&finished_texture_mutex_);
+    finished_texture_.reset();
     if (proto.submap_2d().grid().has_probability_grid_2d()) {
       grid_ = absl::make_unique<ProbabilityGrid>(proto.submap_2d().grid(),
                                                  conversion_tables_);
@@ -131,7 +177,28 @@ void Submap2D::ToResponseProto(
   response->set_submap_version(num_range_data());
   proto::SubmapQuery::Response::SubmapTexture* const texture =
       response->add_textures();
-  grid()->DrawToSubmapTexture(texture, local_pose());
+  if (!insertion_finished()) {
+    grid()->DrawToSubmapTexture(texture, local_pose());
+    return;
+  }
+  absl::MutexLock lock(&finished_texture_mutex_);
+  if (finished_texture_ == nullptr) {
+    finished_texture_ =
+        absl::make_unique<proto::SubmapQuery::Response::SubmapTexture>();
+    grid()->DrawToSubmapTexture(finished_texture_.get(), local_pose());
+  }
+  *texture = *finished_texture_;
+}
+
+std::vector<const Grid2D*> Submap2D::GetGridsCoarseToFine() const {
+  std::vector<const Grid2D*> grids;
+  if (grid_pyramid_ != nullptr) {
+    for (int i = grid_pyramid_->num_levels() - 1; i >= 0; --i) {
+      grids.push_back(&grid_pyramid_->level(i));
+    }
+  }
+  grids.push_back(grid_.get());
+  return grids;
 }
 
 void Submap2D::InsertRangeData(
@@ -161,6 +228,9 @@ void Submap2D::InsertRangeData(
 
   
   range_data_inserter->Insert(range_data, grid_.get());
+  if (grid_pyramid_ != nullptr) {
+    grid_pyramid_->Update(static_cast<const ProbabilityGrid&>(*grid_));
+  }
   set_num_range_data(num_range_data() + 1);
 }
 
@@ -168,9 +238,21 @@ void Submap2D::Finish() {
   CHECK(grid_);
   CHECK(!insertion_finished());
   grid_ = grid_->ComputeCroppedGrid();
+  grid_pyramid_.reset();
   set_insertion_finished(true);
 }
 
+Eigen::VectorXf Submap2D::scan_descriptor() const {
+  if (!insertion_finished()) {
+    return Eigen::VectorXf();
+  }
+  absl::MutexLock lock(&scan_descriptor_mutex_);
+  if (scan_descriptor_.size() == 0 && grid_ != nullptr) {
+    scan_descriptor_ = scan_matching::ScanDescriptor2D::Compute(
+        *grid_, local_pose().translation().head<2>().cast<float>());
+  }
+  return scan_descriptor_;
+}
 
 ActiveSubmaps2D::ActiveSubmaps2D(const proto::SubmapsOptions2D& options)
     : options_(options), range_data_inserter_(CreateRangeDataInserter()) {}
@@ -254,7 +336,7 @@ void ActiveSubmaps2D::AddSubmap(const Eigen::Vector2f& origin) {
       origin,
       std::unique_ptr<Grid2D>(
           static_cast<Grid2D*>(CreateGrid(origin).release())),
-      &conversion_tables_));
+      options_.num_pyramid_levels(), &conversion_tables_));
 }
 
 }  // namespace mapping
@@ -21,9 +21,11 @@
 #include <vector>
 #include <queue>
 #include "Eigen/Core"
+#include "absl/synchronization/mutex.h"
 #include "cartographer/common/lua_parameter_dictionary.h"
 #include "cartographer/mapping/2d/grid_2d.h"
 #include "cartographer/mapping/2d/map_limits.h"
+#include "cartographer/mapping/2d/probability_grid_pyramid.h"
 #include "cartographer/mapping/proto/serialization.pb.h"
 #include "cartographer/mapping/proto/submap_visualization.pb.h"
 #include "cartographer/mapping/proto/submaps_options_2d.pb.h"
@@ -44,6 +46,10 @@ class Submap2D : public Submap {
  public:
   Submap2D(const Eigen::Vector2f& origin, std::unique_ptr<Grid2D> grid,
            ValueConversionTables* conversion_tables);
+  // Also keeps a pyramid of 'num_pyramid_levels' coarser grids up to date
+  // while range data is inserted. Requires a probability grid.
+  Submap2D(const Eigen::Vector2f& origin, std::unique_ptr<Grid2D> grid,
+           int num_pyramid_levels, ValueConversionTables* conversion_tables);
   explicit Submap2D(const proto::Submap2D& proto,
                     ValueConversionTables* conversion_tables);
 
@@ -55,6 +61,16 @@ class Submap2D : public Submap {
 
   const Grid2D* grid() const { return grid_.get(); }
 
+  // Returns the levels of the grid pyramid from coarsest to finest, followed
+  // by the grid itself. The pyramid is dropped when the submap is finished.
+  std::vector<const Grid2D*> GetGridsCoarseToFine() const;
+
+  // Rotation invariant descriptor of the grid as seen from the origin of the
+  // submap. Empty before the submap is finished. It is computed on the first
+  // call, so it costs nothing unless the constraint builder's descriptor
+  // prefilter or the place recognition index asks for it.
+  Eigen::VectorXf scan_descriptor() const;
+
   // Insert 'range_data' into this submap using 'range_data_inserter'. The
   // submap must not be finished yet.
   void InsertRangeData(const sensor::RangeData& range_data,
@@ -71,7 +87,17 @@ class Submap2D : public Submap {
   // 保存多少帧点云
   const int max_node_num_ = 3;
   std::unique_ptr<Grid2D> grid_;
+  std::unique_ptr<ProbabilityGridPyramid> grid_pyramid_;
   ValueConversionTables* conversion_tables_;
+
+  mutable absl::Mutex scan_descriptor_mutex_;
+  mutable Eigen::VectorXf scan_descriptor_ GUARDED_BY(scan_descriptor_mutex_);
+
+  // The grid of a finished submap no longer changes, so its texture is drawn
+  // on the first query and reused afterwards.
+  mutable absl::Mutex finished_texture_mutex_;
+  mutable std::unique_ptr<proto::SubmapQuery::Response::SubmapTexture>
+      finished_texture_ GUARDED_BY(finished_texture_mutex_);
 };
 
 // The first active submap will be created on the insertion of the first range
@@ -62,8 +62,10 @@ TEST(Submap2DTest, TheRightNumberOfRangeDataAreInserted) {
       "update_weight_range_exponent = 0,"
       "update_weight_angle_scan_normal_to_ray_kernel_bandwidth = 0,"
       "update_weight_distance_cell_to_hit_kernel_bandwidth = 0,"
+      "num_threads = 1,"
       "},"
       "},"
+      "num_pyramid_levels = 2,"
       "}");
   ActiveSubmaps2D submaps{CreateSubmapsOptions2D(parameter_dictionary.get())};
   std::set<std::shared_ptr<const Submap2D>> all_submaps;
@@ -83,6 +85,9 @@ TEST(Submap2DTest, TheRightNumberOfRangeDataAreInserted) {
   int correct_num_finished_submaps = 0;
   int num_unfinished_submaps = 0;
   for (const auto& submap : all_submaps) {
+    // Only submaps still receiving range data keep their grid pyramid.
+    EXPECT_EQ(submap->insertion_finished() ? 1 : 3,
+              submap->GetGridsCoarseToFine().size());
     if (submap->num_range_data() == kNumRangeData * 2) {
       ++correct_num_finished_submaps;
     } else {
@@ -107,7 +112,7 @@ TEST(Submap2DTest, ToFromProto) {
       expected.ToProto(true /* include_probability_grid_data */);
   EXPECT_TRUE(proto.has_submap_2d());
   EXPECT_FALSE(proto.has_submap_3d());
-  const auto actual = Submap2D(proto.submap_2d(), &conversion_tables);
+  const Submap2D actual(proto.submap_2d(), &conversion_tables);
   EXPECT_TRUE(expected.local_pose().translation().isApprox(
       actual.local_pose().translation(), 1e-6));
   EXPECT_TRUE(expected.local_pose().rotation().isApprox(
@@ -122,6 +127,68 @@ TEST(Submap2DTest, ToFromProto) {
             actual.grid()->limits().cell_limits().num_x_cells);
 }
 
+TEST(Submap2DTest, ScanDescriptorToFromProto) {
+  ValueConversionTables conversion_tables;
+  ProbabilityGrid grid(
+      MapLimits(0.1, Eigen::Vector2d(1., 1.), CellLimits(20, 20)),
+      &conversion_tables);
+  for (int i = 0; i != 20; ++i) {
+    grid.SetProbability(Eigen::Array2i(i, 2), 0.9f);
+    if (i != 2) grid.SetProbability(Eigen::Array2i(3, i), 0.9f);
+  }
+  proto::Submap2D proto;
+  *proto.mutable_local_pose() =
+      transform::ToProto(transform::Rigid3d::Identity());
+  proto.set_finished(true);
+  *proto.mutable_grid() = grid.ToProto();
+  // Without a stored descriptor, it is computed from the grid.
+  const Submap2D expected(proto, &conversion_tables);
+  const Eigen::VectorXf expected_descriptor = expected.scan_descriptor();
+  ASSERT_NE(0, expected_descriptor.size());
+
+  const proto::Submap expected_proto =
+      expected.ToProto(true /* include_probability_grid_data */);
+  EXPECT_EQ(expected_descriptor.size(),
+            expected_proto.submap_2d().scan_descriptor_size());
+  const Submap2D actual(expected_proto.submap_2d(), &conversion_tables);
+  const Eigen::VectorXf actual_descriptor = actual.scan_descriptor();
+  ASSERT_EQ(expected_descriptor.size(), actual_descriptor.size());
+  for (Eigen::VectorXf::Index i = 0; i != expected_descriptor.size(); ++i) {
+    EXPECT_EQ(expected_descriptor(i), actual_descriptor(i));
+  }
+}
+
+TEST(Submap2DTest, FinishedSubmapTextureFollowsUpdateFromProto) {
+  ValueConversionTables conversion_tables;
+  ProbabilityGrid grid(
+      MapLimits(1., Eigen::Vector2d(2., 3.), CellLimits(10, 10)),
+      &conversion_tables);
+  grid.SetProbability(Eigen::Array2i(2, 3), 0.9f);
+  proto::Submap proto;
+  auto* const submap_2d = proto.mutable_submap_2d();
+  *submap_2d->mutable_local_pose() =
+      transform::ToProto(transform::Rigid3d::Identity());
+  submap_2d->set_finished(true);
+  *submap_2d->mutable_grid() = grid.ToProto();
+  Submap2D submap(*submap_2d, &conversion_tables);
+
+  proto::SubmapQuery::Response response;
+  submap.ToResponseProto(transform::Rigid3d::Identity(), &response);
+  submap.ToResponseProto(transform::Rigid3d::Identity(), &response);
+  ASSERT_EQ(2, response.textures_size());
+  EXPECT_EQ(response.textures(0).DebugString(),
+            response.textures(1).DebugString());
+  EXPECT_EQ(1, response.textures(0).width());
+
+  grid.SetProbability(Eigen::Array2i(5, 3), 0.1f);
+  *submap_2d->mutable_grid() = grid.ToProto();
+  submap.UpdateFromProto(proto);
+  response.Clear();
+  submap.ToResponseProto(transform::Rigid3d::Identity(), &response);
+  ASSERT_EQ(1, response.textures_size());
+  EXPECT_EQ(4, response.textures(0).width());
+}
+
 }  // namespace
 }  // namespace mapping
 }  // namespace cartographer
@@ -17,6 +17,7 @@
 #ifndef CARTOGRAPHER_MAPPING_3D_HYBRID_GRID_H_
 #define CARTOGRAPHER_MAPPING_3D_HYBRID_GRID_H_
 
+#include <algorithm>
 #include <array>
 #include <cmath>
 #include <limits>
@@ -544,30 +545,72 @@ class HybridGrid : public HybridGridBase<uint16> {
   std::vector<ValueType*> update_indices_;
 };
 
+// Average of the intensities inserted into a voxel, packed into 32 bits. The
+// mean is kept in the fixed point format of the 'IntensityHybridGrid'.
+// For the first 'kMaxCount' intensities of a voxel, 'quantized_mean' is their
+// arithmetic mean. After that, 'count' saturates and each new intensity is
+// blended in with a weight of 1 / 'kMaxCount', i.e. the mean becomes an
+// exponential moving average. Voxels which are observed very often thereby
+// follow changes in intensity instead of freezing on old observations.
 struct AverageIntensityData {
-  float sum = 0.f;
-  int count = 0;
+  static constexpr uint32 kMaxCount = (1 << 8) - 1;
+
+  AverageIntensityData() : quantized_mean(0), count(0) {}
+
+  uint32 quantized_mean : 24;
+  uint32 count : 8;
 };
 
+// A hybrid grid of average intensities. Intensities are clamped to
+// [0, 'max_intensity'] and stored with 24 bits of fixed point precision. The
+// quantization step is the smallest power of two for which 'max_intensity'
+// fits, so integer intensities are represented exactly as long as
+// 'max_intensity' is below 2^24. The default covers sensors reporting 16 bit
+// intensities with a step of 2^-8.
 class IntensityHybridGrid : public HybridGridBase<AverageIntensityData> {
  public:
-  explicit IntensityHybridGrid(const float resolution)
-      : HybridGridBase<AverageIntensityData>(resolution) {}
+  static constexpr float kDefaultMaxIntensity = 65535.f;
+
+  explicit IntensityHybridGrid(const float resolution,
+                               const float max_intensity = kDefaultMaxIntensity)
+      : HybridGridBase<AverageIntensityData>(resolution),
+        max_intensity_(max_intensity),
+        quantization_step_(ComputeQuantizationStep(max_intensity)) {}
 
+  // 'intensity' must be finite.
   void AddIntensity(const Eigen::Array3i& index, const float intensity) {
+    DCHECK(std::isfinite(intensity));
     AverageIntensityData* const cell = mutable_value(index);
-    cell->count += 1;
-    cell->sum += intensity;
+    if (cell->count < AverageIntensityData::kMaxCount) {
+      cell->count += 1;
+    }
+    const double quantized_intensity =
+        common::Clamp(intensity, 0.f, max_intensity_) / quantization_step_;
+    cell->quantized_mean = common::RoundToInt64(
+        cell->quantized_mean +
+        (quantized_intensity - cell->quantized_mean) / cell->count);
   }
 
   float GetIntensity(const Eigen::Array3i& index) const {
-    const AverageIntensityData& cell = value(index);
-    if (cell.count == 0) {
-      return 0.f;
-    } else {
-      return cell.sum / cell.count;
-    }
+    return value(index).quantized_mean * quantization_step_;
   }
+
+  float max_intensity() const { return max_intensity_; }
+
+ private:
+  // Returns the smallest power of two step for which 'max_intensity' fits
+  // into 24 bits.
+  static float ComputeQuantizationStep(const float max_intensity) {
+    CHECK(std::isfinite(max_intensity))
+        << "max_intensity must be finite, got " << max_intensity;
+    CHECK_GT(max_intensity, 0.f);
+    int exponent;
+    std::frexp(std::max(max_intensity, 1.f), &exponent);
+    return std::ldexp(1.f, exponent - 24);
+  }
+
+  const float max_intensity_;
+  const float quantization_step_;
 };
 
 }  // namespace mapping
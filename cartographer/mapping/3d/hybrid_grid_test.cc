@@ -16,6 +16,7 @@
 
 #include "cartographer/mapping/3d/hybrid_grid.h"
 
+#include <limits>
 #include <map>
 #include <random>
 #include <tuple>
@@ -101,6 +102,61 @@ TEST(HybridGridTest, GetIntensity) {
   }
 }
 
+TEST(HybridGridTest, AverageIntensity) {
+  static_assert(sizeof(AverageIntensityData) == 4,
+                "Intensity cells should be packed into 32 bits.");
+  IntensityHybridGrid hybrid_grid(1.f, 100.f);
+  const Eigen::Array3i cell_index =
+      hybrid_grid.GetCellIndex(Eigen::Vector3f(0.f, 1.f, 1.f));
+  std::mt19937 prng(42);
+  std::uniform_real_distribution<float> distribution(0.f, 100.f);
+  double sum = 0.;
+  for (int i = 1; i <= 200; ++i) {
+    const float intensity = distribution(prng);
+    sum += intensity;
+    hybrid_grid.AddIntensity(cell_index, intensity);
+    EXPECT_NEAR(hybrid_grid.GetIntensity(cell_index), sum / i, 1e-3);
+  }
+
+  const Eigen::Array3i clamped_index =
+      hybrid_grid.GetCellIndex(Eigen::Vector3f(1.f, 1.f, 1.f));
+  hybrid_grid.AddIntensity(clamped_index, 1000.f);
+  EXPECT_NEAR(hybrid_grid.GetIntensity(clamped_index), 100.f, 1e-3);
+  hybrid_grid.AddIntensity(clamped_index, -1000.f);
+  EXPECT_NEAR(hybrid_grid.GetIntensity(clamped_index), 50.f, 1e-3);
+
+  // Once the count saturates, new intensities are still blended in.
+  const Eigen::Array3i saturated_index =
+      hybrid_grid.GetCellIndex(Eigen::Vector3f(1.f, 2.f, 1.f));
+  for (int i = 0; i < 1000; ++i) {
+    hybrid_grid.AddIntensity(saturated_index, 10.f);
+  }
+  EXPECT_EQ(hybrid_grid.GetIntensity(saturated_index), 10.f);
+  for (int i = 0; i < 255; ++i) {
+    hybrid_grid.AddIntensity(saturated_index, 20.f);
+  }
+  EXPECT_GT(hybrid_grid.GetIntensity(saturated_index), 15.f);
+  EXPECT_LT(hybrid_grid.GetIntensity(saturated_index), 20.f);
+}
+
+TEST(HybridGridTest, DefaultIntensityRangeKeepsLargeIntensities) {
+  IntensityHybridGrid hybrid_grid(1.f);
+  const Eigen::Array3i cell_index =
+      hybrid_grid.GetCellIndex(Eigen::Vector3f(0.f, 1.f, 1.f));
+  hybrid_grid.AddIntensity(cell_index, 4000.f);
+  EXPECT_EQ(hybrid_grid.GetIntensity(cell_index), 4000.f);
+  hybrid_grid.AddIntensity(cell_index, 4001.f);
+  EXPECT_EQ(hybrid_grid.GetIntensity(cell_index), 4000.5f);
+}
+
+TEST(HybridGridTest, RejectsNonFiniteMaxIntensity) {
+  EXPECT_DEATH(IntensityHybridGrid(1.f, std::numeric_limits<float>::infinity()),
+               "max_intensity must be finite");
+  EXPECT_DEATH(
+      IntensityHybridGrid(1.f, std::numeric_limits<float>::quiet_NaN()),
+      "max_intensity must be finite");
+}
+
 MATCHER_P(AllCwiseEqual, index, "") { return (arg == index).all(); }
 
 TEST(HybridGridTest, GetCellIndex) {
@@ -51,21 +51,6 @@ void InsertMissesIntoGrid(const std::vector<uint16>& miss_table,
   }
 }
 
-void InsertIntensitiesIntoGrid(const sensor::PointCloud& returns,
-                               IntensityHybridGrid* intensity_hybrid_grid,
-                               const float intensity_threshold) {
-  if (returns.intensities().size() > 0) {
-    for (size_t i = 0; i < returns.size(); ++i) {
-      if (returns.intensities()[i] > intensity_threshold) {
-        continue;
-      }
-      const Eigen::Array3i hit_cell =
-          intensity_hybrid_grid->GetCellIndex(returns[i].position);
-      intensity_hybrid_grid->AddIntensity(hit_cell, returns.intensities()[i]);
-    }
-  }
-}
-
 }  // namespace
 
 proto::RangeDataInserterOptions3D CreateRangeDataInserterOptions3D(
@@ -96,20 +81,28 @@ void RangeDataInserter3D::Insert(
     const sensor::RangeData& range_data, HybridGrid* hybrid_grid,
     IntensityHybridGrid* intensity_hybrid_grid) const {
   CHECK_NOTNULL(hybrid_grid);
+  const sensor::PointCloud& returns = range_data.returns;
+  const bool insert_intensities =
+      intensity_hybrid_grid != nullptr && returns.intensities().size() > 0;
+  if (insert_intensities) {
+    // Intensities are inserted at the hit cells, so both grids share indices.
+    CHECK_EQ(intensity_hybrid_grid->resolution(), hybrid_grid->resolution());
+  }
 
-  for (const sensor::RangefinderPoint& hit : range_data.returns) {
-    const Eigen::Array3i hit_cell = hybrid_grid->GetCellIndex(hit.position);
+  for (size_t i = 0; i < returns.size(); ++i) {
+    const Eigen::Array3i hit_cell =
+        hybrid_grid->GetCellIndex(returns[i].position);
     hybrid_grid->ApplyLookupTable(hit_cell, hit_table_);
+    if (insert_intensities &&
+        returns.intensities()[i] <= options_.intensity_threshold()) {
+      intensity_hybrid_grid->AddIntensity(hit_cell, returns.intensities()[i]);
+    }
   }
 
   // By not starting a new update after hits are inserted, we give hits priority
   // (i.e. no hits will be ignored because of a miss in the same cell).
   InsertMissesIntoGrid(miss_table_, range_data.origin, range_data.returns,
                        hybrid_grid, options_.num_free_space_voxels());
-  if (intensity_hybrid_grid != nullptr) {
-    InsertIntensitiesIntoGrid(range_data.returns, intensity_hybrid_grid,
-                              options_.intensity_threshold());
-  }
   hybrid_grid->FinishUpdate();
 }
 
@@ -187,14 +187,18 @@ proto::SubmapsOptions3D CreateSubmapsOptions3D(
   options.set_low_resolution(parameter_dictionary->GetDouble("low_resolution"));
   options.set_num_range_data(
       parameter_dictionary->GetNonNegativeInt("num_range_data"));
+  options.set_max_intensity(parameter_dictionary->GetDouble("max_intensity"));
   *options.mutable_range_data_inserter_options() =
       CreateRangeDataInserterOptions3D(
           parameter_dictionary->GetDictionary("range_data_inserter").get());
   CHECK_GT(options.num_range_data(), 0);
+  CHECK(std::isfinite(options.max_intensity()));
+  CHECK_GT(options.max_intensity(), 0.f);
   return options;
 }
 
 Submap3D::Submap3D(const float high_resolution, const float low_resolution,
+                   const float max_intensity,
                    const transform::Rigid3d& local_submap_pose,
                    const Eigen::VectorXf& rotational_scan_matcher_histogram)
     : Submap(local_submap_pose),
@@ -203,7 +207,8 @@ Submap3D::Submap3D(const float high_resolution, const float low_resolution,
       low_resolution_hybrid_grid_(
           absl::make_unique<HybridGrid>(low_resolution)),
       high_resolution_intensity_hybrid_grid_(
-          absl::make_unique<IntensityHybridGrid>(high_resolution)),
+          absl::make_unique<IntensityHybridGrid>(high_resolution,
+                                                 max_intensity)),
       rotational_scan_matcher_histogram_(rotational_scan_matcher_histogram) {}
 
 Submap3D::Submap3D(const proto::Submap3D& proto)
@@ -346,7 +351,8 @@ void ActiveSubmaps3D::AddSubmap(
   const Eigen::VectorXf initial_rotational_scan_matcher_histogram =
       Eigen::VectorXf::Zero(rotational_scan_matcher_histogram_size);
   submaps_.emplace_back(new Submap3D(
-      options_.high_resolution(), options_.low_resolution(), local_submap_pose,
+      options_.high_resolution(), options_.low_resolution(),
+      options_.max_intensity(), local_submap_pose,
       initial_rotational_scan_matcher_histogram));
 }
 
@@ -42,7 +42,8 @@ proto::SubmapsOptions3D CreateSubmapsOptions3D(
 
 class Submap3D : public Submap {
  public:
-  Submap3D(float high_resolution, float low_resolution,
+  // Intensities are stored up to 'max_intensity'.
+  Submap3D(float high_resolution, float low_resolution, float max_intensity,
            const transform::Rigid3d& local_submap_pose,
            const Eigen::VectorXf& rotational_scan_matcher_histogram);
 
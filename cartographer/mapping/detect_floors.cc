@@ -17,7 +17,8 @@
 #include "cartographer/mapping/detect_floors.h"
 
 #include <algorithm>
-#include <fstream>
+#include <functional>
+#include <iterator>
 #include <vector>
 
 #include "Eigen/Core"
@@ -29,139 +30,151 @@ namespace mapping {
 
 namespace {
 
-// A union-find structure for assigning levels to 'spans' in the trajectory
-// implemented as a disjoint-set forest:
-// https://en.wikipedia.org/wiki/Disjoint-set_data_structure#Disjoint-set_forests
-// TODO(hrapp): We use this elsewhere. Pull out into a common place.
-using Levels = std::map<int, int>;
-
 constexpr double kMaxShortSpanLengthMeters = 25.;
 constexpr double kLevelHeightMeters = 2.5;
 constexpr double kMinLevelSeparationMeters = 1.;
 
-// Indices into 'trajectory.node', so that 'start_index' <= i < 'end_index'.
-struct Span {
-  int start_index;
-  int end_index;
-  std::vector<double> z_values;
+double Median(std::vector<double>* values) {
+  CHECK(!values->empty());
+  const auto median = values->begin() + values->size() / 2;
+  std::nth_element(values->begin(), median, values->end());
+  return *median;
+}
+
+}  // namespace
 
-  bool operator<(const Span& other) const {
-    return std::forward_as_tuple(start_index, end_index) <
-           std::forward_as_tuple(other.start_index, other.end_index);
+void FloorDetector::RunningMedian::Add(const double value) {
+  if (!upper_.empty() && value >= upper_.front()) {
+    upper_.push_back(value);
+    std::push_heap(upper_.begin(), upper_.end(), std::greater<double>());
+  } else {
+    lower_.push_back(value);
+    std::push_heap(lower_.begin(), lower_.end());
   }
-};
-
-// Union-find implementation for classifying spans into levels.
-int LevelFind(const int i, const Levels& levels) {
-  auto it = levels.find(i);
-  CHECK(it != levels.end());
-  if (it->first == it->second) {
-    return it->second;
+  // Keep size() / 2 values in 'lower_', so that the median is the smallest
+  // value in 'upper_'.
+  const size_t lower_size = (lower_.size() + upper_.size()) / 2;
+  while (lower_.size() > lower_size) {
+    std::pop_heap(lower_.begin(), lower_.end());
+    upper_.push_back(lower_.back());
+    lower_.pop_back();
+    std::push_heap(upper_.begin(), upper_.end(), std::greater<double>());
+  }
+  while (lower_.size() < lower_size) {
+    std::pop_heap(upper_.begin(), upper_.end(), std::greater<double>());
+    lower_.push_back(upper_.back());
+    upper_.pop_back();
+    std::push_heap(lower_.begin(), lower_.end());
   }
-  return LevelFind(it->second, levels);
-}
-
-void LevelUnion(int i, int j, Levels* levels) {
-  const int repr_i = LevelFind(i, *levels);
-  const int repr_j = LevelFind(j, *levels);
-  (*levels)[repr_i] = repr_j;
 }
 
-void InsertSorted(const double val, std::vector<double>* vals) {
-  vals->insert(std::upper_bound(vals->begin(), vals->end(), val), val);
+double FloorDetector::RunningMedian::median() const {
+  CHECK(!upper_.empty());
+  return upper_.front();
 }
 
-double Median(const std::vector<double>& sorted) {
-  CHECK(!sorted.empty());
-  return sorted.at(sorted.size() / 2);
+void FloorDetector::RunningMedian::AppendValues(
+    std::vector<double>* const values) const {
+  values->insert(values->end(), lower_.begin(), lower_.end());
+  values->insert(values->end(), upper_.begin(), upper_.end());
 }
 
-// Cut the trajectory at jumps in z. A new span is started when the current
-// node's z differes by more than kLevelHeightMeters from the median z values.
-std::vector<Span> SliceByAltitudeChange(const proto::Trajectory& trajectory) {
-  CHECK_GT(trajectory.node_size(), 0);
-
-  std::vector<Span> spans;
-  spans.push_back(Span{0, 0, {trajectory.node(0).pose().translation().z()}});
-  for (int i = 1; i < trajectory.node_size(); ++i) {
-    const auto& node = trajectory.node(i);
-    const double z = node.pose().translation().z();
-    if (std::abs(Median(spans.back().z_values) - z) > kLevelHeightMeters) {
-      spans.push_back(Span{i, i, {}});
-    }
-    InsertSorted(z, &spans.back().z_values);
-    spans.back().end_index = i + 1;
+void FloorDetector::Levels::Add(const int span_index, const double median) {
+  CHECK_EQ(span_index, static_cast<int>(parents_.size()));
+  parents_.push_back(span_index);
+  // In one dimension, spans closer than 'kMinLevelSeparationMeters' are
+  // connected iff there is a chain of such spans between neighbors in sorted
+  // order. Hence, it is enough to union with the new neighbors.
+  const auto it = span_indices_by_median_.emplace(median, span_index);
+  if (it != span_indices_by_median_.begin() &&
+      median - std::prev(it)->first < kMinLevelSeparationMeters) {
+    Union(std::prev(it)->second, span_index);
+  }
+  if (std::next(it) != span_indices_by_median_.end() &&
+      std::next(it)->first - median < kMinLevelSeparationMeters) {
+    Union(std::next(it)->second, span_index);
   }
-  return spans;
 }
 
-// Returns the length of 'span' in meters.
-double SpanLength(const proto::Trajectory& trajectory, const Span& span) {
-  double length = 0;
-  for (int i = span.start_index + 1; i < span.end_index; ++i) {
-    const auto a =
-        transform::ToEigen(trajectory.node(i - 1).pose().translation());
-    const auto b = transform::ToEigen(trajectory.node(i).pose().translation());
-    length += (a - b).head<2>().norm();
+int FloorDetector::Levels::Find(int span_index) const {
+  while (parents_.at(span_index) != span_index) {
+    span_index = parents_[span_index];
   }
-  return length;
+  return span_index;
 }
 
-// True if 'span' is considered to be short, i.e. not interesting on its own,
-// but should be folded into the levels before and after entering it.
-bool IsShort(const proto::Trajectory& trajectory, const Span& span) {
-  return SpanLength(trajectory, span) < kMaxShortSpanLengthMeters;
+void FloorDetector::Levels::Union(const int a, const int b) {
+  const int representative_a = Find(a);
+  const int representative_b = Find(b);
+  // Point the larger representative to the smaller one. Since spans are added
+  // in order, this keeps the trees shallow in practice.
+  parents_[std::max(representative_a, representative_b)] =
+      std::min(representative_a, representative_b);
 }
 
-// Merges all 'spans' that have similar median z value into the same level.
-void GroupSegmentsByAltitude(const proto::Trajectory& trajectory,
-                             const std::vector<Span>& spans, Levels* levels) {
-  for (size_t i = 0; i < spans.size(); ++i) {
-    for (size_t j = i + 1; j < spans.size(); ++j) {
-      if (std::abs(Median(spans[i].z_values) - Median(spans[j].z_values)) <
-          kMinLevelSeparationMeters) {
-        LevelUnion(i, j, levels);
-      }
+void FloorDetector::AddNode(const common::Time time,
+                            const Eigen::Vector3d& translation) {
+  // Cut the trajectory at jumps in z. A new span is started when the current
+  // node's z differs by more than kLevelHeightMeters from the median z value
+  // of the current span.
+  const double z = translation.z();
+  if (spans_.empty() ||
+      std::abs(spans_.back().z_values.median() - z) > kLevelHeightMeters) {
+    if (!spans_.empty()) {
+      finished_levels_.Add(spans_.size() - 1,
+                           spans_.back().z_values.median());
     }
+    spans_.push_back(Span{time, time, translation.head<2>(), 0., {}});
   }
+  Span& span = spans_.back();
+  span.length += (translation.head<2>() - span.last_xy).norm();
+  span.last_xy = translation.head<2>();
+  span.end_time = time;
+  span.z_values.Add(z);
 }
 
-std::vector<Floor> FindFloors(const proto::Trajectory& trajectory,
-                              const std::vector<Span>& spans,
-                              const Levels& levels) {
-  std::map<int, std::vector<Span>> level_spans;
+std::vector<Floor> FloorDetector::GetFloors() const {
+  if (spans_.empty()) {
+    return {};
+  }
+  Levels levels = finished_levels_;
+  levels.Add(spans_.size() - 1, spans_.back().z_values.median());
+
+  // A short span is not interesting on its own, but is folded into the levels
+  // before and after entering it.
+  const auto is_short = [this](const int span_index) {
+    return spans_[span_index].length < kMaxShortSpanLengthMeters;
+  };
+  const int num_spans = spans_.size();
+  std::map<int, std::vector<int>> level_spans;
 
   // Initialize the levels to start out with only long spans.
-  for (size_t i = 0; i < spans.size(); ++i) {
-    const Span& span = spans[i];
-    if (!IsShort(trajectory, span)) {
-      level_spans[LevelFind(i, levels)].push_back(span);
+  for (int i = 0; i < num_spans; ++i) {
+    if (!is_short(i)) {
+      level_spans[levels.Find(i)].push_back(i);
     }
   }
 
-  for (size_t i = 0; i < spans.size(); ++i) {
-    const Span& span = spans[i];
-    if (!IsShort(trajectory, span)) {
+  for (int i = 0; i < num_spans; ++i) {
+    if (!is_short(i)) {
       continue;
     }
 
     // If we have a long piece on this floor already, merge this short piece
     // into it.
-    int level = LevelFind(i, levels);
+    const int level = levels.Find(i);
     if (!level_spans[level].empty()) {
-      level_spans[level].push_back(span);
+      level_spans[level].push_back(i);
       continue;
     }
 
     // Otherwise, add this short piece to the level before and after it. It is
     // likely some intermediate level on stairs.
-    size_t index = i - 1;
-    if (index < spans.size()) {
-      level_spans[LevelFind(index, levels)].push_back(span);
+    if (i > 0) {
+      level_spans[levels.Find(i - 1)].push_back(i);
     }
-    index = i + 1;
-    if (index < spans.size()) {
-      level_spans[LevelFind(index, levels)].push_back(span);
+    if (i + 1 < num_spans) {
+      level_spans[levels.Find(i + 1)].push_back(i);
     }
   }
 
@@ -175,44 +188,37 @@ std::vector<Floor> FindFloors(const proto::Trajectory& trajectory,
     std::vector<double> z_values;
     std::sort(level.second.begin(), level.second.end());
     floors.emplace_back();
-    for (const auto& span : level.second) {
-      if (!IsShort(trajectory, span)) {
+    for (const int span_index : level.second) {
+      const Span& span = spans_[span_index];
+      if (!is_short(span_index)) {
         // To figure out the median height of this floor, we only care for the
         // long pieces that are guaranteed to be in the structure. This is a
         // heuristic to leave out intermediate (short) levels.
-        z_values.insert(z_values.end(), span.z_values.begin(),
-                        span.z_values.end());
+        span.z_values.AppendValues(&z_values);
       }
-      floors.back().timespans.push_back(Timespan{
-          common::FromUniversal(trajectory.node(span.start_index).timestamp()),
-          common::FromUniversal(
-              trajectory.node(span.end_index - 1).timestamp())});
+      floors.back().timespans.push_back(
+          Timespan{span.start_time, span.end_time});
     }
     if (!z_values.empty()) {
-      std::sort(z_values.begin(), z_values.end());
-      floors.back().z = Median(z_values);
+      floors.back().z = Median(&z_values);
     } else {
       LOG(ERROR) << "All spans in level are short";
       floors.pop_back();
     }
   }
+  std::sort(floors.begin(), floors.end(),
+            [](const Floor& a, const Floor& b) { return a.z < b.z; });
   return floors;
 }
 
-}  // namespace
-
 std::vector<Floor> DetectFloors(const proto::Trajectory& trajectory) {
-  const std::vector<Span> spans = SliceByAltitudeChange(trajectory);
-  Levels levels;
-  for (size_t i = 0; i < spans.size(); ++i) {
-    levels[i] = i;
+  CHECK_GT(trajectory.node_size(), 0);
+  FloorDetector floor_detector;
+  for (const auto& node : trajectory.node()) {
+    floor_detector.AddNode(common::FromUniversal(node.timestamp()),
+                           transform::ToEigen(node.pose().translation()));
   }
-  GroupSegmentsByAltitude(trajectory, spans, &levels);
-
-  std::vector<Floor> floors = FindFloors(trajectory, spans, levels);
-  std::sort(floors.begin(), floors.end(),
-            [](const Floor& a, const Floor& b) { return a.z < b.z; });
-  return floors;
+  return floor_detector.GetFloors();
 }
 
 }  // namespace mapping
@@ -17,6 +17,10 @@
 #ifndef CARTOGRAPHER_MAPPING_DETECT_FLOORS_H_
 #define CARTOGRAPHER_MAPPING_DETECT_FLOORS_H_
 
+#include <map>
+#include <vector>
+
+#include "Eigen/Core"
 #include "cartographer/common/time.h"
 #include "cartographer/mapping/proto/trajectory.pb.h"
 
@@ -44,6 +48,63 @@ struct Floor {
 // the stairs.
 std::vector<Floor> DetectFloors(const proto::Trajectory& trajectory);
 
+// Streaming version of 'DetectFloors' for nodes arriving in trajectory order.
+// 'GetFloors' returns the floors 'DetectFloors' finds for the nodes added so
+// far. Adding a node takes O(log n) time, so floors can be tracked online for
+// arbitrarily long trajectories.
+class FloorDetector {
+ public:
+  void AddNode(common::Time time, const Eigen::Vector3d& translation);
+
+  // Returns the detected floors sorted by z. Takes time linear in the number
+  // of nodes added.
+  std::vector<Floor> GetFloors() const;
+
+ private:
+  // Median of a multiset of values, kept as a max-heap of the lower half and a
+  // min-heap of the upper half.
+  class RunningMedian {
+   public:
+    void Add(double value);
+    // Returns the element at index size() / 2 of the sorted values.
+    double median() const;
+    void AppendValues(std::vector<double>* values) const;
+
+   private:
+    std::vector<double> lower_;
+    std::vector<double> upper_;
+  };
+
+  // A span of consecutive nodes at a similar altitude.
+  struct Span {
+    common::Time start_time;
+    common::Time end_time;
+    Eigen::Vector2d last_xy;
+    // Length of the span in the xy-plane.
+    double length;
+    RunningMedian z_values;
+  };
+
+  // Union-find over spans which groups spans with similar median z. Spans are
+  // kept sorted by median, so each span only needs to be compared to its
+  // neighbors.
+  class Levels {
+   public:
+    void Add(int span_index, double median);
+    int Find(int span_index) const;
+
+   private:
+    void Union(int a, int b);
+
+    std::vector<int> parents_;
+    std::multimap<double, int> span_indices_by_median_;
+  };
+
+  std::vector<Span> spans_;
+  // Levels of all spans but the last one, whose median is not final yet.
+  Levels finished_levels_;
+};
+
 }  // namespace mapping
 }  // namespace cartographer
 
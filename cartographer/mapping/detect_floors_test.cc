@@ -0,0 +1,321 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cartographer/mapping/detect_floors.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include "Eigen/Core"
+#include "cartographer/transform/transform.h"
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+namespace cartographer {
+namespace mapping {
+namespace {
+
+// The batch implementation 'DetectFloors' had before 'FloorDetector' was
+// introduced. It re-slices the whole trajectory for every call and serves as
+// the reference the streaming implementation is checked against.
+namespace reference {
+
+constexpr double kMaxShortSpanLengthMeters = 25.;
+constexpr double kLevelHeightMeters = 2.5;
+constexpr double kMinLevelSeparationMeters = 1.;
+
+using Levels = std::map<int, int>;
+
+// Indices into 'trajectory.node', so that 'start_index' <= i < 'end_index'.
+struct Span {
+  int start_index;
+  int end_index;
+  std::vector<double> z_values;
+
+  bool operator<(const Span& other) const {
+    return std::forward_as_tuple(start_index, end_index) <
+           std::forward_as_tuple(other.start_index, other.end_index);
+  }
+};
+
+int LevelFind(const int i, const Levels& levels) {
+  auto it = levels.find(i);
+  CHECK(it != levels.end());
+  if (it->first == it->second) {
+    return it->second;
+  }
+  return LevelFind(it->second, levels);
+}
+
+void LevelUnion(int i, int j, Levels* levels) {
+  const int repr_i = LevelFind(i, *levels);
+  const int repr_j = LevelFind(j, *levels);
+  (*levels)[repr_i] = repr_j;
+}
+
+void InsertSorted(const double val, std::vector<double>* vals) {
+  vals->insert(std::upper_bound(vals->begin(), vals->end(), val), val);
+}
+
+double Median(const std::vector<double>& sorted) {
+  CHECK(!sorted.empty());
+  return sorted.at(sorted.size() / 2);
+}
+
+std::vector<Span> SliceByAltitudeChange(const proto::Trajectory& trajectory) {
+  CHECK_GT(trajectory.node_size(), 0);
+  std::vector<Span> spans;
+  spans.push_back(Span{0, 0, {trajectory.node(0).pose().translation().z()}});
+  for (int i = 1; i < trajectory.node_size(); ++i) {
+    const auto& node = trajectory.node(i);
+    const double z = node.pose().translation().z();
+    if (std::abs(Median(spans.back().z_values) - z) > kLevelHeightMeters) {
+      spans.push_back(Span{i, i, {}});
+    }
+    InsertSorted(z, &spans.back().z_values);
+    spans.back().end_index = i + 1;
+  }
+  return spans;
+}
+
+double SpanLength(const proto::Trajectory& trajectory, const Span& span) {
+  double length = 0;
+  for (int i = span.start_index + 1; i < span.end_index; ++i) {
+    const auto a =
+        transform::ToEigen(trajectory.node(i - 1).pose().translation());
+    const auto b = transform::ToEigen(trajectory.node(i).pose().translation());
+    length += (a - b).head<2>().norm();
+  }
+  return length;
+}
+
+bool IsShort(const proto::Trajectory& trajectory, const Span& span) {
+  return SpanLength(trajectory, span) < kMaxShortSpanLengthMeters;
+}
+
+void GroupSegmentsByAltitude(const std::vector<Span>& spans, Levels* levels) {
+  for (size_t i = 0; i < spans.size(); ++i) {
+    for (size_t j = i + 1; j < spans.size(); ++j) {
+      if (std::abs(Median(spans[i].z_values) - Median(spans[j].z_values)) <
+          kMinLevelSeparationMeters) {
+        LevelUnion(i, j, levels);
+      }
+    }
+  }
+}
+
+std::vector<Floor> FindFloors(const proto::Trajectory& trajectory,
+                              const std::vector<Span>& spans,
+                              const Levels& levels) {
+  std::map<int, std::vector<Span>> level_spans;
+  for (size_t i = 0; i < spans.size(); ++i) {
+    const Span& span = spans[i];
+    if (!IsShort(trajectory, span)) {
+      level_spans[LevelFind(i, levels)].push_back(span);
+    }
+  }
+  for (size_t i = 0; i < spans.size(); ++i) {
+    const Span& span = spans[i];
+    if (!IsShort(trajectory, span)) {
+      continue;
+    }
+    int level = LevelFind(i, levels);
+    if (!level_spans[level].empty()) {
+      level_spans[level].push_back(span);
+      continue;
+    }
+    size_t index = i - 1;
+    if (index < spans.size()) {
+      level_spans[LevelFind(index, levels)].push_back(span);
+    }
+    index = i + 1;
+    if (index < spans.size()) {
+      level_spans[LevelFind(index, levels)].push_back(span);
+    }
+  }
+
+  std::vector<Floor> floors;
+  for (auto& level : level_spans) {
+    if (level.second.empty()) {
+      continue;
+    }
+    std::vector<double> z_values;
+    std::sort(level.second.begin(), level.second.end());
+    floors.emplace_back();
+    for (const auto& span : level.second) {
+      if (!IsShort(trajectory, span)) {
+        z_values.insert(z_values.end(), span.z_values.begin(),
+                        span.z_values.end());
+      }
+      floors.back().timespans.push_back(Timespan{
+          common::FromUniversal(trajectory.node(span.start_index).timestamp()),
+          common::FromUniversal(
+              trajectory.node(span.end_index - 1).timestamp())});
+    }
+    if (!z_values.empty()) {
+      std::sort(z_values.begin(), z_values.end());
+      floors.back().z = Median(z_values);
+    } else {
+      floors.pop_back();
+    }
+  }
+  return floors;
+}
+
+std::vector<Floor> DetectFloors(const proto::Trajectory& trajectory) {
+  const std::vector<Span> spans = SliceByAltitudeChange(trajectory);
+  Levels levels;
+  for (size_t i = 0; i < spans.size(); ++i) {
+    levels[i] = i;
+  }
+  GroupSegmentsByAltitude(spans, &levels);
+  std::vector<Floor> floors = FindFloors(trajectory, spans, levels);
+  std::sort(floors.begin(), floors.end(),
+            [](const Floor& a, const Floor& b) { return a.z < b.z; });
+  return floors;
+}
+
+}  // namespace reference
+
+// Walks 50 m on the ground floor, takes the stairs to the first floor, walks
+// 50 m there and returns to the ground floor.
+proto::Trajectory CreateTwoFloorTrajectory() {
+  proto::Trajectory trajectory;
+  int64 timestamp = 0;
+  const auto add_node = [&trajectory, &timestamp](const double x,
+                                                  const double z) {
+    auto* const node = trajectory.add_node();
+    node->set_timestamp(++timestamp);
+    node->mutable_pose()->mutable_translation()->set_x(x);
+    node->mutable_pose()->mutable_translation()->set_z(z);
+    node->mutable_pose()->mutable_rotation()->set_w(1.);
+  };
+  for (int i = 0; i < 100; ++i) {
+    add_node(0.5 * i, 0.01 * (i % 3));
+  }
+  for (int i = 0; i < 10; ++i) {
+    add_node(50., 0.3 * i);
+  }
+  for (int i = 0; i < 100; ++i) {
+    add_node(50. - 0.5 * i, 3. + 0.01 * (i % 3));
+  }
+  for (int i = 0; i < 10; ++i) {
+    add_node(0., 3. - 0.3 * i);
+  }
+  for (int i = 0; i < 60; ++i) {
+    add_node(0.5 * i, 0.01 * (i % 3));
+  }
+  return trajectory;
+}
+
+// Walks randomly between three floors, with stairs of varying length and
+// pauses on a landing between two of the floors.
+proto::Trajectory CreateRandomTrajectory() {
+  std::mt19937 prng(42);
+  std::uniform_real_distribution<double> step_distribution(-0.5, 0.5);
+  std::uniform_int_distribution<int> floor_distribution(0, 2);
+  std::uniform_int_distribution<int> length_distribution(10, 120);
+  proto::Trajectory trajectory;
+  int64 timestamp = 0;
+  Eigen::Vector3d position = Eigen::Vector3d::Zero();
+  const auto add_node = [&trajectory, &timestamp, &position]() {
+    auto* const node = trajectory.add_node();
+    node->set_timestamp(++timestamp);
+    *node->mutable_pose()->mutable_translation() = transform::ToProto(position);
+    node->mutable_pose()->mutable_rotation()->set_w(1.);
+  };
+  int floor = 0;
+  for (int segment = 0; segment < 12; ++segment) {
+    const int num_nodes = length_distribution(prng);
+    for (int i = 0; i < num_nodes; ++i) {
+      position.x() += step_distribution(prng);
+      position.y() += step_distribution(prng);
+      position.z() = 3. * floor + 0.05 * step_distribution(prng);
+      add_node();
+    }
+    const int next_floor = floor_distribution(prng);
+    const double start_z = position.z();
+    const double end_z = 3. * next_floor;
+    for (int i = 1; i <= 10; ++i) {
+      position.z() = start_z + (end_z - start_z) * i / 10.;
+      if (i == 5) {
+        // A short stop on the landing.
+        for (int j = 0; j < 5; ++j) add_node();
+      }
+      add_node();
+    }
+    floor = next_floor;
+  }
+  return trajectory;
+}
+
+void ExpectFloorsEqual(const std::vector<Floor>& expected,
+                       const std::vector<Floor>& actual) {
+  ASSERT_EQ(expected.size(), actual.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(expected[i].z, actual[i].z);
+    ASSERT_EQ(expected[i].timespans.size(), actual[i].timespans.size());
+    for (size_t j = 0; j < expected[i].timespans.size(); ++j) {
+      EXPECT_EQ(expected[i].timespans[j].start, actual[i].timespans[j].start);
+      EXPECT_EQ(expected[i].timespans[j].end, actual[i].timespans[j].end);
+    }
+  }
+}
+
+// Compares 'FloorDetector' and 'DetectFloors' to the reference implementation
+// for every prefix of 'trajectory'.
+void ExpectMatchesReference(const proto::Trajectory& trajectory) {
+  FloorDetector floor_detector;
+  proto::Trajectory prefix;
+  for (const auto& node : trajectory.node()) {
+    floor_detector.AddNode(common::FromUniversal(node.timestamp()),
+                           transform::ToEigen(node.pose().translation()));
+    *prefix.add_node() = node;
+    const std::vector<Floor> expected = reference::DetectFloors(prefix);
+    SCOPED_TRACE(prefix.node_size());
+    ExpectFloorsEqual(expected, floor_detector.GetFloors());
+    ExpectFloorsEqual(expected, DetectFloors(prefix));
+  }
+}
+
+TEST(DetectFloorsTest, DetectsTwoFloors) {
+  const std::vector<Floor> floors = DetectFloors(CreateTwoFloorTrajectory());
+  ASSERT_EQ(floors.size(), 2);
+  EXPECT_NEAR(floors[0].z, 0., 0.02);
+  EXPECT_NEAR(floors[1].z, 3., 0.02);
+  EXPECT_EQ(floors[0].timespans.front().start, common::FromUniversal(1));
+  EXPECT_EQ(floors[0].timespans.back().end, common::FromUniversal(280));
+  EXPECT_GE(floors[0].timespans.size(), 2);
+  EXPECT_GE(floors[1].timespans.size(), 1);
+}
+
+TEST(DetectFloorsTest, TwoFloorsMatchReference) {
+  ExpectMatchesReference(CreateTwoFloorTrajectory());
+}
+
+TEST(DetectFloorsTest, RandomFloorsMatchReference) {
+  const proto::Trajectory trajectory = CreateRandomTrajectory();
+  ASSERT_GE(reference::DetectFloors(trajectory).size(), 2);
+  ExpectMatchesReference(trajectory);
+}
+
+}  // namespace
+}  // namespace mapping
+}  // namespace cartographer
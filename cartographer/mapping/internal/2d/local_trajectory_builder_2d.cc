@@ -89,10 +89,11 @@ std::unique_ptr<transform::Rigid2d> LocalTrajectoryBuilder2D::My_ScanMatch(
  
     auto pose_observation = absl::make_unique<transform::Rigid2d>();
     ceres::Solver::Summary summary;
-    ceres_scan_matcher_.Match(pose_prediction.translation(), initial_ceres_pose,
-                              filtered_gravity_aligned_point_cloud,
-                              *matching_submap->grid(), pose_observation.get(),
-                              &summary);
+    ceres_scan_matcher_.MatchCoarseToFine(
+        pose_prediction.translation(), initial_ceres_pose,
+        filtered_gravity_aligned_point_cloud,
+        matching_submap->GetGridsCoarseToFine(), pose_observation.get(),
+        &summary);
     if (pose_observation) {
       kCeresScanMatcherCostMetric->Observe(summary.final_cost);
       const double residual_distance =
@@ -167,10 +168,11 @@ std::unique_ptr<transform::Rigid2d> LocalTrajectoryBuilder2D::ScanMatch(
 
   auto pose_observation = absl::make_unique<transform::Rigid2d>();
   ceres::Solver::Summary summary;
-  ceres_scan_matcher_.Match(pose_prediction.translation(), initial_ceres_pose,
-                            filtered_gravity_aligned_point_cloud,
-                            *matching_submap->grid(), pose_observation.get(),
-                            &summary);
+  ceres_scan_matcher_.MatchCoarseToFine(
+      pose_prediction.translation(), initial_ceres_pose,
+      filtered_gravity_aligned_point_cloud,
+      matching_submap->GetGridsCoarseToFine(), pose_observation.get(),
+      &summary);
   if (pose_observation) {
     kCeresScanMatcherCostMetric->Observe(summary.final_cost);
     const double residual_distance =
@@ -78,12 +78,21 @@ proto::NormalEstimationOptions2D CreateNormalEstimationOptions2D(
 std::vector<float> EstimateNormals(
     const sensor::RangeData& range_data,
     const proto::NormalEstimationOptions2D& normal_estimation_options) {
+  return EstimateNormals(range_data, normal_estimation_options, 0,
+                         range_data.returns.size());
+}
+
+std::vector<float> EstimateNormals(
+    const sensor::RangeData& range_data,
+    const proto::NormalEstimationOptions2D& normal_estimation_options,
+    const size_t begin, const size_t end) {
+  CHECK_LE(begin, end);
+  CHECK_LE(end, range_data.returns.size());
   std::vector<float> normals;
-  normals.reserve(range_data.returns.size());
+  normals.reserve(end - begin);
   const size_t max_num_samples = normal_estimation_options.num_normal_samples();
   const float sample_radius = normal_estimation_options.sample_radius();
-  for (size_t current_point = 0; current_point < range_data.returns.size();
-       ++current_point) {
+  for (size_t current_point = begin; current_point < end; ++current_point) {
     const Eigen::Vector3f& hit = range_data.returns[current_point].position;
     size_t sample_window_begin = current_point;
     for (; sample_window_begin > 0 &&
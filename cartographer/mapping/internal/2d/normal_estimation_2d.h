@@ -37,6 +37,14 @@ std::vector<float> EstimateNormals(
     const sensor::RangeData& range_data,
     const proto::NormalEstimationOptions2D& normal_estimation_options);
 
+// Same as above, but only estimates the normals of the returns with indices in
+// ['begin', 'end'). Sample windows may still extend beyond this range, so
+// ranges can be processed independently, e.g. by different threads.
+std::vector<float> EstimateNormals(
+    const sensor::RangeData& range_data,
+    const proto::NormalEstimationOptions2D& normal_estimation_options,
+    size_t begin, size_t end);
+
 }  // namespace mapping
 }  // namespace cartographer
 
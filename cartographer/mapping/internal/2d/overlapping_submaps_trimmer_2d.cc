@@ -17,87 +17,23 @@
 #include "cartographer/mapping/internal/2d/overlapping_submaps_trimmer_2d.h"
 
 #include <algorithm>
+#include <cmath>
+#include <set>
 
-#include "cartographer/mapping/2d/submap_2d.h"
+#include "absl/memory/memory.h"
+#include "cartographer/transform/transform.h"
 
 namespace cartographer {
 namespace mapping {
 namespace {
 
-class SubmapCoverageGrid2D {
- public:
-  // Aliases for documentation only (no type-safety).
-  using CellId = std::pair<int64 /* x cells */, int64 /* y cells */>;
-  using StoredType = std::vector<std::pair<SubmapId, common::Time>>;
+// Submaps are rasterized again once any of their cell centers may have moved
+// by more than this fraction of the resolution.
+constexpr double kMaxCellDisplacementInResolutions = 0.25;
 
-  SubmapCoverageGrid2D(const MapLimits& map_limits)
-      : offset_(map_limits.max()), resolution_(map_limits.resolution()) {}
-
-  void AddPoint(const Eigen::Vector2d& point, const SubmapId& submap_id,
-                const common::Time& time) {
-    CellId cell_id{common::RoundToInt64((offset_(0) - point(0)) / resolution_),
-                   common::RoundToInt64((offset_(1) - point(1)) / resolution_)};
-    cells_[cell_id].emplace_back(submap_id, time);
-  }
-
-  const std::map<CellId, StoredType>& cells() const { return cells_; }
-  double resolution() const { return resolution_; }
-
- private:
-  Eigen::Vector2d offset_;
-  double resolution_;
-  std::map<CellId, StoredType> cells_;
-};
-
-// Iterates over every cell in a submap, transforms the center of the cell to
-// the global frame and then adds the submap id and the timestamp of the most
-// recent range data insertion into the global grid.
-std::set<SubmapId> AddSubmapsToSubmapCoverageGrid2D(
-    const std::map<SubmapId, common::Time>& submap_freshness,
-    const MapById<SubmapId, PoseGraphInterface::SubmapData>& submap_data,
-    SubmapCoverageGrid2D* coverage_grid) {
-  std::set<SubmapId> all_submap_ids;
-
-  for (const auto& submap : submap_data) {
-    auto freshness = submap_freshness.find(submap.id);
-    if (freshness == submap_freshness.end()) continue;
-    if (!submap.data.submap->insertion_finished()) continue;
-    all_submap_ids.insert(submap.id);
-    const Grid2D& grid =
-        *std::static_pointer_cast<const Submap2D>(submap.data.submap)->grid();
-    // Iterate over every cell in a submap.
-    Eigen::Array2i offset;
-    CellLimits cell_limits;
-    grid.ComputeCroppedLimits(&offset, &cell_limits);
-    if (cell_limits.num_x_cells == 0 || cell_limits.num_y_cells == 0) {
-      LOG(WARNING) << "Empty grid found in submap ID = " << submap.id;
-      continue;
-    }
-
-    const transform::Rigid3d& global_frame_from_submap_frame = submap.data.pose;
-    const transform::Rigid3d submap_frame_from_local_frame =
-        submap.data.submap->local_pose().inverse();
-    for (const Eigen::Array2i& xy_index : XYIndexRangeIterator(cell_limits)) {
-      const Eigen::Array2i index = xy_index + offset;
-      if (!grid.IsKnown(index)) continue;
-
-      const transform::Rigid3d center_of_cell_in_local_frame =
-          transform::Rigid3d::Translation(Eigen::Vector3d(
-              grid.limits().max().x() -
-                  grid.limits().resolution() * (index.y() + 0.5),
-              grid.limits().max().y() -
-                  grid.limits().resolution() * (index.x() + 0.5),
-              0));
-
-      const transform::Rigid2d center_of_cell_in_global_frame =
-          transform::Project2D(global_frame_from_submap_frame *
-                               submap_frame_from_local_frame *
-                               center_of_cell_in_local_frame);
-      coverage_grid->AddPoint(center_of_cell_in_global_frame.translation(),
-                              submap.id, freshness->second);
-    }
-  }
-  return all_submap_ids;
+bool CompareByTimeDescending(const std::pair<SubmapId, common::Time>& left,
+                             const std::pair<SubmapId, common::Time>& right) {
+  return left.second > right.second;
 }
 
 // Uses intra-submap constraints and trajectory node timestamps to identify time
@@ -148,23 +84,13 @@ std::vector<SubmapId> FindSubmapIdsToTrim(
     uint16 min_covered_cells_count) {
   std::map<SubmapId, uint16> submap_to_covered_cells_count;
   for (const auto& cell : coverage_grid.cells()) {
-    std::vector<std::pair<SubmapId, common::Time>> submaps_per_cell(
-        cell.second);
-
     // In case there are several submaps covering the cell, only the freshest
-    // submaps are kept.
-    if (submaps_per_cell.size() > fresh_submaps_count) {
-      // Sort by time in descending order.
-      std::sort(submaps_per_cell.begin(), submaps_per_cell.end(),
-                [](const std::pair<SubmapId, common::Time>& left,
-                   const std::pair<SubmapId, common::Time>& right) {
-                  return left.second > right.second;
-                });
-      submaps_per_cell.erase(submaps_per_cell.begin() + fresh_submaps_count,
-                             submaps_per_cell.end());
-    }
-    for (const std::pair<SubmapId, common::Time>& submap : submaps_per_cell) {
-      ++submap_to_covered_cells_count[submap.first];
+    // submaps are kept. Cells are already sorted by time in descending order.
+    const SubmapCoverageGrid2D::StoredType& submaps_per_cell = cell.second;
+    const size_t num_fresh_submaps = std::min<size_t>(
+        submaps_per_cell.size(), fresh_submaps_count);
+    for (size_t i = 0; i < num_fresh_submaps; ++i) {
+      ++submap_to_covered_cells_count[submaps_per_cell[i].first];
     }
   }
   std::vector<SubmapId> submap_ids_to_keep;
@@ -183,28 +109,188 @@ std::vector<SubmapId> FindSubmapIdsToTrim(
 
 }  // namespace
 
+SubmapCoverageGrid2D::SubmapCoverageGrid2D(const MapLimits& map_limits)
+    : offset_(map_limits.max()), resolution_(map_limits.resolution()) {}
+
+void SubmapCoverageGrid2D::AddOrUpdateSubmap(
+    const SubmapId& submap_id, const Submap2D& submap,
+    const transform::Rigid3d& global_submap_pose,
+    const common::Time freshness) {
+  const transform::Rigid2d global_from_local = transform::Project2D(
+      global_submap_pose * submap.local_pose().inverse());
+  auto it = submaps_.find(submap_id);
+  if (it == submaps_.end()) {
+    RasterizedSubmap& rasterized = submaps_[submap_id];
+    rasterized.global_from_local = global_from_local;
+    rasterized.freshness = freshness;
+    Rasterize(submap, &rasterized);
+    InsertCells(submap_id, rasterized);
+    return;
+  }
+
+  RasterizedSubmap& rasterized = it->second;
+  const transform::Rigid2d delta =
+      rasterized.global_from_local.inverse() * global_from_local;
+  const double max_cell_displacement =
+      delta.translation().norm() +
+      std::abs(delta.normalized_angle()) * rasterized.radius;
+  const bool moved =
+      max_cell_displacement > kMaxCellDisplacementInResolutions * resolution_;
+  if (!moved && rasterized.freshness == freshness) return;
+
+  EraseCells(submap_id, rasterized);
+  rasterized.freshness = freshness;
+  if (moved) {
+    rasterized.global_from_local = global_from_local;
+    Rasterize(submap, &rasterized);
+  }
+  InsertCells(submap_id, rasterized);
+}
+
+void SubmapCoverageGrid2D::RemoveSubmap(const SubmapId& submap_id) {
+  auto it = submaps_.find(submap_id);
+  if (it == submaps_.end()) return;
+  EraseCells(submap_id, it->second);
+  submaps_.erase(it);
+}
+
+std::vector<SubmapId> SubmapCoverageGrid2D::GetSubmapIds() const {
+  std::vector<SubmapId> submap_ids;
+  submap_ids.reserve(submaps_.size());
+  for (const auto& submap : submaps_) {
+    submap_ids.push_back(submap.first);
+  }
+  return submap_ids;
+}
+
+// Iterates over every known cell in a submap and computes the global cell
+// containing its center. The center of the cell at 'index' in the local frame
+// is an affine function of 'index', so instead of composing rigid transforms
+// per cell, the transform to the global frame is folded into an origin and one
+// step per index dimension.
+void SubmapCoverageGrid2D::Rasterize(const Submap2D& submap,
+                                     RasterizedSubmap* rasterized) const {
+  rasterized->cell_ids.clear();
+  rasterized->radius = 0.;
+  const Grid2D& grid = *submap.grid();
+  Eigen::Array2i offset;
+  CellLimits cell_limits;
+  grid.ComputeCroppedLimits(&offset, &cell_limits);
+  if (cell_limits.num_x_cells == 0 || cell_limits.num_y_cells == 0) {
+    LOG(WARNING) << "Empty grid found in submap.";
+    return;
+  }
+
+  const double grid_resolution = grid.limits().resolution();
+  const Eigen::Vector2d local_center_of_cell_0 =
+      grid.limits().max() - Eigen::Vector2d::Constant(0.5 * grid_resolution);
+  const Eigen::Vector2d local_step_x(0., -grid_resolution);
+  const Eigen::Vector2d local_step_y(-grid_resolution, 0.);
+  // Cell centers form a box, so the farthest one is at one of its corners.
+  for (const int x : {offset.x(), offset.x() + cell_limits.num_x_cells - 1}) {
+    for (const int y : {offset.y(), offset.y() + cell_limits.num_y_cells - 1}) {
+      rasterized->radius = std::max(
+          rasterized->radius,
+          (local_center_of_cell_0 + static_cast<double>(x) * local_step_x +
+           static_cast<double>(y) * local_step_y)
+              .norm());
+    }
+  }
+
+  const transform::Rigid2d& global_from_local = rasterized->global_from_local;
+  const Eigen::Matrix2d rotation =
+      global_from_local.rotation().toRotationMatrix();
+  const Eigen::Vector2d origin = global_from_local * local_center_of_cell_0;
+  const Eigen::Vector2d step_x = rotation * local_step_x;
+  const Eigen::Vector2d step_y = rotation * local_step_y;
+  for (const Eigen::Array2i& xy_index : XYIndexRangeIterator(cell_limits)) {
+    const Eigen::Array2i index = xy_index + offset;
+    if (!grid.IsKnown(index)) continue;
+    const Eigen::Vector2d center_of_cell_in_global_frame =
+        origin + static_cast<double>(index.x()) * step_x +
+        static_cast<double>(index.y()) * step_y;
+    rasterized->cell_ids.emplace_back(
+        common::RoundToInt64(
+            (offset_.x() - center_of_cell_in_global_frame.x()) / resolution_),
+        common::RoundToInt64(
+            (offset_.y() - center_of_cell_in_global_frame.y()) / resolution_));
+  }
+}
+
+void SubmapCoverageGrid2D::InsertCells(const SubmapId& submap_id,
+                                       const RasterizedSubmap& rasterized) {
+  const std::pair<SubmapId, common::Time> entry(submap_id,
+                                                rasterized.freshness);
+  for (const CellId& cell_id : rasterized.cell_ids) {
+    StoredType& submaps_per_cell = cells_[cell_id];
+    submaps_per_cell.insert(
+        std::upper_bound(submaps_per_cell.begin(), submaps_per_cell.end(),
+                         entry, CompareByTimeDescending),
+        entry);
+  }
+}
+
+void SubmapCoverageGrid2D::EraseCells(const SubmapId& submap_id,
+                                      const RasterizedSubmap& rasterized) {
+  for (const CellId& cell_id : rasterized.cell_ids) {
+    auto cell = cells_.find(cell_id);
+    // Cells covered several times by the same submap are erased on the
+    // first visit.
+    if (cell == cells_.end()) continue;
+    StoredType& submaps_per_cell = cell->second;
+    submaps_per_cell.erase(
+        std::remove_if(submaps_per_cell.begin(), submaps_per_cell.end(),
+                       [&submap_id](
+                           const std::pair<SubmapId, common::Time>& submap) {
+                         return submap.first == submap_id;
+                       }),
+        submaps_per_cell.end());
+    if (submaps_per_cell.empty()) cells_.erase(cell);
+  }
+}
+
 void OverlappingSubmapsTrimmer2D::Trim(Trimmable* pose_graph) {
   const auto submap_data = pose_graph->GetOptimizedSubmapData();
   if (submap_data.size() - current_submap_count_ <= min_added_submaps_count_) {
     return;
   }
 
-  const MapLimits first_submap_map_limits =
-      std::static_pointer_cast<const Submap2D>(submap_data.begin()->data.submap)
-          ->grid()
-          ->limits();
-  SubmapCoverageGrid2D coverage_grid(first_submap_map_limits);
+  if (coverage_grid_ == nullptr) {
+    coverage_grid_ = absl::make_unique<SubmapCoverageGrid2D>(
+        std::static_pointer_cast<const Submap2D>(
+            submap_data.begin()->data.submap)
+            ->grid()
+            ->limits());
+  }
   const std::map<SubmapId, common::Time> submap_freshness =
       ComputeSubmapFreshness(submap_data, pose_graph->GetTrajectoryNodes(),
                              pose_graph->GetConstraints());
-  const std::set<SubmapId> all_submap_ids = AddSubmapsToSubmapCoverageGrid2D(
-      submap_freshness, submap_data, &coverage_grid);
+  // Drop submaps which were trimmed elsewhere in the meantime.
+  for (const SubmapId& submap_id : coverage_grid_->GetSubmapIds()) {
+    if (submap_data.find(submap_id) == submap_data.end() ||
+        submap_freshness.count(submap_id) == 0) {
+      coverage_grid_->RemoveSubmap(submap_id);
+    }
+  }
+  std::set<SubmapId> all_submap_ids;
+  for (const auto& submap : submap_data) {
+    auto freshness = submap_freshness.find(submap.id);
+    if (freshness == submap_freshness.end()) continue;
+    if (!submap.data.submap->insertion_finished()) continue;
+    all_submap_ids.insert(submap.id);
+    const Submap2D& submap_2d =
+        *std::static_pointer_cast<const Submap2D>(submap.data.submap);
+    coverage_grid_->AddOrUpdateSubmap(submap.id, submap_2d, submap.data.pose,
+                                      freshness->second);
+  }
+
   const std::vector<SubmapId> submap_ids_to_remove = FindSubmapIdsToTrim(
-      coverage_grid, all_submap_ids, fresh_submaps_count_,
-      min_covered_area_ / common::Pow2(coverage_grid.resolution()));
+      *coverage_grid_, all_submap_ids, fresh_submaps_count_,
+      min_covered_area_ / common::Pow2(coverage_grid_->resolution()));
   current_submap_count_ = submap_data.size() - submap_ids_to_remove.size();
+  pose_graph->TrimSubmaps(submap_ids_to_remove);
   for (const SubmapId& id : submap_ids_to_remove) {
-    pose_graph->TrimSubmap(id);
+    coverage_grid_->RemoveSubmap(id);
   }
 }
 
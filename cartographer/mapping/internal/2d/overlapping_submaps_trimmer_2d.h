@@ -17,12 +17,73 @@
 #ifndef CARTOGRAPHER_MAPPING_INTERNAL_2D_OVERLAPPING_SUBMAPS_TRIMMER_H_
 #define CARTOGRAPHER_MAPPING_INTERNAL_2D_OVERLAPPING_SUBMAPS_TRIMMER_H_
 
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
 #include "cartographer/common/port.h"
+#include "cartographer/common/time.h"
+#include "cartographer/mapping/2d/map_limits.h"
+#include "cartographer/mapping/2d/submap_2d.h"
+#include "cartographer/mapping/id.h"
 #include "cartographer/mapping/pose_graph_trimmer.h"
+#include "cartographer/transform/rigid_transform.h"
 
 namespace cartographer {
 namespace mapping {
 
+// Global grid which stores for every cell the submaps covering it together with
+// the time of the most recent range data insertion into each of them.
+//
+// Submaps are rasterized when added and only rasterized again if their pose
+// changed enough to move any of their cells by a noticeable fraction of the
+// resolution, so keeping the grid up to date costs time proportional to the
+// area of new or moved submaps rather than to the area of the whole map.
+class SubmapCoverageGrid2D {
+ public:
+  // Aliases for documentation only (no type-safety).
+  using CellId = std::pair<int64 /* x cells */, int64 /* y cells */>;
+  // Sorted by time in descending order.
+  using StoredType = std::vector<std::pair<SubmapId, common::Time>>;
+
+  explicit SubmapCoverageGrid2D(const MapLimits& map_limits);
+
+  // Adds the known cells of 'submap' at 'global_submap_pose' to the grid, or
+  // updates them if 'submap_id' was added before.
+  void AddOrUpdateSubmap(const SubmapId& submap_id, const Submap2D& submap,
+                         const transform::Rigid3d& global_submap_pose,
+                         common::Time freshness);
+  void RemoveSubmap(const SubmapId& submap_id);
+
+  std::vector<SubmapId> GetSubmapIds() const;
+  const std::map<CellId, StoredType>& cells() const { return cells_; }
+  double resolution() const { return resolution_; }
+
+ private:
+  struct RasterizedSubmap {
+    // Transform from the local frame of the submap to the global frame used
+    // for rasterization.
+    transform::Rigid2d global_from_local;
+    // Upper bound on the distance of cell centers from the origin of the
+    // local frame.
+    double radius;
+    common::Time freshness;
+    std::vector<CellId> cell_ids;
+  };
+
+  void Rasterize(const Submap2D& submap, RasterizedSubmap* rasterized) const;
+  void InsertCells(const SubmapId& submap_id,
+                   const RasterizedSubmap& rasterized);
+  void EraseCells(const SubmapId& submap_id,
+                  const RasterizedSubmap& rasterized);
+
+  const Eigen::Vector2d offset_;
+  const double resolution_;
+  std::map<CellId, StoredType> cells_;
+  std::map<SubmapId, RasterizedSubmap> submaps_;
+};
+
 // Trims submaps that have less than 'min_covered_cells_count' cells not
 // overlapped by at least 'fresh_submaps_count` submaps.
 class OverlappingSubmapsTrimmer2D : public PoseGraphTrimmer {
@@ -49,6 +110,9 @@ class OverlappingSubmapsTrimmer2D : public PoseGraphTrimmer {
   uint16 current_submap_count_ = 0;
 
   bool finished_ = false;
+  // Coverage of all finished submaps seen so far. Created on the first call
+  // to 'Trim' that passes the 'min_added_submaps_count_' check.
+  std::unique_ptr<SubmapCoverageGrid2D> coverage_grid_;
 };
 
 }  // namespace mapping
@@ -32,6 +32,7 @@
 #include "absl/memory/memory.h"
 #include "cartographer/common/math.h"
 #include "cartographer/mapping/internal/2d/overlapping_submaps_trimmer_2d.h"
+#include "cartographer/mapping/internal/2d/scan_matching/scan_descriptor_2d.h"
 #include "cartographer/mapping/proto/pose_graph/constraint_builder_options.pb.h"
 #include "cartographer/sensor/compressed_point_cloud.h"
 #include "cartographer/sensor/internal/voxel_filter.h"
@@ -258,8 +259,9 @@ void PoseGraph2D::AddLandmarkData(int trajectory_id,
   });
 }
 
-void PoseGraph2D::ComputeConstraint(const NodeId& node_id,
-                                    const SubmapId& submap_id) {
+void PoseGraph2D::ComputeConstraint(
+    const NodeId& node_id, const SubmapId& submap_id,
+    const std::set<SubmapId>* const global_candidates) {
   bool maybe_add_local_constraint = false;
   bool maybe_add_global_constraint = false;
   const TrajectoryNode::Data* constant_data;
@@ -287,6 +289,8 @@ void PoseGraph2D::ComputeConstraint(const NodeId& node_id,
       // the submap's trajectory, it suffices to do a match constrained to a
       // local search window.
       maybe_add_local_constraint = true;
+    } else if (global_candidates != nullptr) {
+      maybe_add_global_constraint = global_candidates->count(submap_id) != 0;
     } else if (global_localization_samplers_[node_id.trajectory_id]->Pulse()) {
       maybe_add_global_constraint = true;
     }
@@ -316,6 +320,9 @@ WorkItem::Result PoseGraph2D::ComputeConstraintsForNode(
   std::vector<SubmapId> submap_ids;
   std::vector<SubmapId> finished_submap_ids;
   std::set<NodeId> newly_finished_submap_node_ids;
+  const bool use_place_recognition =
+      options_.global_constraint_search_num_submaps() > 0;
+  std::set<SubmapId> global_candidates;
   {
     absl::MutexLock locker(&mutex_);
     const auto& constant_data =
@@ -347,7 +354,7 @@ WorkItem::Result PoseGraph2D::ComputeConstraintsForNode(
       const transform::Rigid2d constraint_transform =
           constraints::ComputeSubmapPose(*insertion_submaps[i]).inverse() *
           local_pose_2d;
-      data_.constraints.push_back(
+      data_.constraints.Add(
           Constraint{submap_id,
                      node_id,
                      {transform::Embed3D(constraint_transform),
@@ -366,6 +373,21 @@ WorkItem::Result PoseGraph2D::ComputeConstraintsForNode(
         finished_submap_ids.emplace_back(submap_id_data.id);
       }
     }
+    // Sampled nodes are matched against the submaps of other trajectories
+    // which look most alike, instead of against random ones.
+    if (use_place_recognition &&
+        global_localization_samplers_[node_id.trajectory_id]->Pulse()) {
+      const Eigen::VectorXf descriptor =
+          scan_matching::ScanDescriptor2D::Compute(
+              constant_data->filtered_gravity_aligned_point_cloud);
+      for (const SubmapId& submap_id : place_recognition_index_.Query(
+               descriptor, options_.global_constraint_search_num_submaps(),
+               [&node_id](const SubmapId& submap_id) {
+                 return submap_id.trajectory_id != node_id.trajectory_id;
+               })) {
+        global_candidates.insert(submap_id);
+      }
+    }
     if (newly_finished_submap) {
       const SubmapId newly_finished_submap_id = submap_ids.front();
       InternalSubmapData& finished_submap_data =
@@ -373,11 +395,13 @@ WorkItem::Result PoseGraph2D::ComputeConstraintsForNode(
       CHECK(finished_submap_data.state == SubmapState::kNoConstraintSearch);
       finished_submap_data.state = SubmapState::kFinished;
       newly_finished_submap_node_ids = finished_submap_data.node_ids;
+      AddToPlaceRecognitionIndex(newly_finished_submap_id);
     }
   }
 
   for (const auto& submap_id : finished_submap_ids) {
-    ComputeConstraint(node_id, submap_id);
+    ComputeConstraint(node_id, submap_id,
+                      use_place_recognition ? &global_candidates : nullptr);
   }
 
   if (newly_finished_submap) {
@@ -387,20 +411,42 @@ WorkItem::Result PoseGraph2D::ComputeConstraintsForNode(
     for (const auto& node_id_data : optimization_problem_->node_data()) {
       const NodeId& node_id = node_id_data.id;
       if (newly_finished_submap_node_ids.count(node_id) == 0) {
-        ComputeConstraint(node_id, newly_finished_submap_id);
+        ComputeConstraint(node_id, newly_finished_submap_id,
+                          /*global_candidates=*/nullptr);
       }
     }
   }
   constraint_builder_.NotifyEndOfNode();
-  absl::MutexLock locker(&mutex_);
-  ++num_nodes_since_last_loop_closure_;
-  if (options_.optimize_every_n_nodes() > 0 &&
-      num_nodes_since_last_loop_closure_ > options_.optimize_every_n_nodes()) {
-    return WorkItem::Result::kRunOptimization;
+  {
+    absl::MutexLock locker(&mutex_);
+    ++num_nodes_since_last_loop_closure_;
+    if (options_.optimize_every_n_nodes() > 0 &&
+        num_nodes_since_last_loop_closure_ >
+            options_.optimize_every_n_nodes()) {
+      return WorkItem::Result::kRunOptimization;
+    }
+  }
+  if (options_.local_optimization_window_num_submaps() > 0) {
+    RunWindowedOptimization(node_id.trajectory_id);
   }
   return WorkItem::Result::kDoNotRunOptimization;
 }
 
+void PoseGraph2D::AddToPlaceRecognitionIndex(const SubmapId& submap_id) {
+  if (options_.global_constraint_search_num_submaps() <= 0) {
+    return;
+  }
+  const Submap2D* const submap = static_cast<const Submap2D*>(
+      data_.submap_data.at(submap_id).submap.get());
+  if (!submap->insertion_finished()) {
+    return;
+  }
+  const Eigen::VectorXf scan_descriptor = submap->scan_descriptor();
+  if (scan_descriptor.size() != 0) {
+    place_recognition_index_.Insert(submap_id, scan_descriptor);
+  }
+}
+
 common::Time PoseGraph2D::GetLatestNodeTime(const NodeId& node_id,
                                             const SubmapId& submap_id) const {
   common::Time time = data_.trajectory_nodes.at(node_id).constant_data->time;
@@ -431,10 +477,7 @@ void PoseGraph2D::DeleteTrajectoriesIfNeeded() {
         InternalTrajectoryState::DeletionState::WAIT_FOR_DELETION) {
       // TODO(gaschler): Consider directly deleting from data_, which may be
       // more complete.
-      auto submap_ids = trimming_handle.GetSubmapIds(it.first);
-      for (auto& submap_id : submap_ids) {
-        trimming_handle.TrimSubmap(submap_id);
-      }
+      trimming_handle.TrimSubmaps(trimming_handle.GetSubmapIds(it.first));
       it.second.state = TrajectoryState::DELETED;
       it.second.deletion_state = InternalTrajectoryState::DeletionState::NORMAL;
     }
@@ -445,8 +488,7 @@ void PoseGraph2D::HandleWorkQueue(
     const constraints::ConstraintBuilder2D::Result& result) {
   {
     absl::MutexLock locker(&mutex_);
-    data_.constraints.insert(data_.constraints.end(), result.begin(),
-                             result.end());
+    data_.constraints.Add(result);
   }
   RunOptimization();
 
@@ -497,16 +539,11 @@ void PoseGraph2D::HandleWorkQueue(
     // Update the gauges that count the current number of constraints.
     double inter_constraints_same_trajectory = 0;
     double inter_constraints_different_trajectory = 0;
-    for (const auto& constraint : data_.constraints) {
-      if (constraint.tag ==
-          cartographer::mapping::PoseGraph::Constraint::INTRA_SUBMAP) {
-        continue;
-      }
-      if (constraint.node_id.trajectory_id ==
-          constraint.submap_id.trajectory_id) {
-        ++inter_constraints_same_trajectory;
+    for (const auto& entry : data_.constraints.num_inter_submap_constraints()) {
+      if (entry.first.first == entry.first.second) {
+        inter_constraints_same_trajectory += entry.second;
       } else {
-        ++inter_constraints_different_trajectory;
+        inter_constraints_different_trajectory += entry.second;
       }
     }
     kConstraintsSameTrajectoryMetric->Set(inter_constraints_same_trajectory);
@@ -591,8 +628,7 @@ void PoseGraph2D::WaitForAllComputations() {
        &notification](const constraints::ConstraintBuilder2D::Result& result)
           LOCKS_EXCLUDED(mutex_) {
             absl::MutexLock locker(&mutex_);
-            data_.constraints.insert(data_.constraints.end(), result.begin(),
-                                     result.end());
+            data_.constraints.Add(result);
             notification = true;
           });
   const auto predicate = [&notification]() EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
@@ -640,6 +676,7 @@ void PoseGraph2D::FinishTrajectory(const int trajectory_id) {
 
     for (const auto& submap : data_.submap_data.trajectory(trajectory_id)) {
       data_.submap_data.at(submap.id).state = SubmapState::kFinished;
+      AddToPlaceRecognitionIndex(submap.id);
     }
     return WorkItem::Result::kRunOptimization;
   });
@@ -723,6 +760,7 @@ void PoseGraph2D::AddSubmapFromProto(
       [this, submap_id, global_submap_pose_2d]() LOCKS_EXCLUDED(mutex_) {
         absl::MutexLock locker(&mutex_);
         data_.submap_data.at(submap_id).state = SubmapState::kFinished;
+        AddToPlaceRecognitionIndex(submap_id);
         optimization_problem_->InsertSubmap(submap_id, global_submap_pose_2d);
         return WorkItem::Result::kDoNotRunOptimization;
       });
@@ -820,7 +858,7 @@ void PoseGraph2D::AddSerializedConstraints(
                   data_.trajectory_nodes.at(constraint.node_id)
                       .constant_data->gravity_alignment.inverse()),
           constraint.pose.translation_weight, constraint.pose.rotation_weight};
-      data_.constraints.push_back(Constraint{
+      data_.constraints.Add(Constraint{
           constraint.submap_id, constraint.node_id, pose, constraint.tag});
     }
     LOG(INFO) << "Loaded " << constraints.size() << " constraints.";
@@ -867,8 +905,8 @@ void PoseGraph2D::RunOptimization() {
   // data_.constraints, data_.frozen_trajectories and data_.landmark_nodes
   // when executing the Solve. Solve is time consuming, so not taking the mutex
   // before Solve to avoid blocking foreground processing.
-  optimization_problem_->Solve(data_.constraints, GetTrajectoryStates(),
-                               data_.landmark_nodes);
+  optimization_problem_->Solve(data_.constraints.vector(),
+                               GetTrajectoryStates(), data_.landmark_nodes);
   absl::MutexLock locker(&mutex_);
 
   const auto& submap_data = optimization_problem_->submap_data();
@@ -908,6 +946,88 @@ void PoseGraph2D::RunOptimization() {
   data_.global_submap_poses_2d = submap_data;
 }
 
+void PoseGraph2D::RunWindowedOptimization(const int trajectory_id) {
+  std::set<SubmapId> submap_ids;
+  std::set<NodeId> node_ids;
+  std::vector<Constraint> constraints;
+  {
+    absl::MutexLock locker(&mutex_);
+    if (IsTrajectoryFrozen(trajectory_id)) {
+      return;
+    }
+    const auto& submap_data = optimization_problem_->submap_data();
+    const auto begin = submap_data.BeginOfTrajectory(trajectory_id);
+    auto it = submap_data.EndOfTrajectory(trajectory_id);
+    for (int i = 0;
+         i != options_.local_optimization_window_num_submaps() && it != begin;
+         ++i) {
+      --it;
+      submap_ids.insert(it->id);
+      const std::set<NodeId>& submap_node_ids =
+          data_.submap_data.at(it->id).node_ids;
+      node_ids.insert(submap_node_ids.begin(), submap_node_ids.end());
+    }
+    // The index gives us the constraints touching the window without going
+    // through all of them.
+    for (const SubmapId& submap_id : submap_ids) {
+      const std::vector<Constraint> submap_constraints =
+          data_.constraints.GetSubmapConstraints(submap_id);
+      constraints.insert(constraints.end(), submap_constraints.begin(),
+                         submap_constraints.end());
+    }
+    for (const NodeId& node_id : node_ids) {
+      for (const Constraint& constraint :
+           data_.constraints.GetNodeConstraints(node_id)) {
+        // Constraints to submaps in the window have been added above.
+        if (submap_ids.count(constraint.submap_id) == 0) {
+          constraints.push_back(constraint);
+        }
+      }
+    }
+  }
+
+  // As in RunOptimization(), no other thread is accessing the
+  // 'optimization_problem_' while solving.
+  optimization_problem_->SolveWindow(constraints, submap_ids, node_ids);
+  absl::MutexLock locker(&mutex_);
+
+  const auto& submap_data = optimization_problem_->submap_data();
+  const auto& node_data = optimization_problem_->node_data();
+  for (const NodeId& node_id : node_ids) {
+    auto& mutable_trajectory_node = data_.trajectory_nodes.at(node_id);
+    mutable_trajectory_node.global_pose =
+        transform::Embed3D(node_data.at(node_id).global_pose_2d) *
+        transform::Rigid3d::Rotation(
+            mutable_trajectory_node.constant_data->gravity_alignment);
+  }
+
+  // Extrapolate all point cloud poses that were not included in the
+  // 'optimization_problem_' yet.
+  const auto local_to_old_global = ComputeLocalToGlobalTransform(
+      data_.global_submap_poses_2d, trajectory_id);
+  for (const SubmapId& submap_id : submap_ids) {
+    if (data_.global_submap_poses_2d.Contains(submap_id)) {
+      data_.global_submap_poses_2d.at(submap_id) = submap_data.at(submap_id);
+    } else {
+      data_.global_submap_poses_2d.Insert(submap_id, submap_data.at(submap_id));
+    }
+  }
+  const auto local_to_new_global = ComputeLocalToGlobalTransform(
+      data_.global_submap_poses_2d, trajectory_id);
+  const transform::Rigid3d old_global_to_new_global =
+      local_to_new_global * local_to_old_global.inverse();
+  const NodeId last_optimized_node_id =
+      std::prev(node_data.EndOfTrajectory(trajectory_id))->id;
+  for (auto node_it =
+           std::next(data_.trajectory_nodes.find(last_optimized_node_id));
+       node_it != data_.trajectory_nodes.EndOfTrajectory(trajectory_id);
+       ++node_it) {
+    auto& mutable_trajectory_node = data_.trajectory_nodes.at(node_it->id);
+    mutable_trajectory_node.global_pose =
+        old_global_to_new_global * mutable_trajectory_node.global_pose;
+  }
+}
+
 bool PoseGraph2D::CanAddWorkItemModifying(int trajectory_id) {
   auto it = data_.trajectories_state.find(trajectory_id);
   if (it == data_.trajectories_state.end()) {
@@ -1192,7 +1312,7 @@ PoseGraph2D::TrimmingHandle::GetTrajectoryNodes() const {
 
 const std::vector<PoseGraphInterface::Constraint>&
 PoseGraph2D::TrimmingHandle::GetConstraints() const {
-  return parent_->data_.constraints;
+  return parent_->data_.constraints.vector();
 }
 
 bool PoseGraph2D::TrimmingHandle::IsFinished(const int trajectory_id) const {
@@ -1205,89 +1325,77 @@ void PoseGraph2D::TrimmingHandle::SetTrajectoryState(int trajectory_id,
 }
 
 void PoseGraph2D::TrimmingHandle::TrimSubmap(const SubmapId& submap_id) {
-  // TODO(hrapp): We have to make sure that the trajectory has been finished
-  // if we want to delete the last submaps.
-  CHECK(parent_->data_.submap_data.at(submap_id).state ==
-        SubmapState::kFinished);
+  TrimSubmaps({submap_id});
+}
 
-  // Compile all nodes that are still INTRA_SUBMAP constrained to other submaps
-  // once the submap with 'submap_id' is gone.
-  // We need to use node_ids instead of constraints here to be also compatible
-  // with frozen trajectories that don't have intra-constraints.
-  std::set<NodeId> nodes_to_retain;
-  for (const auto& submap_data : parent_->data_.submap_data) {
-    if (submap_data.id != submap_id) {
-      nodes_to_retain.insert(submap_data.data.node_ids.begin(),
-                             submap_data.data.node_ids.end());
-    }
+void PoseGraph2D::TrimmingHandle::TrimSubmaps(
+    const std::vector<SubmapId>& submap_ids) {
+  const std::set<SubmapId> submaps_to_remove(submap_ids.begin(),
+                                             submap_ids.end());
+  if (submaps_to_remove.empty()) {
+    return;
   }
 
-  // Remove all nodes that are exlusively associated to 'submap_id'.
+  // TODO(hrapp): We have to make sure that the trajectory has been finished
+  // if we want to delete the last submaps.
   std::set<NodeId> nodes_to_remove;
-  std::set_difference(parent_->data_.submap_data.at(submap_id).node_ids.begin(),
-                      parent_->data_.submap_data.at(submap_id).node_ids.end(),
-                      nodes_to_retain.begin(), nodes_to_retain.end(),
-                      std::inserter(nodes_to_remove, nodes_to_remove.begin()));
+  for (const SubmapId& submap_id : submaps_to_remove) {
+    const InternalSubmapData& submap_data =
+        parent_->data_.submap_data.at(submap_id);
+    CHECK(submap_data.state == SubmapState::kFinished);
+    nodes_to_remove.insert(submap_data.node_ids.begin(),
+                           submap_data.node_ids.end());
+  }
 
-  // Remove all 'data_.constraints' related to 'submap_id'.
-  {
-    std::vector<Constraint> constraints;
-    for (const Constraint& constraint : parent_->data_.constraints) {
-      if (constraint.submap_id != submap_id) {
-        constraints.push_back(constraint);
+  // Keep all nodes that are still INTRA_SUBMAP constrained to other submaps
+  // once the submaps in 'submaps_to_remove' are gone.
+  // We need to use node_ids instead of constraints here to be also compatible
+  // with frozen trajectories that don't have intra-constraints. Since the
+  // node IDs of each submap are sorted, only the part of each set between the
+  // first and the last node to remove needs to be visited.
+  if (!nodes_to_remove.empty()) {
+    const NodeId first_node_id = *nodes_to_remove.begin();
+    const NodeId last_node_id = *nodes_to_remove.rbegin();
+    for (const auto& submap_data : parent_->data_.submap_data) {
+      if (submaps_to_remove.count(submap_data.id) != 0) {
+        continue;
+      }
+      const std::set<NodeId>& node_ids = submap_data.data.node_ids;
+      for (auto it = node_ids.lower_bound(first_node_id);
+           it != node_ids.end() && !(last_node_id < *it); ++it) {
+        nodes_to_remove.erase(*it);
       }
     }
-    parent_->data_.constraints = std::move(constraints);
   }
 
-  // Remove all 'data_.constraints' related to 'nodes_to_remove'.
+  // Remove all 'data_.constraints' related to 'submaps_to_remove' or
+  // 'nodes_to_remove'.
   // If the removal lets other submaps lose all their inter-submap constraints,
   // delete their corresponding constraint submap matchers to save memory.
-  {
-    std::vector<Constraint> constraints;
-    std::set<SubmapId> other_submap_ids_losing_constraints;
-    for (const Constraint& constraint : parent_->data_.constraints) {
-      if (nodes_to_remove.count(constraint.node_id) == 0) {
-        constraints.push_back(constraint);
-      } else {
-        // A constraint to another submap will be removed, mark it as affected.
-        other_submap_ids_losing_constraints.insert(constraint.submap_id);
-      }
-    }
-    parent_->data_.constraints = std::move(constraints);
-    // Go through the remaining constraints to ensure we only delete scan
-    // matchers of other submaps that have no inter-submap constraints left.
-    for (const Constraint& constraint : parent_->data_.constraints) {
-      if (constraint.tag == Constraint::Tag::INTRA_SUBMAP) {
-        continue;
-      } else if (other_submap_ids_losing_constraints.count(
-                     constraint.submap_id)) {
-        // This submap still has inter-submap constraints - ignore it.
-        other_submap_ids_losing_constraints.erase(constraint.submap_id);
-      }
-    }
-    // Delete scan matchers of the submaps that lost all constraints.
-    // TODO(wohe): An improvement to this implementation would be to add the
-    // caching logic at the constraint builder which could keep around only
-    // recently used scan matchers.
-    for (const SubmapId& submap_id : other_submap_ids_losing_constraints) {
+  // TODO(wohe): An improvement to this implementation would be to add the
+  // caching logic at the constraint builder which could keep around only
+  // recently used scan matchers.
+  for (const SubmapId& submap_id :
+       parent_->data_.constraints.Remove(submaps_to_remove, nodes_to_remove)) {
+    if (!parent_->data_.constraints.HasInterSubmapConstraints(submap_id)) {
       parent_->constraint_builder_.DeleteScanMatcher(submap_id);
     }
   }
 
-  // Mark the submap with 'submap_id' as trimmed and remove its data.
-  CHECK(parent_->data_.submap_data.at(submap_id).state ==
-        SubmapState::kFinished);
-  parent_->data_.submap_data.Trim(submap_id);
-  parent_->constraint_builder_.DeleteScanMatcher(submap_id);
-  parent_->optimization_problem_->TrimSubmap(submap_id);
-
-  // We have one submap less, update the gauge metrics.
-  kDeletedSubmapsMetric->Increment();
-  if (parent_->IsTrajectoryFrozen(submap_id.trajectory_id)) {
-    kFrozenSubmapsMetric->Decrement();
-  } else {
-    kActiveSubmapsMetric->Decrement();
+  // Mark the submaps in 'submaps_to_remove' as trimmed and remove their data.
+  for (const SubmapId& submap_id : submaps_to_remove) {
+    parent_->data_.submap_data.Trim(submap_id);
+    parent_->constraint_builder_.DeleteScanMatcher(submap_id);
+    parent_->place_recognition_index_.Erase(submap_id);
+    parent_->optimization_problem_->TrimSubmap(submap_id);
+
+    // We have one submap less, update the gauge metrics.
+    kDeletedSubmapsMetric->Increment();
+    if (parent_->IsTrajectoryFrozen(submap_id.trajectory_id)) {
+      kFrozenSubmapsMetric->Decrement();
+    } else {
+      kActiveSubmapsMetric->Decrement();
+    }
   }
 
   // Remove the 'nodes_to_remove' from the pose graph and the optimization
@@ -34,6 +34,7 @@
 #include "cartographer/common/time.h"
 #include "cartographer/mapping/2d/submap_2d.h"
 #include "cartographer/mapping/internal/constraints/constraint_builder_2d.h"
+#include "cartographer/mapping/internal/constraints/place_recognition_index.h"
 #include "cartographer/mapping/internal/optimization/optimization_problem_2d.h"
 #include "cartographer/mapping/internal/pose_graph_data.h"
 #include "cartographer/mapping/internal/trajectory_connectivity_state.h"
@@ -192,10 +193,18 @@ class PoseGraph2D : public PoseGraph {
       std::vector<std::shared_ptr<const Submap2D>> insertion_submaps,
       bool newly_finished_submap) LOCKS_EXCLUDED(mutex_);
 
-  // Computes constraints for a node and submap pair.
-  void ComputeConstraint(const NodeId& node_id, const SubmapId& submap_id)
+  // Computes constraints for a node and submap pair. If 'global_candidates'
+  // is not null, a global constraint is searched if and only if 'submap_id' is
+  // among them, instead of sampling.
+  void ComputeConstraint(const NodeId& node_id, const SubmapId& submap_id,
+                         const std::set<SubmapId>* global_candidates)
       LOCKS_EXCLUDED(mutex_);
 
+  // Adds the finished submap 'submap_id' to 'place_recognition_index_' if
+  // 'global_constraint_search_num_submaps' is positive.
+  void AddToPlaceRecognitionIndex(const SubmapId& submap_id)
+      EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
   // Deletes trajectories waiting for deletion. Must not be called during
   // constraint search.
   void DeleteTrajectoriesIfNeeded() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
@@ -218,6 +227,11 @@ class PoseGraph2D : public PoseGraph {
   // optimization being run at a time.
   void RunOptimization() LOCKS_EXCLUDED(mutex_);
 
+  // Optimizes the most recent submaps of 'trajectory_id' and their nodes, see
+  // 'local_optimization_window_num_submaps'. Must only be called from a work
+  // item, so that it does not run concurrently with RunOptimization().
+  void RunWindowedOptimization(int trajectory_id) LOCKS_EXCLUDED(mutex_);
+
   bool CanAddWorkItemModifying(int trajectory_id)
       EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
@@ -251,6 +265,11 @@ class PoseGraph2D : public PoseGraph {
   absl::flat_hash_map<int, std::unique_ptr<common::FixedRatioSampler>>
       global_localization_samplers_ GUARDED_BY(mutex_);
 
+  // Scan descriptors of the finished submaps, see
+  // 'global_constraint_search_num_submaps'.
+  constraints::PlaceRecognitionIndex place_recognition_index_
+      GUARDED_BY(mutex_);
+
   // Number of nodes added since last loop closure.
   int num_nodes_since_last_loop_closure_ GUARDED_BY(mutex_) = 0;
 
@@ -285,6 +304,8 @@ class PoseGraph2D : public PoseGraph {
         EXCLUSIVE_LOCKS_REQUIRED(parent_->mutex_);
     void TrimSubmap(const SubmapId& submap_id)
         EXCLUSIVE_LOCKS_REQUIRED(parent_->mutex_) override;
+    void TrimSubmaps(const std::vector<SubmapId>& submap_ids)
+        EXCLUSIVE_LOCKS_REQUIRED(parent_->mutex_) override;
     bool IsFinished(int trajectory_id) const override
         EXCLUSIVE_LOCKS_REQUIRED(parent_->mutex_);
     void SetTrajectoryState(int trajectory_id, TrajectoryState state) override
@@ -75,8 +75,10 @@ class PoseGraph2DTest : public ::testing::Test {
               update_weight_range_exponent = 0,
               update_weight_angle_scan_normal_to_ray_kernel_bandwidth = 0,
               update_weight_distance_cell_to_hit_kernel_bandwidth = 0,
+              num_threads = 1,
             },
           },
+          num_pyramid_levels = 0,
         })text");
       active_submaps_ = absl::make_unique<ActiveSubmaps2D>(
           mapping::CreateSubmapsOptions2D(parameter_dictionary.get()));
@@ -94,6 +96,7 @@ class PoseGraph2DTest : public ::testing::Test {
               loop_closure_translation_weight = 1.,
               loop_closure_rotation_weight = 1.,
               log_matches = true,
+              min_scan_descriptor_similarity_2d = 0.,
               fast_correlative_scan_matcher = {
                 linear_search_window = 3.,
                 angular_search_window = 0.1,
@@ -146,6 +149,7 @@ class PoseGraph2DTest : public ::testing::Test {
               fixed_frame_pose_tolerant_loss_param_a = 1,
               fixed_frame_pose_tolerant_loss_param_b = 1,
               log_solver_summary = true,
+              discard_unused_sensor_data = false,
               use_online_imu_extrinsics_in_3d = true,
               fix_z_in_3d = false,
               ceres_solver_options = {
@@ -158,6 +162,8 @@ class PoseGraph2DTest : public ::testing::Test {
             global_sampling_ratio = 0.01,
             log_residual_histograms = true,
             global_constraint_search_after_n_seconds = 10.0,
+            local_optimization_window_num_submaps = 0,
+            global_constraint_search_num_submaps = 0,
           })text");
       auto options = CreatePoseGraphOptions(parameter_dictionary.get());
       pose_graph_ = absl::make_unique<PoseGraph2D>(
@@ -27,6 +27,7 @@
 #include "cartographer/mapping/internal/2d/scan_matching/rotation_delta_cost_functor_2d.h"
 #include "cartographer/mapping/internal/2d/scan_matching/translation_delta_cost_functor_2d.h"
 #include "cartographer/mapping/internal/2d/scan_matching/tsdf_match_cost_function_2d.h"
+#include "cartographer/sensor/internal/voxel_filter.h"
 #include "cartographer/transform/transform.h"
 #include "ceres/ceres.h"
 #include "glog/logging.h"
@@ -69,6 +70,42 @@ void CeresScanMatcher2D::Match(const Eigen::Vector2d& target_translation,
   double ceres_pose_estimate[3] = {initial_pose_estimate.translation().x(),
                                    initial_pose_estimate.translation().y(),
                                    initial_pose_estimate.rotation().angle()};
+  Solve(target_translation, initial_pose_estimate.rotation().angle(),
+        point_cloud, grid, ceres_pose_estimate, summary);
+  *pose_estimate = transform::Rigid2d(
+      {ceres_pose_estimate[0], ceres_pose_estimate[1]}, ceres_pose_estimate[2]);
+}
+
+void CeresScanMatcher2D::MatchCoarseToFine(
+    const Eigen::Vector2d& target_translation,
+    const transform::Rigid2d& initial_pose_estimate,
+    const sensor::PointCloud& point_cloud,
+    const std::vector<const Grid2D*>& grids,
+    transform::Rigid2d* const pose_estimate,
+    ceres::Solver::Summary* const summary) const {
+  CHECK(!grids.empty());
+  double ceres_pose_estimate[3] = {initial_pose_estimate.translation().x(),
+                                   initial_pose_estimate.translation().y(),
+                                   initial_pose_estimate.rotation().angle()};
+  for (size_t i = 0; i + 1 < grids.size(); ++i) {
+    const Grid2D& coarse_grid = *grids[i];
+    ceres::Solver::Summary coarse_summary;
+    Solve(target_translation, initial_pose_estimate.rotation().angle(),
+          sensor::VoxelFilter(point_cloud, coarse_grid.limits().resolution()),
+          coarse_grid, ceres_pose_estimate, &coarse_summary);
+  }
+  Solve(target_translation, initial_pose_estimate.rotation().angle(),
+        point_cloud, *grids.back(), ceres_pose_estimate, summary);
+  *pose_estimate = transform::Rigid2d(
+      {ceres_pose_estimate[0], ceres_pose_estimate[1]}, ceres_pose_estimate[2]);
+}
+
+void CeresScanMatcher2D::Solve(const Eigen::Vector2d& target_translation,
+                               const double target_angle,
+                               const sensor::PointCloud& point_cloud,
+                               const Grid2D& grid,
+                               double* const ceres_pose_estimate,
+                               ceres::Solver::Summary* const summary) const {
   ceres::Problem problem;
   CHECK_GT(options_.occupied_space_weight(), 0.);
   switch (grid.GetGridType()) {
@@ -97,13 +134,10 @@ void CeresScanMatcher2D::Match(const Eigen::Vector2d& target_translation,
   CHECK_GT(options_.rotation_weight(), 0.);
   problem.AddResidualBlock(
       RotationDeltaCostFunctor2D::CreateAutoDiffCostFunction(
-          options_.rotation_weight(), ceres_pose_estimate[2]),
+          options_.rotation_weight(), target_angle),
       nullptr /* loss function */, ceres_pose_estimate);
 
   ceres::Solve(ceres_solver_options_, &problem, summary);
-
-  *pose_estimate = transform::Rigid2d(
-      {ceres_pose_estimate[0], ceres_pose_estimate[1]}, ceres_pose_estimate[2]);
 }
 
 }  // namespace scan_matching
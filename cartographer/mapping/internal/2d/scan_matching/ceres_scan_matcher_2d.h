@@ -52,7 +52,26 @@ class CeresScanMatcher2D {
              transform::Rigid2d* pose_estimate,
              ceres::Solver::Summary* summary) const;
 
+  // Like Match(), but aligns 'point_cloud' within each of 'grids' in turn,
+  // which are ordered from coarsest to finest. The pose found in one grid is
+  // the initial estimate in the next. In all but the finest grid, the
+  // 'point_cloud' is reduced to one point per cell. 'summary' is that of the
+  // finest grid.
+  void MatchCoarseToFine(const Eigen::Vector2d& target_translation,
+                         const transform::Rigid2d& initial_pose_estimate,
+                         const sensor::PointCloud& point_cloud,
+                         const std::vector<const Grid2D*>& grids,
+                         transform::Rigid2d* pose_estimate,
+                         ceres::Solver::Summary* summary) const;
+
  private:
+  // Optimizes 'ceres_pose_estimate' in place. The rotation is kept close to
+  // 'target_angle'.
+  void Solve(const Eigen::Vector2d& target_translation, double target_angle,
+             const sensor::PointCloud& point_cloud, const Grid2D& grid,
+             double* ceres_pose_estimate,
+             ceres::Solver::Summary* summary) const;
+
   const proto::CeresScanMatcherOptions2D options_;
   ceres::Solver::Options ceres_solver_options_;
 };
@@ -22,6 +22,7 @@
 #include "cartographer/common/internal/testing/lua_parameter_dictionary_test_helpers.h"
 #include "cartographer/common/lua_parameter_dictionary.h"
 #include "cartographer/mapping/2d/probability_grid.h"
+#include "cartographer/mapping/2d/probability_grid_pyramid.h"
 #include "cartographer/mapping/probability_values.h"
 #include "cartographer/sensor/point_cloud.h"
 #include "cartographer/transform/rigid_transform_test_helpers.h"
@@ -55,9 +56,8 @@ class CeresScanMatcherTest : public ::testing::Test {
             num_threads = 1,
           },
         })text");
-    const proto::CeresScanMatcherOptions2D options =
-        CreateCeresScanMatcherOptions2D(parameter_dictionary.get());
-    ceres_scan_matcher_ = absl::make_unique<CeresScanMatcher2D>(options);
+    options_ = CreateCeresScanMatcherOptions2D(parameter_dictionary.get());
+    ceres_scan_matcher_ = absl::make_unique<CeresScanMatcher2D>(options_);
   }
 
   void TestFromInitialPose(const transform::Rigid2d& initial_pose) {
@@ -77,6 +77,7 @@ class CeresScanMatcherTest : public ::testing::Test {
   ValueConversionTables conversion_tables_;
   ProbabilityGrid probability_grid_;
   sensor::PointCloud point_cloud_;
+  proto::CeresScanMatcherOptions2D options_;
   std::unique_ptr<CeresScanMatcher2D> ceres_scan_matcher_;
 };
 
@@ -96,6 +97,39 @@ TEST_F(CeresScanMatcherTest, testOptimizeAlongXY) {
   TestFromInitialPose(transform::Rigid2d::Translation({-0.3, 0.3}));
 }
 
+TEST_F(CeresScanMatcherTest, testCoarseToFine) {
+  // The initial pose is 2.5 m off along X. The bicubic interpolation of the
+  // fine grid only sees the occupied cell from less than 2 cells away, so
+  // matching against it alone does not move. The coarse level has 2 m cells
+  // and brings the pose close enough for the fine grid. A weaker translation
+  // weight keeps the result from being pulled back towards the initial pose.
+  options_.set_translation_weight(0.01);
+  const CeresScanMatcher2D ceres_scan_matcher(options_);
+  const ProbabilityGridPyramid pyramid(
+      probability_grid_, 1 /* num_levels */, &conversion_tables_);
+  const transform::Rigid2d initial_pose =
+      transform::Rigid2d::Translation({2., 0.5});
+  const transform::Rigid2d expected_pose =
+      transform::Rigid2d::Translation({-0.5, 0.5});
+  transform::Rigid2d pose;
+  ceres::Solver::Summary summary;
+
+  ceres_scan_matcher.Match(initial_pose.translation(), initial_pose,
+                           point_cloud_, probability_grid_, &pose, &summary);
+  EXPECT_LT(0.1, summary.final_cost) << summary.FullReport();
+  EXPECT_THAT(pose, transform::IsNearly(initial_pose, 1e-2))
+      << "Actual: " << transform::ToProto(pose).DebugString()
+      << "\nExpected: " << transform::ToProto(initial_pose).DebugString();
+
+  ceres_scan_matcher.MatchCoarseToFine(
+      initial_pose.translation(), initial_pose, point_cloud_,
+      {&pyramid.level(0), &probability_grid_}, &pose, &summary);
+  EXPECT_NEAR(0., summary.final_cost, 1e-2) << summary.FullReport();
+  EXPECT_THAT(pose, transform::IsNearly(expected_pose, 1e-2))
+      << "Actual: " << transform::ToProto(pose).DebugString()
+      << "\nExpected: " << transform::ToProto(expected_pose).DebugString();
+}
+
 }  // namespace
 }  // namespace scan_matching
 }  // namespace mapping
@@ -44,6 +44,8 @@ CreateRealTimeCorrelativeScanMatcherTestOptions2D() {
       "angular_search_window = 0.16, "
       "translation_delta_cost_weight = 0., "
       "rotation_delta_cost_weight = 0., "
+      "batched_evaluation_3d = false, "
+      "num_threads_3d = 1, "
       "}");
   return CreateRealTimeCorrelativeScanMatcherOptions(
       parameter_dictionary.get());
@@ -82,6 +84,7 @@ class RealTimeCorrelativeScanMatcherTest : public ::testing::Test {
         update_weight_range_exponent = 0,
         update_weight_angle_scan_normal_to_ray_kernel_bandwidth = 0.5,
         update_weight_distance_cell_to_hit_kernel_bandwidth = 0.5,
+        num_threads = 1,
       })text");
       range_data_inserter_ = absl::make_unique<TSDFRangeDataInserter2D>(
           CreateTSDFRangeDataInserterOptions2D(parameter_dictionary.get()));
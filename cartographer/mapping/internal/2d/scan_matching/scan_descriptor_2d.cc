@@ -0,0 +1,116 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cartographer/mapping/internal/2d/scan_matching/scan_descriptor_2d.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "cartographer/common/math.h"
+#include "glog/logging.h"
+
+namespace cartographer {
+namespace mapping {
+namespace scan_matching {
+namespace {
+
+constexpr int kNumSectors = 180;
+constexpr float kRangeBucketWidth = 0.5f;
+constexpr int kNumRangeBuckets = 40;
+constexpr float kMaxRange = kRangeBucketWidth * kNumRangeBuckets;
+
+// Sector 0 is centered at an angle of -pi.
+int GetSector(const float angle) {
+  return common::RoundToInt((angle + M_PI) / (2. * M_PI) * kNumSectors) %
+         kNumSectors;
+}
+
+// Builds the histogram from the range of each sector. Ranges not below
+// 'kMaxRange' are ignored.
+Eigen::VectorXf ComputeHistogram(const std::vector<float>& sector_ranges) {
+  Eigen::VectorXf histogram = Eigen::VectorXf::Zero(kNumRangeBuckets);
+  for (const float range : sector_ranges) {
+    if (range < kMaxRange) {
+      histogram[static_cast<int>(range / kRangeBucketWidth)] += 1.f;
+    }
+  }
+  const float sum = histogram.sum();
+  if (sum > 0.f) {
+    histogram /= sum;
+  }
+  return histogram;
+}
+
+}  // namespace
+
+Eigen::VectorXf ScanDescriptor2D::Compute(
+    const sensor::PointCloud& point_cloud) {
+  std::vector<float> sector_ranges(kNumSectors,
+                                   std::numeric_limits<float>::infinity());
+  for (const sensor::RangefinderPoint& point : point_cloud) {
+    const Eigen::Vector2f position = point.position.head<2>();
+    const float range = position.norm();
+    if (range == 0.f) {
+      continue;
+    }
+    float& sector_range =
+        sector_ranges[GetSector(std::atan2(position.y(), position.x()))];
+    sector_range = std::min(sector_range, range);
+  }
+  return ComputeHistogram(sector_ranges);
+}
+
+Eigen::VectorXf ScanDescriptor2D::Compute(const Grid2D& grid,
+                                          const Eigen::Vector2f& origin) {
+  const MapLimits& limits = grid.limits();
+  const float step = 0.5f * limits.resolution();
+  const int num_steps = common::RoundToInt(kMaxRange / step);
+  std::vector<float> sector_ranges(kNumSectors,
+                                   std::numeric_limits<float>::infinity());
+  for (int sector = 0; sector != kNumSectors; ++sector) {
+    const float angle = 2.f * M_PI * sector / kNumSectors - M_PI;
+    const Eigen::Vector2f direction(std::cos(angle), std::sin(angle));
+    for (int i = 1; i <= num_steps; ++i) {
+      const Eigen::Array2i cell_index =
+          limits.GetCellIndex(origin + i * step * direction);
+      if (!limits.Contains(cell_index)) {
+        break;
+      }
+      // Unknown cells have the maximum correspondence cost, so this only
+      // accepts cells observed to be occupied.
+      if (grid.GetCorrespondenceCost(cell_index) < 0.5f) {
+        sector_ranges[sector] = i * step;
+        break;
+      }
+    }
+  }
+  return ComputeHistogram(sector_ranges);
+}
+
+float ScanDescriptor2D::Similarity(const Eigen::VectorXf& lhs,
+                                   const Eigen::VectorXf& rhs) {
+  CHECK_EQ(lhs.size(), rhs.size());
+  if (lhs.sum() == 0.f || rhs.sum() == 0.f) {
+    return 1.f;
+  }
+  return lhs.cwiseMin(rhs).sum();
+}
+
+}  // namespace scan_matching
+}  // namespace mapping
+}  // namespace cartographer
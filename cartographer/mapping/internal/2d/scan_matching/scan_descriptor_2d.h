@@ -0,0 +1,55 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CARTOGRAPHER_MAPPING_INTERNAL_2D_SCAN_MATCHING_SCAN_DESCRIPTOR_2D_H_
+#define CARTOGRAPHER_MAPPING_INTERNAL_2D_SCAN_MATCHING_SCAN_DESCRIPTOR_2D_H_
+
+#include "Eigen/Core"
+#include "cartographer/mapping/2d/grid_2d.h"
+#include "cartographer/sensor/point_cloud.h"
+
+namespace cartographer {
+namespace mapping {
+namespace scan_matching {
+
+// Compact, rotation invariant descriptor of the surroundings of a position in
+// 2D. The space around it is divided into equal angular sectors and the range
+// to the closest obstacle is determined for each sector. The descriptor is the
+// normalized histogram of these ranges. Sectors without obstacles within the
+// maximum range do not contribute.
+class ScanDescriptor2D {
+ public:
+  // Computes the descriptor of a gravity aligned 'point_cloud' relative to the
+  // origin.
+  static Eigen::VectorXf Compute(const sensor::PointCloud& point_cloud);
+
+  // Computes the descriptor of 'grid' as seen from 'origin' by casting a ray
+  // per sector until it hits an occupied cell.
+  static Eigen::VectorXf Compute(const Grid2D& grid,
+                                 const Eigen::Vector2f& origin);
+
+  // Returns the similarity of two descriptors between 0 (worst) and 1 (best)
+  // as the intersection of their histograms. If either descriptor is empty,
+  // 1 is returned, since nothing can be concluded.
+  static float Similarity(const Eigen::VectorXf& lhs,
+                          const Eigen::VectorXf& rhs);
+};
+
+}  // namespace scan_matching
+}  // namespace mapping
+}  // namespace cartographer
+
+#endif  // CARTOGRAPHER_MAPPING_INTERNAL_2D_SCAN_MATCHING_SCAN_DESCRIPTOR_2D_H_
@@ -0,0 +1,94 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cartographer/mapping/internal/2d/scan_matching/scan_descriptor_2d.h"
+
+#include <cmath>
+
+#include "cartographer/mapping/2d/probability_grid.h"
+#include "cartographer/mapping/probability_values.h"
+#include "gtest/gtest.h"
+
+namespace cartographer {
+namespace mapping {
+namespace scan_matching {
+namespace {
+
+// A circular room of the given 'radius' around 'center'.
+sensor::PointCloud CreateRoom(const float radius,
+                              const Eigen::Vector2f& center) {
+  sensor::PointCloud point_cloud;
+  for (float angle = 0.f; angle < 2.f * M_PI; angle += 0.01f) {
+    point_cloud.push_back(
+        {Eigen::Vector3f(center.x() + radius * std::cos(angle),
+                         center.y() + radius * std::sin(angle), 0.f)});
+  }
+  return point_cloud;
+}
+
+TEST(ScanDescriptor2DTest, IsRotationInvariant) {
+  const sensor::PointCloud room = CreateRoom(5.25f, Eigen::Vector2f(1.f, 0.5f));
+  const sensor::PointCloud rotated_room = sensor::TransformPointCloud(
+      room, transform::Rigid3f::Rotation(
+                Eigen::AngleAxisf(1.f, Eigen::Vector3f::UnitZ())));
+  const Eigen::VectorXf descriptor = ScanDescriptor2D::Compute(room);
+  EXPECT_NEAR(1.f, descriptor.sum(), 1e-5f);
+  EXPECT_GT(ScanDescriptor2D::Similarity(
+                descriptor, ScanDescriptor2D::Compute(rotated_room)),
+            0.9f);
+}
+
+TEST(ScanDescriptor2DTest, DistinguishesRooms) {
+  const Eigen::VectorXf small_room =
+      ScanDescriptor2D::Compute(CreateRoom(2.25f, Eigen::Vector2f::Zero()));
+  const Eigen::VectorXf large_room =
+      ScanDescriptor2D::Compute(CreateRoom(8.25f, Eigen::Vector2f::Zero()));
+  EXPECT_LT(ScanDescriptor2D::Similarity(small_room, large_room), 0.1f);
+  EXPECT_EQ(1.f, ScanDescriptor2D::Similarity(
+                     small_room, ScanDescriptor2D::Compute(
+                                     sensor::PointCloud())));
+}
+
+TEST(ScanDescriptor2DTest, MatchesGrid) {
+  ValueConversionTables conversion_tables;
+  ProbabilityGrid probability_grid(
+      MapLimits(0.05, Eigen::Vector2d(10., 10.), CellLimits(400, 400)),
+      &conversion_tables);
+  const Eigen::Vector2f center(0.5f, -0.5f);
+  for (const sensor::RangefinderPoint& point : CreateRoom(5.25f, center)) {
+    const Eigen::Array2i cell_index =
+        probability_grid.limits().GetCellIndex(point.position.head<2>());
+    if (!probability_grid.IsKnown(cell_index)) {
+      probability_grid.SetProbability(cell_index, kMaxProbability);
+    }
+  }
+  const Eigen::VectorXf scan_descriptor =
+      ScanDescriptor2D::Compute(CreateRoom(5.25f, Eigen::Vector2f::Zero()));
+  EXPECT_GT(ScanDescriptor2D::Similarity(
+                scan_descriptor,
+                ScanDescriptor2D::Compute(probability_grid, center)),
+            0.8f);
+  EXPECT_LT(ScanDescriptor2D::Similarity(
+                ScanDescriptor2D::Compute(
+                    CreateRoom(2.25f, Eigen::Vector2f::Zero())),
+                ScanDescriptor2D::Compute(probability_grid, center)),
+            0.1f);
+}
+
+}  // namespace
+}  // namespace scan_matching
+}  // namespace mapping
+}  // namespace cartographer
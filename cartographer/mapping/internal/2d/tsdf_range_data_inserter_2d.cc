@@ -16,6 +16,10 @@
 
 #include "cartographer/mapping/internal/2d/tsdf_range_data_inserter_2d.h"
 
+#include <limits>
+
+#include "absl/memory/memory.h"
+#include "cartographer/common/parallel_for.h"
 #include "cartographer/mapping/internal/2d/normal_estimation_2d.h"
 #include "cartographer/mapping/internal/2d/ray_to_pixel_mask.h"
 
@@ -29,6 +33,9 @@ constexpr int kSubpixelScale = 1000;
 // observations are discarded.
 constexpr float kMinRangeMeters = 1e-6f;
 const float kSqrtTwoPi = std::sqrt(2.0 * M_PI);
+// Minimum number of range observations per thread. Smaller batches are not
+// worth the overhead of scheduling them on another thread.
+constexpr size_t kMinHitsPerThread = 64;
 
 void GrowAsNeeded(const sensor::RangeData& range_data,
                   const float truncation_distance, TSDF2D* const tsdf) {
@@ -46,14 +53,26 @@ void GrowAsNeeded(const sensor::RangeData& range_data,
   tsdf->GrowLimits(bounding_box.max() + kPadding * Eigen::Vector2f::Ones());
 }
 
-float GaussianKernel(const float x, const float sigma) {
-  return 1.0 / (kSqrtTwoPi * sigma) * std::exp(-0.5 * x * x / (sigma * sigma));
-}
+// Gaussian density with standard deviation 'sigma'. The normalization and the
+// variance are computed once per ray instead of once per cell, using the same
+// operations so that the densities do not change.
+class GaussianKernel {
+ public:
+  explicit GaussianKernel(const float sigma)
+      : normalization_(1.0 / (kSqrtTwoPi * sigma)), variance_(sigma * sigma) {}
+
+  float operator()(const float x) const {
+    return normalization_ * std::exp(-0.5 * x * x / variance_);
+  }
+
+ private:
+  const double normalization_;
+  const float variance_;
+};
 
 std::pair<Eigen::Array2i, Eigen::Array2i> SuperscaleRay(
     const Eigen::Vector2f& begin, const Eigen::Vector2f& end,
-    TSDF2D* const tsdf) {
-  const MapLimits& limits = tsdf->limits();
+    const MapLimits& limits) {
   const double superscaled_resolution = limits.resolution() / kSubpixelScale;
   const MapLimits superscaled_limits(
       superscaled_resolution, limits.max(),
@@ -117,12 +136,19 @@ proto::TSDFRangeDataInserterOptions2D CreateTSDFRangeDataInserterOptions2D(
   options.set_update_weight_distance_cell_to_hit_kernel_bandwidth(
       parameter_dictionary->GetDouble(
           "update_weight_distance_cell_to_hit_kernel_bandwidth"));
+  options.set_num_threads(parameter_dictionary->GetInt("num_threads"));
+  CHECK_GT(options.num_threads(), 0);
   return options;
 }
 
 TSDFRangeDataInserter2D::TSDFRangeDataInserter2D(
     const proto::TSDFRangeDataInserterOptions2D& options)
-    : options_(options) {}
+    : options_(options) {
+  if (options_.num_threads() > 1) {
+    thread_pool_ =
+        absl::make_unique<common::ThreadPool>(options_.num_threads() - 1);
+  }
+}
 
 // Casts a ray from origin towards hit for each hit in range data.
 // If 'options.update_free_space' is 'true', all cells along the ray
@@ -135,39 +161,96 @@ void TSDFRangeDataInserter2D::Insert(const sensor::RangeData& range_data,
   TSDF2D* tsdf = static_cast<TSDF2D*>(grid);
   GrowAsNeeded(range_data, truncation_distance, tsdf);
 
-  // Compute normals if needed.
+  // Sort the returns by angle if normals are needed.
   bool scale_update_weight_angle_scan_normal_to_ray =
       options_.update_weight_angle_scan_normal_to_ray_kernel_bandwidth() != 0.f;
   sensor::RangeData sorted_range_data = range_data;
-  std::vector<float> normals;
-  if (options_.project_sdf_distance_to_scan_normal() ||
-      scale_update_weight_angle_scan_normal_to_ray) {
+  const bool estimate_normals =
+      options_.project_sdf_distance_to_scan_normal() ||
+      scale_update_weight_angle_scan_normal_to_ray;
+  if (estimate_normals) {
     std::vector<sensor::RangefinderPoint> returns =
         sorted_range_data.returns.points();
     std::sort(returns.begin(), returns.end(),
               RangeDataSorter(sorted_range_data.origin));
     sorted_range_data.returns = sensor::PointCloud(std::move(returns));
-    normals = EstimateNormals(sorted_range_data,
-                              options_.normal_estimation_options());
   }
 
   const Eigen::Vector2f origin = sorted_range_data.origin.head<2>();
-  for (size_t hit_index = 0; hit_index < sorted_range_data.returns.size();
-       ++hit_index) {
-    const Eigen::Vector2f hit =
-        sorted_range_data.returns[hit_index].position.head<2>();
-    const float normal = normals.empty()
-                             ? std::numeric_limits<float>::quiet_NaN()
-                             : normals[hit_index];
-    InsertHit(options_, hit, origin, normal, tsdf);
+  const size_t num_hits = sorted_range_data.returns.size();
+  const size_t num_threads = std::max<size_t>(
+      1, std::min<size_t>(std::max(options_.num_threads(), 1),
+                          num_hits / kMinHitsPerThread));
+
+  if (num_threads == 1) {
+    std::vector<float> normals;
+    if (estimate_normals) {
+      normals = EstimateNormals(sorted_range_data,
+                                options_.normal_estimation_options());
+    }
+    // Cells updated by a ray are skipped by all later rays, so updates are
+    // applied right away and no work is spent on cells that are skipped.
+    std::vector<CellUpdate> updates;
+    for (size_t hit_index = 0; hit_index < num_hits; ++hit_index) {
+      updates.clear();
+      const Eigen::Vector2f hit =
+          sorted_range_data.returns[hit_index].position.head<2>();
+      const float normal = normals.empty()
+                               ? std::numeric_limits<float>::quiet_NaN()
+                               : normals[hit_index];
+      ComputeCellUpdates(hit, origin, normal, true /* skip_updated_cells */,
+                         *tsdf, &updates);
+      for (const CellUpdate& update : updates) {
+        ApplyCellUpdate(update, tsdf);
+      }
+    }
+  } else {
+    // Threads only read 'tsdf' while computing the normals and cell updates
+    // of contiguous batches of rays. The updates are then applied in the
+    // order of the rays, so that the first ray to update a cell wins as in
+    // the sequential case.
+    std::vector<std::vector<CellUpdate>> batch_updates(num_threads);
+    const auto compute_batch = [this, &sorted_range_data, estimate_normals,
+                                num_hits, num_threads, &batch_updates,
+                                tsdf, &origin](const size_t batch) {
+      const size_t begin = num_hits * batch / num_threads;
+      const size_t end = num_hits * (batch + 1) / num_threads;
+      std::vector<float> normals;
+      if (estimate_normals) {
+        normals = EstimateNormals(sorted_range_data,
+                                  options_.normal_estimation_options(), begin,
+                                  end);
+      }
+      for (size_t hit_index = begin; hit_index < end; ++hit_index) {
+        const Eigen::Vector2f hit =
+            sorted_range_data.returns[hit_index].position.head<2>();
+        const float normal = normals.empty()
+                                 ? std::numeric_limits<float>::quiet_NaN()
+                                 : normals[hit_index - begin];
+        ComputeCellUpdates(hit, origin, normal,
+                           false /* skip_updated_cells */, *tsdf,
+                           &batch_updates[batch]);
+      }
+    };
+    common::ParallelFor(thread_pool_.get(), num_threads, num_threads,
+                        [&compute_batch](const size_t begin, const size_t end) {
+                          for (size_t batch = begin; batch < end; ++batch) {
+                            compute_batch(batch);
+                          }
+                        });
+    for (const std::vector<CellUpdate>& updates : batch_updates) {
+      for (const CellUpdate& update : updates) {
+        ApplyCellUpdate(update, tsdf);
+      }
+    }
   }
   tsdf->FinishUpdate();
 }
 
-void TSDFRangeDataInserter2D::InsertHit(
-    const proto::TSDFRangeDataInserterOptions2D& options,
-    const Eigen::Vector2f& hit, const Eigen::Vector2f& origin, float normal,
-    TSDF2D* tsdf) const {
+void TSDFRangeDataInserter2D::ComputeCellUpdates(
+    const Eigen::Vector2f& hit, const Eigen::Vector2f& origin,
+    const float normal, const bool skip_updated_cells, const TSDF2D& tsdf,
+    std::vector<CellUpdate>* const updates) const {
   const Eigen::Vector2f ray = hit - origin;
   const float range = ray.norm();
   const float truncation_distance =
@@ -179,7 +262,7 @@ void TSDFRangeDataInserter2D::InsertHit(
                                    : origin + (1.0f - truncation_ratio) * ray;
   const Eigen::Vector2f ray_end = origin + (1.0f + truncation_ratio) * ray;
   std::pair<Eigen::Array2i, Eigen::Array2i> superscaled_ray =
-      SuperscaleRay(ray_begin, ray_end, tsdf);
+      SuperscaleRay(ray_begin, ray_end, tsdf.limits());
   std::vector<Eigen::Array2i> ray_mask = RayToPixelMask(
       superscaled_ray.first, superscaled_ray.second, kSubpixelScale);
 
@@ -191,51 +274,55 @@ void TSDFRangeDataInserter2D::InsertHit(
     float angle_ray_normal =
         common::NormalizeAngleDifference(normal - common::atan2(negative_ray));
     weight_factor_angle_ray_normal = GaussianKernel(
-        angle_ray_normal,
-        options_.update_weight_angle_scan_normal_to_ray_kernel_bandwidth());
+        options_.update_weight_angle_scan_normal_to_ray_kernel_bandwidth())(
+        angle_ray_normal);
   }
   float weight_factor_range = 1.f;
   if (options_.update_weight_range_exponent() != 0) {
     weight_factor_range = ComputeRangeWeightFactor(
         range, options_.update_weight_range_exponent());
   }
+  const bool scale_update_weight_distance_cell_to_hit =
+      options_.update_weight_distance_cell_to_hit_kernel_bandwidth() != 0.f;
+  const GaussianKernel distance_cell_to_hit_kernel(
+      scale_update_weight_distance_cell_to_hit
+          ? options_.update_weight_distance_cell_to_hit_kernel_bandwidth()
+          : 1.f);
+  const Eigen::Vector2f scan_normal{std::cos(normal), std::sin(normal)};
 
-  // Update Cells.
+  // Compute cell updates.
   for (const Eigen::Array2i& cell_index : ray_mask) {
-    if (tsdf->CellIsUpdated(cell_index)) continue;
-    Eigen::Vector2f cell_center = tsdf->limits().GetCellCenter(cell_index);
+    if (skip_updated_cells && tsdf.CellIsUpdated(cell_index)) continue;
+    Eigen::Vector2f cell_center = tsdf.limits().GetCellCenter(cell_index);
     float distance_cell_to_origin = (cell_center - origin).norm();
     float update_tsd = range - distance_cell_to_origin;
     if (options_.project_sdf_distance_to_scan_normal()) {
-      float normal_orientation = normal;
-      update_tsd = (cell_center - hit)
-                       .dot(Eigen::Vector2f{std::cos(normal_orientation),
-                                            std::sin(normal_orientation)});
+      update_tsd = (cell_center - hit).dot(scan_normal);
     }
     update_tsd =
         common::Clamp(update_tsd, -truncation_distance, truncation_distance);
     float update_weight = weight_factor_range * weight_factor_angle_ray_normal;
-    if (options_.update_weight_distance_cell_to_hit_kernel_bandwidth() != 0.f) {
-      update_weight *= GaussianKernel(
-          update_tsd,
-          options_.update_weight_distance_cell_to_hit_kernel_bandwidth());
+    if (scale_update_weight_distance_cell_to_hit) {
+      update_weight *= distance_cell_to_hit_kernel(update_tsd);
     }
-    UpdateCell(cell_index, update_tsd, update_weight, tsdf);
+    // Updates without weight leave the cell untouched.
+    if (update_weight == 0.f) continue;
+    updates->push_back(CellUpdate{cell_index, update_tsd, update_weight});
   }
 }
 
-void TSDFRangeDataInserter2D::UpdateCell(const Eigen::Array2i& cell,
-                                         float update_sdf, float update_weight,
-                                         TSDF2D* tsdf) const {
-  if (update_weight == 0.f) return;
-  const std::pair<float, float> tsd_and_weight = tsdf->GetTSDAndWeight(cell);
-  float updated_weight = tsd_and_weight.second + update_weight;
+void TSDFRangeDataInserter2D::ApplyCellUpdate(const CellUpdate& update,
+                                              TSDF2D* tsdf) const {
+  if (tsdf->CellIsUpdated(update.cell_index)) return;
+  const std::pair<float, float> tsd_and_weight =
+      tsdf->GetTSDAndWeight(update.cell_index);
+  float updated_weight = tsd_and_weight.second + update.weight;
   float updated_sdf = (tsd_and_weight.first * tsd_and_weight.second +
-                       update_sdf * update_weight) /
+                       update.tsd * update.weight) /
                       updated_weight;
   updated_weight =
       std::min(updated_weight, static_cast<float>(options_.maximum_weight()));
-  tsdf->SetCell(cell, updated_sdf, updated_weight);
+  tsdf->SetCell(update.cell_index, updated_sdf, updated_weight);
 }
 
 }  // namespace mapping
@@ -17,7 +17,11 @@
 #ifndef CARTOGRAPHER_MAPPING_2D_TSDF_RANGE_DATA_INSERTER_2D_H_
 #define CARTOGRAPHER_MAPPING_2D_TSDF_RANGE_DATA_INSERTER_2D_H_
 
+#include <memory>
+#include <vector>
+
 #include "cartographer/common/lua_parameter_dictionary.h"
+#include "cartographer/common/thread_pool.h"
 #include "cartographer/mapping/internal/2d/tsdf_2d.h"
 #include "cartographer/mapping/proto/tsdf_range_data_inserter_options_2d.pb.h"
 #include "cartographer/mapping/range_data_inserter_interface.h"
@@ -42,16 +46,34 @@ class TSDFRangeDataInserter2D : public RangeDataInserterInterface {
   // If 'options.update_free_space' is 'true', all cells along the ray
   // until 'truncation_distance' behind hit are updated. Otherwise, only the
   // cells within 'truncation_distance' around hit are updated.
+  // If 'options.num_threads' is larger than 1, the updates of batches of rays
+  // are computed in parallel on a thread pool owned by this inserter and then
+  // applied in the order of the rays, which gives the same result as a
+  // sequential insertion.
   virtual void Insert(const sensor::RangeData& range_data,
                       GridInterface* grid) const override;
 
  private:
-  void InsertHit(const proto::TSDFRangeDataInserterOptions2D& options,
-                 const Eigen::Vector2f& hit, const Eigen::Vector2f& origin,
-                 float normal, TSDF2D* tsdf) const;
-  void UpdateCell(const Eigen::Array2i& cell, float update_sdf,
-                  float update_weight, TSDF2D* tsdf) const;
+  struct CellUpdate {
+    Eigen::Array2i cell_index;
+    float tsd;
+    float weight;
+  };
+
+  // Appends the updates of the cells along the ray from 'origin' through
+  // 'hit' to 'updates'. If 'skip_updated_cells' is true, cells already
+  // updated in 'tsdf' are omitted.
+  void ComputeCellUpdates(const Eigen::Vector2f& hit,
+                          const Eigen::Vector2f& origin, float normal,
+                          bool skip_updated_cells, const TSDF2D& tsdf,
+                          std::vector<CellUpdate>* updates) const;
+  // Applies 'update' unless the cell was already updated.
+  void ApplyCellUpdate(const CellUpdate& update, TSDF2D* tsdf) const;
+
   const proto::TSDFRangeDataInserterOptions2D options_;
+  // Runs all batches of rays but the first one if 'options_.num_threads' is
+  // larger than 1, nullptr otherwise.
+  std::unique_ptr<common::ThreadPool> thread_pool_;
 };
 
 }  // namespace mapping
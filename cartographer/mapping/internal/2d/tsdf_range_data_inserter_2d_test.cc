@@ -16,6 +16,8 @@
 
 #include "cartographer/mapping/internal/2d/tsdf_range_data_inserter_2d.h"
 
+#include <random>
+
 #include "cartographer/common/internal/testing/lua_parameter_dictionary_test_helpers.h"
 #include "cartographer/common/lua_parameter_dictionary.h"
 #include "gmock/gmock.h"
@@ -42,6 +44,7 @@ class RangeDataInserterTest2DTSDF : public ::testing::Test {
         "update_weight_range_exponent = 0,"
         "update_weight_angle_scan_normal_to_ray_kernel_bandwidth = 0,"
         "update_weight_distance_cell_to_hit_kernel_bandwidth = 0,"
+        "num_threads = 1,"
         "}");
     options_ = CreateTSDFRangeDataInserterOptions2D(parameter_dictionary.get());
     range_data_inserter_ = absl::make_unique<TSDFRangeDataInserter2D>(options_);
@@ -344,6 +347,58 @@ TEST_F(RangeDataInserterTest2DTSDF, InsertPointsWithDistanceCellToHit) {
   }
 }
 
+TEST_F(RangeDataInserterTest2DTSDF, MultiThreadedInsertionIsIdentical) {
+  options_.set_update_free_space(true);
+  options_.set_project_sdf_distance_to_scan_normal(true);
+  options_.set_update_weight_range_exponent(1);
+  options_.set_update_weight_angle_scan_normal_to_ray_kernel_bandwidth(0.5);
+  options_.set_update_weight_distance_cell_to_hit_kernel_bandwidth(0.5);
+  const TSDFRangeDataInserter2D single_threaded_inserter(options_);
+  options_.set_num_threads(4);
+  const TSDFRangeDataInserter2D multi_threaded_inserter(options_);
+
+  // Returns on the walls of a room, so that many rays cross the same cells.
+  std::mt19937 prng(42);
+  std::uniform_real_distribution<float> distribution(-0.05f, 0.05f);
+  sensor::RangeData range_data;
+  range_data.origin = Eigen::Vector3f(0.3f, -0.2f, 0.f);
+  for (int i = 0; i < 1000; ++i) {
+    const float angle = 2.f * static_cast<float>(M_PI) * i / 1000.f;
+    const Eigen::Vector2f direction(std::cos(angle), std::sin(angle));
+    const float range = 8.f / direction.lpNorm<Eigen::Infinity>();
+    range_data.returns.push_back({Eigen::Vector3f(
+        range * direction.x() + distribution(prng),
+        range * direction.y() + distribution(prng), 0.f)});
+  }
+
+  const MapLimits limits(0.1, Eigen::Vector2d(1., 1.), CellLimits(20, 20));
+  TSDF2D single_threaded_tsdf(limits, 0.3, 10.0, &conversion_tables_);
+  TSDF2D multi_threaded_tsdf(limits, 0.3, 10.0, &conversion_tables_);
+  for (int i = 0; i < 2; ++i) {
+    single_threaded_inserter.Insert(range_data, &single_threaded_tsdf);
+    multi_threaded_inserter.Insert(range_data, &multi_threaded_tsdf);
+  }
+
+  ASSERT_EQ(single_threaded_tsdf.limits().max(),
+            multi_threaded_tsdf.limits().max());
+  const CellLimits& cell_limits = single_threaded_tsdf.limits().cell_limits();
+  ASSERT_EQ(cell_limits.num_x_cells,
+            multi_threaded_tsdf.limits().cell_limits().num_x_cells);
+  ASSERT_EQ(cell_limits.num_y_cells,
+            multi_threaded_tsdf.limits().cell_limits().num_y_cells);
+  int num_known_cells = 0;
+  for (const Eigen::Array2i& xy_index : XYIndexRangeIterator(cell_limits)) {
+    ASSERT_EQ(single_threaded_tsdf.IsKnown(xy_index),
+              multi_threaded_tsdf.IsKnown(xy_index));
+    EXPECT_EQ(single_threaded_tsdf.GetTSD(xy_index),
+              multi_threaded_tsdf.GetTSD(xy_index));
+    EXPECT_EQ(single_threaded_tsdf.GetWeight(xy_index),
+              multi_threaded_tsdf.GetWeight(xy_index));
+    if (single_threaded_tsdf.IsKnown(xy_index)) ++num_known_cells;
+  }
+  EXPECT_GT(num_known_cells, 1000);
+}
+
 }  // namespace
 }  // namespace mapping
 }  // namespace cartographer
@@ -73,6 +73,8 @@ class LocalTrajectoryBuilderTest : public ::testing::Test {
             angular_search_window = math.rad(1.),
             translation_delta_cost_weight = 1e-1,
             rotation_delta_cost_weight = 1.,
+            batched_evaluation_3d = false,
+            num_threads_3d = 1,
           },
 
           ceres_scan_matcher = {
@@ -125,6 +127,7 @@ class LocalTrajectoryBuilderTest : public ::testing::Test {
             high_resolution_max_range = 50.,
             low_resolution = 0.5,
             num_range_data = 45000,
+            max_intensity = 65535.,
             range_data_inserter = {
               hit_probability = 0.7,
               miss_probability = 0.4,
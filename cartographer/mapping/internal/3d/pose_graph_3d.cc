@@ -336,7 +336,7 @@ WorkItem::Result PoseGraph3D::ComputeConstraintsForNode(
       data_.submap_data.at(submap_id).node_ids.emplace(node_id);
       const transform::Rigid3d constraint_transform =
           insertion_submaps[i]->local_pose().inverse() * local_pose;
-      data_.constraints.push_back(Constraint{
+      data_.constraints.Add(Constraint{
           submap_id,
           node_id,
           {constraint_transform, options_.matcher_translation_weight(),
@@ -418,10 +418,7 @@ void PoseGraph3D::DeleteTrajectoriesIfNeeded() {
         InternalTrajectoryState::DeletionState::WAIT_FOR_DELETION) {
       // TODO(gaschler): Consider directly deleting from data_, which may be
       // more complete.
-      auto submap_ids = trimming_handle.GetSubmapIds(it.first);
-      for (auto& submap_id : submap_ids) {
-        trimming_handle.TrimSubmap(submap_id);
-      }
+      trimming_handle.TrimSubmaps(trimming_handle.GetSubmapIds(it.first));
       it.second.state = TrajectoryState::DELETED;
       it.second.deletion_state = InternalTrajectoryState::DeletionState::NORMAL;
     }
@@ -432,8 +429,7 @@ void PoseGraph3D::HandleWorkQueue(
     const constraints::ConstraintBuilder3D::Result& result) {
   {
     absl::MutexLock locker(&mutex_);
-    data_.constraints.insert(data_.constraints.end(), result.begin(),
-                             result.end());
+    data_.constraints.Add(result);
   }
   RunOptimization();
 
@@ -484,16 +480,11 @@ void PoseGraph3D::HandleWorkQueue(
     // Update the gauges that count the current number of constraints.
     double inter_constraints_same_trajectory = 0;
     double inter_constraints_different_trajectory = 0;
-    for (const auto& constraint : data_.constraints) {
-      if (constraint.tag ==
-          cartographer::mapping::PoseGraph::Constraint::INTRA_SUBMAP) {
-        continue;
-      }
-      if (constraint.node_id.trajectory_id ==
-          constraint.submap_id.trajectory_id) {
-        ++inter_constraints_same_trajectory;
+    for (const auto& entry : data_.constraints.num_inter_submap_constraints()) {
+      if (entry.first.first == entry.first.second) {
+        inter_constraints_same_trajectory += entry.second;
       } else {
-        ++inter_constraints_different_trajectory;
+        inter_constraints_different_trajectory += entry.second;
       }
     }
     kConstraintsSameTrajectoryMetric->Set(inter_constraints_same_trajectory);
@@ -578,8 +569,7 @@ void PoseGraph3D::WaitForAllComputations() {
        &notification](const constraints::ConstraintBuilder3D::Result& result)
           LOCKS_EXCLUDED(mutex_) {
             absl::MutexLock locker(&mutex_);
-            data_.constraints.insert(data_.constraints.end(), result.begin(),
-                                     result.end());
+            data_.constraints.Add(result);
             notification = true;
           });
   const auto predicate = [&notification]() EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
@@ -791,7 +781,7 @@ void PoseGraph3D::AddSerializedConstraints(
           UpdateTrajectoryConnectivity(constraint);
           break;
       }
-      data_.constraints.push_back(constraint);
+      data_.constraints.Add(constraint);
     }
     LOG(INFO) << "Loaded " << constraints.size() << " constraints.";
     return WorkItem::Result::kDoNotRunOptimization;
@@ -863,8 +853,8 @@ void PoseGraph3D::RunOptimization() {
   // data_.frozen_trajectories and data_.landmark_nodes when executing the
   // Solve. Solve is time consuming, so not taking the mutex before Solve to
   // avoid blocking foreground processing.
-  optimization_problem_->Solve(data_.constraints, GetTrajectoryStates(),
-                               data_.landmark_nodes);
+  optimization_problem_->Solve(data_.constraints.vector(),
+                               GetTrajectoryStates(), data_.landmark_nodes);
   absl::MutexLock locker(&mutex_);
 
   const auto& submap_data = optimization_problem_->submap_data();
@@ -1020,7 +1010,7 @@ PoseGraph3D::GetTrajectoryData() const {
 
 std::vector<PoseGraphInterface::Constraint> PoseGraph3D::constraints() const {
   absl::MutexLock locker(&mutex_);
-  return data_.constraints;
+  return data_.constraints.vector();
 }
 
 void PoseGraph3D::SetInitialTrajectoryPose(const int from_trajectory_id,
@@ -1172,7 +1162,7 @@ PoseGraph3D::TrimmingHandle::GetTrajectoryNodes() const {
 
 const std::vector<PoseGraphInterface::Constraint>&
 PoseGraph3D::TrimmingHandle::GetConstraints() const {
-  return parent_->data_.constraints;
+  return parent_->data_.constraints.vector();
 }
 
 bool PoseGraph3D::TrimmingHandle::IsFinished(const int trajectory_id) const {
@@ -1185,89 +1175,76 @@ void PoseGraph3D::TrimmingHandle::SetTrajectoryState(int trajectory_id,
 }
 
 void PoseGraph3D::TrimmingHandle::TrimSubmap(const SubmapId& submap_id) {
-  // TODO(hrapp): We have to make sure that the trajectory has been finished
-  // if we want to delete the last submaps.
-  CHECK(parent_->data_.submap_data.at(submap_id).state ==
-        SubmapState::kFinished);
+  TrimSubmaps({submap_id});
+}
 
-  // Compile all nodes that are still INTRA_SUBMAP constrained to other submaps
-  // once the submap with 'submap_id' is gone.
-  // We need to use node_ids instead of constraints here to be also compatible
-  // with frozen trajectories that don't have intra-constraints.
-  std::set<NodeId> nodes_to_retain;
-  for (const auto& submap_data : parent_->data_.submap_data) {
-    if (submap_data.id != submap_id) {
-      nodes_to_retain.insert(submap_data.data.node_ids.begin(),
-                             submap_data.data.node_ids.end());
-    }
+void PoseGraph3D::TrimmingHandle::TrimSubmaps(
+    const std::vector<SubmapId>& submap_ids) {
+  const std::set<SubmapId> submaps_to_remove(submap_ids.begin(),
+                                             submap_ids.end());
+  if (submaps_to_remove.empty()) {
+    return;
   }
 
-  // Remove all nodes that are exlusively associated to 'submap_id'.
+  // TODO(hrapp): We have to make sure that the trajectory has been finished
+  // if we want to delete the last submaps.
   std::set<NodeId> nodes_to_remove;
-  std::set_difference(parent_->data_.submap_data.at(submap_id).node_ids.begin(),
-                      parent_->data_.submap_data.at(submap_id).node_ids.end(),
-                      nodes_to_retain.begin(), nodes_to_retain.end(),
-                      std::inserter(nodes_to_remove, nodes_to_remove.begin()));
+  for (const SubmapId& submap_id : submaps_to_remove) {
+    const InternalSubmapData& submap_data =
+        parent_->data_.submap_data.at(submap_id);
+    CHECK(submap_data.state == SubmapState::kFinished);
+    nodes_to_remove.insert(submap_data.node_ids.begin(),
+                           submap_data.node_ids.end());
+  }
 
-  // Remove all 'data_.constraints' related to 'submap_id'.
-  {
-    std::vector<Constraint> constraints;
-    for (const Constraint& constraint : parent_->data_.constraints) {
-      if (constraint.submap_id != submap_id) {
-        constraints.push_back(constraint);
+  // Keep all nodes that are still INTRA_SUBMAP constrained to other submaps
+  // once the submaps in 'submaps_to_remove' are gone.
+  // We need to use node_ids instead of constraints here to be also compatible
+  // with frozen trajectories that don't have intra-constraints. Since the
+  // node IDs of each submap are sorted, only the part of each set between the
+  // first and the last node to remove needs to be visited.
+  if (!nodes_to_remove.empty()) {
+    const NodeId first_node_id = *nodes_to_remove.begin();
+    const NodeId last_node_id = *nodes_to_remove.rbegin();
+    for (const auto& submap_data : parent_->data_.submap_data) {
+      if (submaps_to_remove.count(submap_data.id) != 0) {
+        continue;
+      }
+      const std::set<NodeId>& node_ids = submap_data.data.node_ids;
+      for (auto it = node_ids.lower_bound(first_node_id);
+           it != node_ids.end() && !(last_node_id < *it); ++it) {
+        nodes_to_remove.erase(*it);
       }
     }
-    parent_->data_.constraints = std::move(constraints);
   }
 
-  // Remove all 'data_.constraints' related to 'nodes_to_remove'.
+  // Remove all 'data_.constraints' related to 'submaps_to_remove' or
+  // 'nodes_to_remove'.
   // If the removal lets other submaps lose all their inter-submap constraints,
   // delete their corresponding constraint submap matchers to save memory.
-  {
-    std::vector<Constraint> constraints;
-    std::set<SubmapId> other_submap_ids_losing_constraints;
-    for (const Constraint& constraint : parent_->data_.constraints) {
-      if (nodes_to_remove.count(constraint.node_id) == 0) {
-        constraints.push_back(constraint);
-      } else {
-        // A constraint to another submap will be removed, mark it as affected.
-        other_submap_ids_losing_constraints.insert(constraint.submap_id);
-      }
-    }
-    parent_->data_.constraints = std::move(constraints);
-    // Go through the remaining constraints to ensure we only delete scan
-    // matchers of other submaps that have no inter-submap constraints left.
-    for (const Constraint& constraint : parent_->data_.constraints) {
-      if (constraint.tag == Constraint::Tag::INTRA_SUBMAP) {
-        continue;
-      } else if (other_submap_ids_losing_constraints.count(
-                     constraint.submap_id)) {
-        // This submap still has inter-submap constraints - ignore it.
-        other_submap_ids_losing_constraints.erase(constraint.submap_id);
-      }
-    }
-    // Delete scan matchers of the submaps that lost all constraints.
-    // TODO(wohe): An improvement to this implementation would be to add the
-    // caching logic at the constraint builder which could keep around only
-    // recently used scan matchers.
-    for (const SubmapId& submap_id : other_submap_ids_losing_constraints) {
+  // TODO(wohe): An improvement to this implementation would be to add the
+  // caching logic at the constraint builder which could keep around only
+  // recently used scan matchers.
+  for (const SubmapId& submap_id :
+       parent_->data_.constraints.Remove(submaps_to_remove, nodes_to_remove)) {
+    if (!parent_->data_.constraints.HasInterSubmapConstraints(submap_id)) {
       parent_->constraint_builder_.DeleteScanMatcher(submap_id);
     }
   }
 
-  // Mark the submap with 'submap_id' as trimmed and remove its data.
-  CHECK(parent_->data_.submap_data.at(submap_id).state ==
-        SubmapState::kFinished);
-  parent_->data_.submap_data.Trim(submap_id);
-  parent_->constraint_builder_.DeleteScanMatcher(submap_id);
-  parent_->optimization_problem_->TrimSubmap(submap_id);
-
-  // We have one submap less, update the gauge metrics.
-  kDeletedSubmapsMetric->Increment();
-  if (parent_->IsTrajectoryFrozen(submap_id.trajectory_id)) {
-    kFrozenSubmapsMetric->Decrement();
-  } else {
-    kActiveSubmapsMetric->Decrement();
+  // Mark the submaps in 'submaps_to_remove' as trimmed and remove their data.
+  for (const SubmapId& submap_id : submaps_to_remove) {
+    parent_->data_.submap_data.Trim(submap_id);
+    parent_->constraint_builder_.DeleteScanMatcher(submap_id);
+    parent_->optimization_problem_->TrimSubmap(submap_id);
+
+    // We have one submap less, update the gauge metrics.
+    kDeletedSubmapsMetric->Increment();
+    if (parent_->IsTrajectoryFrozen(submap_id.trajectory_id)) {
+      kFrozenSubmapsMetric->Decrement();
+    } else {
+      kActiveSubmapsMetric->Decrement();
+    }
   }
 
   // Remove the 'nodes_to_remove' from the pose graph and the optimization
@@ -285,6 +285,8 @@ class PoseGraph3D : public PoseGraph {
         EXCLUSIVE_LOCKS_REQUIRED(parent_->mutex_);
     void TrimSubmap(const SubmapId& submap_id)
         EXCLUSIVE_LOCKS_REQUIRED(parent_->mutex_) override;
+    void TrimSubmaps(const std::vector<SubmapId>& submap_ids)
+        EXCLUSIVE_LOCKS_REQUIRED(parent_->mutex_) override;
     bool IsFinished(int trajectory_id) const override
         EXCLUSIVE_LOCKS_REQUIRED(parent_->mutex_);
 
@@ -0,0 +1,187 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cartographer/mapping/internal/3d/scan_matching/batched_grid_cost_function_3d.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "Eigen/Geometry"
+#include "cartographer/mapping/internal/3d/scan_matching/interpolated_grid.h"
+#include "glog/logging.h"
+
+namespace cartographer {
+namespace mapping {
+namespace scan_matching {
+namespace {
+
+// Residual i is 'weights[i] * (value - targets[i])', where 'value' is the
+// interpolated grid value at the transformed point i. Points with a zero
+// weight are not evaluated.
+template <typename HybridGridType>
+class BatchedGridCostFunction3D : public ceres::CostFunction {
+ public:
+  BatchedGridCostFunction3D(
+      std::shared_ptr<TransformedPointCloud3D> transformed_point_cloud,
+      const HybridGridType& hybrid_grid, std::vector<double> weights,
+      std::vector<double> targets)
+      : transformed_point_cloud_(std::move(transformed_point_cloud)),
+        interpolated_grid_(hybrid_grid),
+        weights_(std::move(weights)),
+        targets_(std::move(targets)),
+        cached_voxels_(weights_.size()) {
+    CHECK_EQ(weights_.size(), transformed_point_cloud_->point_cloud().size());
+    CHECK_EQ(targets_.size(), weights_.size());
+    set_num_residuals(weights_.size());
+    mutable_parameter_block_sizes()->push_back(3 /* translation variables */);
+    mutable_parameter_block_sizes()->push_back(4 /* rotation variables */);
+  }
+
+  bool Evaluate(double const* const* const parameters, double* const residuals,
+                double** const jacobians) const override {
+    double* const translation_jacobian =
+        jacobians != nullptr ? jacobians[0] : nullptr;
+    double* const rotation_jacobian =
+        jacobians != nullptr ? jacobians[1] : nullptr;
+    transformed_point_cloud_->Evaluate(
+        parameters[0], parameters[1], rotation_jacobian != nullptr,
+        [&](const std::vector<Eigen::Vector3d>& world_points,
+            const TransformedPointCloud3D::RotationJacobians&
+                rotation_jacobians) {
+          for (size_t i = 0; i < weights_.size(); ++i) {
+            if (weights_[i] == 0.) {
+              residuals[i] = 0.;
+              if (translation_jacobian != nullptr) {
+                std::fill_n(translation_jacobian + 3 * i, 3, 0.);
+              }
+              if (rotation_jacobian != nullptr) {
+                std::fill_n(rotation_jacobian + 4 * i, 4, 0.);
+              }
+              continue;
+            }
+            const Eigen::Vector3d& world = world_points[i];
+            Eigen::Vector3d gradient;
+            const double value =
+                interpolated_grid_.GetInterpolatedValueAndGradient(
+                    world.x(), world.y(), world.z(), &cached_voxels_[i],
+                    &gradient);
+            residuals[i] = weights_[i] * (value - targets_[i]);
+            gradient *= weights_[i];
+            if (translation_jacobian != nullptr) {
+              Eigen::Map<Eigen::RowVector3d>(translation_jacobian + 3 * i) =
+                  gradient.transpose();
+            }
+            if (rotation_jacobian != nullptr) {
+              Eigen::Map<Eigen::RowVector4d>(rotation_jacobian + 4 * i) =
+                  gradient.transpose() * rotation_jacobians[i];
+            }
+          }
+        });
+    return true;
+  }
+
+ private:
+  const std::shared_ptr<TransformedPointCloud3D> transformed_point_cloud_;
+  const InterpolatedGrid<HybridGridType> interpolated_grid_;
+  const std::vector<double> weights_;
+  const std::vector<double> targets_;
+  // Ceres never evaluates the same residual block concurrently.
+  mutable std::vector<typename InterpolatedGrid<HybridGridType>::CachedVoxels>
+      cached_voxels_;
+};
+
+}  // namespace
+
+TransformedPointCloud3D::TransformedPointCloud3D(
+    const sensor::PointCloud& point_cloud)
+    : point_cloud_(point_cloud) {}
+
+void TransformedPointCloud3D::Update(const double* const translation,
+                                     const double* const rotation,
+                                     const bool with_jacobians) {
+  const std::array<double, 7> pose = {
+      {translation[0], translation[1], translation[2], rotation[0],
+       rotation[1], rotation[2], rotation[3]}};
+  if (has_pose_ && pose == pose_ && (has_jacobians_ || !with_jacobians)) {
+    return;
+  }
+  has_pose_ = true;
+  has_jacobians_ = with_jacobians;
+  pose_ = pose;
+
+  // Same expressions as in 'transform::Rigid3d::operator*', so that the points
+  // match the ones transformed by the auto-differentiated cost functions.
+  const Eigen::Vector3d t(translation[0], translation[1], translation[2]);
+  const Eigen::Quaterniond q(rotation[0], rotation[1], rotation[2],
+                             rotation[3]);
+  const Eigen::Vector3d u = q.vec();
+  world_points_.resize(point_cloud_.size());
+  if (with_jacobians) {
+    rotation_jacobians_.resize(point_cloud_.size());
+  }
+  for (size_t i = 0; i < point_cloud_.size(); ++i) {
+    const Eigen::Vector3d v = point_cloud_[i].position.cast<double>();
+    world_points_[i] = q * v + t;
+    if (!with_jacobians) {
+      continue;
+    }
+    // Eigen rotates 'v' as v + w * uv + u x uv, where uv = 2 * u x v.
+    const Eigen::Vector3d uv = 2. * u.cross(v);
+    Eigen::Matrix<double, 3, 4>& jacobian = rotation_jacobians_[i];
+    jacobian.col(0) = uv;
+    for (int k = 0; k < 3; ++k) {
+      const Eigen::Vector3d e = Eigen::Vector3d::Unit(k);
+      const Eigen::Vector3d duv = 2. * e.cross(v);
+      jacobian.col(k + 1) = q.w() * duv + e.cross(uv) + u.cross(duv);
+    }
+  }
+}
+
+ceres::CostFunction* CreateBatchedOccupiedSpaceCostFunction3D(
+    const double scaling_factor,
+    std::shared_ptr<TransformedPointCloud3D> transformed_point_cloud,
+    const HybridGrid& hybrid_grid) {
+  const size_t num_points = transformed_point_cloud->point_cloud().size();
+  return new BatchedGridCostFunction3D<HybridGrid>(
+      std::move(transformed_point_cloud), hybrid_grid,
+      std::vector<double>(num_points, -scaling_factor),
+      std::vector<double>(num_points, 1.));
+}
+
+ceres::CostFunction* CreateBatchedIntensityCostFunction3D(
+    const double scaling_factor, const float intensity_threshold,
+    std::shared_ptr<TransformedPointCloud3D> transformed_point_cloud,
+    const IntensityHybridGrid& hybrid_grid) {
+  const sensor::PointCloud& point_cloud =
+      transformed_point_cloud->point_cloud();
+  CHECK_EQ(point_cloud.intensities().size(), point_cloud.size());
+  std::vector<double> weights;
+  std::vector<double> targets;
+  weights.reserve(point_cloud.size());
+  targets.reserve(point_cloud.size());
+  for (const float intensity : point_cloud.intensities()) {
+    // We will ignore returns with intensity above the threshold.
+    weights.push_back(intensity > intensity_threshold ? 0. : scaling_factor);
+    targets.push_back(intensity);
+  }
+  return new BatchedGridCostFunction3D<IntensityHybridGrid>(
+      std::move(transformed_point_cloud), hybrid_grid, std::move(weights),
+      std::move(targets));
+}
+
+}  // namespace scan_matching
+}  // namespace mapping
+}  // namespace cartographer
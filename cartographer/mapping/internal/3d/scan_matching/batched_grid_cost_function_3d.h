@@ -0,0 +1,97 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CARTOGRAPHER_MAPPING_INTERNAL_3D_SCAN_MATCHING_BATCHED_GRID_COST_FUNCTION_3D_H_
+#define CARTOGRAPHER_MAPPING_INTERNAL_3D_SCAN_MATCHING_BATCHED_GRID_COST_FUNCTION_3D_H_
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "Eigen/Core"
+#include "Eigen/StdVector"
+#include "absl/synchronization/mutex.h"
+#include "cartographer/mapping/3d/hybrid_grid.h"
+#include "cartographer/sensor/point_cloud.h"
+#include "ceres/ceres.h"
+
+namespace cartographer {
+namespace mapping {
+namespace scan_matching {
+
+// Caches the 'point_cloud' transformed by the pose held in the translation and
+// rotation parameter blocks of 'CeresScanMatcher3D', together with the
+// derivatives of the transformed points with respect to the rotation. Cost
+// functions for the same point cloud share an instance, so that the points are
+// only transformed once per evaluation of the pose.
+class TransformedPointCloud3D {
+ public:
+  using RotationJacobians =
+      std::vector<Eigen::Matrix<double, 3, 4>,
+                  Eigen::aligned_allocator<Eigen::Matrix<double, 3, 4>>>;
+
+  explicit TransformedPointCloud3D(const sensor::PointCloud& point_cloud);
+
+  TransformedPointCloud3D(const TransformedPointCloud3D&) = delete;
+  TransformedPointCloud3D& operator=(const TransformedPointCloud3D&) = delete;
+
+  const sensor::PointCloud& point_cloud() const { return point_cloud_; }
+
+  // Calls 'function(world_points, rotation_jacobians)' with the points
+  // transformed by 'translation' and the (w, x, y, z) quaternion 'rotation'.
+  // The rotation Jacobians are only valid if 'with_jacobians' is true.
+  template <typename FunctionType>
+  void Evaluate(const double* const translation, const double* const rotation,
+                const bool with_jacobians, const FunctionType& function) {
+    absl::MutexLock locker(&mutex_);
+    Update(translation, rotation, with_jacobians);
+    function(world_points_, rotation_jacobians_);
+  }
+
+ private:
+  void Update(const double* translation, const double* rotation,
+              bool with_jacobians) EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  const sensor::PointCloud& point_cloud_;
+  absl::Mutex mutex_;
+  bool has_pose_ GUARDED_BY(mutex_) = false;
+  bool has_jacobians_ GUARDED_BY(mutex_) = false;
+  std::array<double, 7> pose_ GUARDED_BY(mutex_);
+  std::vector<Eigen::Vector3d> world_points_ GUARDED_BY(mutex_);
+  RotationJacobians rotation_jacobians_ GUARDED_BY(mutex_);
+};
+
+// Returns a cost function equivalent to
+// 'OccupiedSpaceCostFunction3D::CreateAutoDiffCostFunction' which evaluates
+// all points of 'transformed_point_cloud' in one call with analytic
+// derivatives and keeps the voxels surrounding each point between calls.
+ceres::CostFunction* CreateBatchedOccupiedSpaceCostFunction3D(
+    double scaling_factor,
+    std::shared_ptr<TransformedPointCloud3D> transformed_point_cloud,
+    const HybridGrid& hybrid_grid);
+
+// Same as above, but equivalent to
+// 'IntensityCostFunction3D::CreateAutoDiffCostFunction'.
+ceres::CostFunction* CreateBatchedIntensityCostFunction3D(
+    double scaling_factor, float intensity_threshold,
+    std::shared_ptr<TransformedPointCloud3D> transformed_point_cloud,
+    const IntensityHybridGrid& hybrid_grid);
+
+}  // namespace scan_matching
+}  // namespace mapping
+}  // namespace cartographer
+
+#endif  // CARTOGRAPHER_MAPPING_INTERNAL_3D_SCAN_MATCHING_BATCHED_GRID_COST_FUNCTION_3D_H_
@@ -0,0 +1,145 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cartographer/mapping/internal/3d/scan_matching/batched_grid_cost_function_3d.h"
+
+#include <array>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "cartographer/mapping/3d/hybrid_grid.h"
+#include "cartographer/mapping/internal/3d/scan_matching/intensity_cost_function_3d.h"
+#include "cartographer/mapping/internal/3d/scan_matching/occupied_space_cost_function_3d.h"
+#include "cartographer/sensor/point_cloud.h"
+#include "ceres/ceres.h"
+#include "gtest/gtest.h"
+
+namespace cartographer {
+namespace mapping {
+namespace scan_matching {
+namespace {
+
+class BatchedGridCostFunction3DTest : public ::testing::Test {
+ protected:
+  BatchedGridCostFunction3DTest()
+      : hybrid_grid_(0.1f), intensity_hybrid_grid_(0.1f) {
+    std::mt19937 prng(42);
+    std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+    for (int i = 0; i < 2000; ++i) {
+      const Eigen::Vector3f point(distribution(prng), distribution(prng),
+                                  distribution(prng));
+      hybrid_grid_.SetProbability(hybrid_grid_.GetCellIndex(point),
+                                  0.5f + 0.4f * distribution(prng));
+      intensity_hybrid_grid_.AddIntensity(
+          intensity_hybrid_grid_.GetCellIndex(point),
+          50.f + 40.f * distribution(prng));
+    }
+    std::vector<sensor::RangefinderPoint> points;
+    std::vector<float> intensities;
+    for (int i = 0; i < 100; ++i) {
+      points.push_back({Eigen::Vector3f(0.7f * distribution(prng),
+                                        0.7f * distribution(prng),
+                                        0.7f * distribution(prng))});
+      intensities.push_back(60.f + 50.f * distribution(prng));
+    }
+    point_cloud_ = sensor::PointCloud(points, intensities);
+  }
+
+  // Expects both cost functions to agree on residuals and Jacobians for a few
+  // poses. The same poses are evaluated twice to exercise cached state.
+  void ExpectEquivalent(const ceres::CostFunction& expected,
+                        const ceres::CostFunction& actual) {
+    const int num_residuals = point_cloud_.size();
+    ASSERT_EQ(expected.num_residuals(), num_residuals);
+    ASSERT_EQ(actual.num_residuals(), num_residuals);
+    for (int run = 0; run < 2; ++run) {
+      for (const double angle : {0., 0.1, -0.3}) {
+        const Eigen::Quaterniond rotation(Eigen::AngleAxisd(
+            angle, Eigen::Vector3d(1., -2., 3.).normalized()));
+        const std::array<double, 3> translation{{0.03 * angle, -0.02, 0.05}};
+        const std::array<double, 4> rotation_parameters{
+            {rotation.w(), rotation.x(), rotation.y(), rotation.z()}};
+        const std::array<const double*, 2> parameter_blocks{
+            {translation.data(), rotation_parameters.data()}};
+
+        std::vector<double> expected_residuals(num_residuals);
+        std::vector<double> expected_translation_jacobian(3 * num_residuals);
+        std::vector<double> expected_rotation_jacobian(4 * num_residuals);
+        std::array<double*, 2> expected_jacobians{
+            {expected_translation_jacobian.data(),
+             expected_rotation_jacobian.data()}};
+        ASSERT_TRUE(expected.Evaluate(parameter_blocks.data(),
+                                      expected_residuals.data(),
+                                      expected_jacobians.data()));
+
+        std::vector<double> residuals(num_residuals);
+        ASSERT_TRUE(actual.Evaluate(parameter_blocks.data(), residuals.data(),
+                                    nullptr /* jacobians */));
+        std::vector<double> translation_jacobian(3 * num_residuals);
+        std::vector<double> rotation_jacobian(4 * num_residuals);
+        std::array<double*, 2> jacobians{
+            {translation_jacobian.data(), rotation_jacobian.data()}};
+        ASSERT_TRUE(actual.Evaluate(parameter_blocks.data(), residuals.data(),
+                                    jacobians.data()));
+
+        for (int i = 0; i < num_residuals; ++i) {
+          EXPECT_NEAR(expected_residuals[i], residuals[i], 1e-9);
+        }
+        for (int i = 0; i < 3 * num_residuals; ++i) {
+          EXPECT_NEAR(expected_translation_jacobian[i], translation_jacobian[i],
+                      1e-6);
+        }
+        for (int i = 0; i < 4 * num_residuals; ++i) {
+          EXPECT_NEAR(expected_rotation_jacobian[i], rotation_jacobian[i],
+                      1e-6);
+        }
+      }
+    }
+  }
+
+  HybridGrid hybrid_grid_;
+  IntensityHybridGrid intensity_hybrid_grid_;
+  sensor::PointCloud point_cloud_;
+};
+
+TEST_F(BatchedGridCostFunction3DTest, MatchesAutoDiffCostFunctions) {
+  const auto transformed_point_cloud =
+      std::make_shared<TransformedPointCloud3D>(point_cloud_);
+  std::unique_ptr<ceres::CostFunction> occupied_space_cost_function(
+      OccupiedSpaceCostFunction3D::CreateAutoDiffCostFunction(
+          /*scaling_factor=*/2., point_cloud_, hybrid_grid_));
+  std::unique_ptr<ceres::CostFunction> batched_occupied_space_cost_function(
+      CreateBatchedOccupiedSpaceCostFunction3D(
+          /*scaling_factor=*/2., transformed_point_cloud, hybrid_grid_));
+  std::unique_ptr<ceres::CostFunction> intensity_cost_function(
+      IntensityCostFunction3D::CreateAutoDiffCostFunction(
+          /*scaling_factor=*/0.5, /*intensity_threshold=*/100.f, point_cloud_,
+          intensity_hybrid_grid_));
+  std::unique_ptr<ceres::CostFunction> batched_intensity_cost_function(
+      CreateBatchedIntensityCostFunction3D(
+          /*scaling_factor=*/0.5, /*intensity_threshold=*/100.f,
+          transformed_point_cloud, intensity_hybrid_grid_));
+
+  ExpectEquivalent(*occupied_space_cost_function,
+                   *batched_occupied_space_cost_function);
+  ExpectEquivalent(*intensity_cost_function, *batched_intensity_cost_function);
+}
+
+}  // namespace
+}  // namespace scan_matching
+}  // namespace mapping
+}  // namespace cartographer
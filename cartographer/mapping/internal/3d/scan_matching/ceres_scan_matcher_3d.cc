@@ -16,6 +16,7 @@
 
 #include "cartographer/mapping/internal/3d/scan_matching/ceres_scan_matcher_3d.h"
 
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -23,8 +24,7 @@
 #include "absl/memory/memory.h"
 #include "cartographer/common/internal/ceres_solver_options.h"
 #include "cartographer/mapping/internal/3d/rotation_parameterization.h"
-#include "cartographer/mapping/internal/3d/scan_matching/intensity_cost_function_3d.h"
-#include "cartographer/mapping/internal/3d/scan_matching/occupied_space_cost_function_3d.h"
+#include "cartographer/mapping/internal/3d/scan_matching/batched_grid_cost_function_3d.h"
 #include "cartographer/mapping/internal/3d/scan_matching/rotation_delta_cost_functor_3d.h"
 #include "cartographer/mapping/internal/3d/scan_matching/translation_delta_cost_functor_3d.h"
 #include "cartographer/mapping/internal/optimization/ceres_pose.h"
@@ -113,11 +113,14 @@ void CeresScanMatcher3D::Match(
         *point_clouds_and_hybrid_grids[i].point_cloud;
     const HybridGrid& hybrid_grid =
         *point_clouds_and_hybrid_grids[i].hybrid_grid;
+    // The occupied space and intensity costs share the transformed points.
+    const auto transformed_point_cloud =
+        std::make_shared<TransformedPointCloud3D>(point_cloud);
     problem.AddResidualBlock(
-        OccupiedSpaceCostFunction3D::CreateAutoDiffCostFunction(
+        CreateBatchedOccupiedSpaceCostFunction3D(
             options_.occupied_space_weight(i) /
                 std::sqrt(static_cast<double>(point_cloud.size())),
-            point_cloud, hybrid_grid),
+            transformed_point_cloud, hybrid_grid),
         nullptr /* loss function */, ceres_pose.translation(),
         ceres_pose.rotation());
     if (point_clouds_and_hybrid_grids[i].intensity_hybrid_grid) {
@@ -128,11 +131,11 @@ void CeresScanMatcher3D::Match(
       const IntensityHybridGrid& intensity_hybrid_grid =
           *point_clouds_and_hybrid_grids[i].intensity_hybrid_grid;
       problem.AddResidualBlock(
-          IntensityCostFunction3D::CreateAutoDiffCostFunction(
+          CreateBatchedIntensityCostFunction3D(
               options_.intensity_cost_function_options(i).weight() /
                   std::sqrt(static_cast<double>(point_cloud.size())),
               options_.intensity_cost_function_options(i).intensity_threshold(),
-              point_cloud, intensity_hybrid_grid),
+              transformed_point_cloud, intensity_hybrid_grid),
           new ceres::HuberLoss(
               options_.intensity_cost_function_options(i).huber_scale()),
           ceres_pose.translation(), ceres_pose.rotation());
@@ -20,6 +20,7 @@
 #include <cmath>
 #include <functional>
 #include <limits>
+#include <vector>
 
 #include "Eigen/Geometry"
 #include "absl/memory/memory.h"
@@ -81,6 +82,9 @@ struct DiscreteScan3D {
   // Contains a vector of discretized scans for each 'depth'.
   std::vector<std::vector<Eigen::Array3i>> cell_indices_per_depth;
   float rotational_score;
+  // The low resolution point cloud transformed by 'pose', shared by all
+  // candidates of this scan.
+  std::vector<Eigen::Vector3f> low_resolution_points;
 };
 
 struct Candidate3D {
@@ -119,7 +123,7 @@ FastCorrelativeScanMatcher3D::FastCorrelativeScanMatcher3D(
       width_in_voxels_(hybrid_grid.grid_size()),
       precomputation_grid_stack_(
           absl::make_unique<PrecomputationGridStack3D>(hybrid_grid, options)),
-      low_resolution_hybrid_grid_(low_resolution_hybrid_grid),
+      low_resolution_matcher_(low_resolution_hybrid_grid),
       rotational_scan_matcher_(rotational_scan_matcher_histogram) {}
 
 FastCorrelativeScanMatcher3D::~FastCorrelativeScanMatcher3D() {}
@@ -129,12 +133,11 @@ FastCorrelativeScanMatcher3D::Match(
     const transform::Rigid3d& global_node_pose,
     const transform::Rigid3d& global_submap_pose,
     const TrajectoryNode::Data& constant_data, const float min_score) const {
-  const auto low_resolution_matcher = scan_matching::CreateLowResolutionMatcher(
-      low_resolution_hybrid_grid_, &constant_data.low_resolution_point_cloud);
   const SearchParameters search_parameters{
       common::RoundToInt(options_.linear_xy_search_window() / resolution_),
       common::RoundToInt(options_.linear_z_search_window() / resolution_),
-      options_.angular_search_window(), &low_resolution_matcher};
+      options_.angular_search_window(),
+      &constant_data.low_resolution_point_cloud};
   return MatchWithSearchParameters(
       search_parameters, global_node_pose.cast<float>(),
       global_submap_pose.cast<float>(),
@@ -156,10 +159,9 @@ FastCorrelativeScanMatcher3D::MatchFullSubmap(
   const int linear_window_size =
       (width_in_voxels_ + 1) / 2 +
       common::RoundToInt(max_point_distance / resolution_ + 0.5f);
-  const auto low_resolution_matcher = scan_matching::CreateLowResolutionMatcher(
-      low_resolution_hybrid_grid_, &constant_data.low_resolution_point_cloud);
   const SearchParameters search_parameters{
-      linear_window_size, linear_window_size, M_PI, &low_resolution_matcher};
+      linear_window_size, linear_window_size, M_PI,
+      &constant_data.low_resolution_point_cloud};
   return MatchWithSearchParameters(
       search_parameters,
       transform::Rigid3f::Rotation(global_node_rotation.cast<float>()),
@@ -240,7 +242,15 @@ DiscreteScan3D FastCorrelativeScanMatcher3D::DiscretizeScan(
           low_resolution_cell_at_start - low_resolution_search_window_start);
     }
   }
-  return DiscreteScan3D{pose, cell_indices_per_depth, rotational_score};
+  std::vector<Eigen::Vector3f> low_resolution_points;
+  low_resolution_points.reserve(
+      search_parameters.low_resolution_point_cloud->size());
+  for (const sensor::RangefinderPoint& point :
+       *search_parameters.low_resolution_point_cloud) {
+    low_resolution_points.push_back(pose * point.position);
+  }
+  return DiscreteScan3D{pose, cell_indices_per_depth, rotational_score,
+                        low_resolution_points};
 }
 
 std::vector<DiscreteScan3D> FastCorrelativeScanMatcher3D::GenerateDiscreteScans(
@@ -374,31 +384,38 @@ transform::Rigid3f FastCorrelativeScanMatcher3D::GetPoseFromCandidate(
          discrete_scans[candidate.scan_index].pose;
 }
 
+Candidate3D FastCorrelativeScanMatcher3D::FindFirstLowResolutionMatch(
+    const std::vector<DiscreteScan3D>& discrete_scans,
+    const std::vector<Candidate3D>& candidates, const float min_score) const {
+  for (const Candidate3D& candidate : candidates) {
+    // Candidates are sorted, so the following ones will not have better
+    // scores.
+    if (candidate.score <= min_score) {
+      break;
+    }
+    const float low_resolution_score =
+        low_resolution_matcher_.ScoreTranslation(
+            discrete_scans[candidate.scan_index].low_resolution_points,
+            resolution_ * candidate.offset.matrix().cast<float>());
+    if (low_resolution_score >= options_.min_low_resolution_score()) {
+      // We found the best candidate that passes the matching function.
+      Candidate3D best_candidate = candidate;
+      best_candidate.low_resolution_score = low_resolution_score;
+      return best_candidate;
+    }
+  }
+
+  // No candidate has a good score and passes the matching function.
+  return Candidate3D::Unsuccessful();
+}
+
 Candidate3D FastCorrelativeScanMatcher3D::BranchAndBound(
     const FastCorrelativeScanMatcher3D::SearchParameters& search_parameters,
     const std::vector<DiscreteScan3D>& discrete_scans,
     const std::vector<Candidate3D>& candidates, const int candidate_depth,
     float min_score) const {
   if (candidate_depth == 0) {
-    for (const Candidate3D& candidate : candidates) {
-      if (candidate.score <= min_score) {
-        // Return if the candidate is bad because the following candidate will
-        // not have better score.
-        return Candidate3D::Unsuccessful();
-      }
-      const float low_resolution_score =
-          (*search_parameters.low_resolution_matcher)(
-              GetPoseFromCandidate(discrete_scans, candidate));
-      if (low_resolution_score >= options_.min_low_resolution_score()) {
-        // We found the best candidate that passes the matching function.
-        Candidate3D best_candidate = candidate;
-        best_candidate.low_resolution_score = low_resolution_score;
-        return best_candidate;
-      }
-    }
-
-    // All candidates have good scores but none passes the matching function.
-    return Candidate3D::Unsuccessful();
+    return FindFirstLowResolutionMatch(discrete_scans, candidates, min_score);
   }
 
   Candidate3D best_high_resolution_candidate = Candidate3D::Unsuccessful();
@@ -27,6 +27,7 @@
 #include "cartographer/common/port.h"
 #include "cartographer/mapping/3d/hybrid_grid.h"
 #include "cartographer/mapping/internal/2d/scan_matching/fast_correlative_scan_matcher_2d.h"
+#include "cartographer/mapping/internal/3d/scan_matching/low_resolution_matcher.h"
 #include "cartographer/mapping/internal/3d/scan_matching/precomputation_grid_3d.h"
 #include "cartographer/mapping/internal/3d/scan_matching/rotational_scan_matcher.h"
 #include "cartographer/mapping/proto/scan_matching/fast_correlative_scan_matcher_options_3d.pb.h"
@@ -60,9 +61,6 @@ class PrecomputationGridStack3D {
 struct DiscreteScan3D;
 struct Candidate3D;
 
-// Used to compute scores between 0 and 1 how well the given pose matches.
-using MatchingFunction = std::function<float(const transform::Rigid3f&)>;
-
 class FastCorrelativeScanMatcher3D {
  public:
   struct Result {
@@ -105,7 +103,7 @@ class FastCorrelativeScanMatcher3D {
     const int linear_xy_window_size;     // voxels
     const int linear_z_window_size;      // voxels
     const double angular_search_window;  // radians
-    const MatchingFunction* const low_resolution_matcher;
+    const sensor::PointCloud* const low_resolution_point_cloud;
   };
 
   std::unique_ptr<Result> MatchWithSearchParameters(
@@ -115,6 +113,11 @@ class FastCorrelativeScanMatcher3D {
       const sensor::PointCloud& point_cloud,
       const Eigen::VectorXf& rotational_scan_matcher_histogram,
       const Eigen::Quaterniond& gravity_alignment, float min_score) const;
+  // Returns the first of the 'candidates' above 'min_score' which passes the
+  // low resolution matcher. Candidates are scored one at a time, in order.
+  Candidate3D FindFirstLowResolutionMatch(
+      const std::vector<DiscreteScan3D>& discrete_scans,
+      const std::vector<Candidate3D>& candidates, float min_score) const;
   DiscreteScan3D DiscretizeScan(const SearchParameters& search_parameters,
                                 const sensor::PointCloud& point_cloud,
                                 const transform::Rigid3f& pose,
@@ -146,7 +149,7 @@ class FastCorrelativeScanMatcher3D {
   const float resolution_;
   const int width_in_voxels_;
   std::unique_ptr<PrecomputationGridStack3D> precomputation_grid_stack_;
-  const HybridGrid* const low_resolution_hybrid_grid_;
+  const LowResolutionMatcher low_resolution_matcher_;
   RotationalScanMatcher rotational_scan_matcher_;
 };
 
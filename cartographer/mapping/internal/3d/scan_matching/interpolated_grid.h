@@ -17,8 +17,11 @@
 #ifndef CARTOGRAPHER_MAPPING_INTERNAL_3D_SCAN_MATCHING_INTERPOLATED_GRID_H_
 #define CARTOGRAPHER_MAPPING_INTERNAL_3D_SCAN_MATCHING_INTERPOLATED_GRID_H_
 
+#include <array>
 #include <cmath>
+#include <limits>
 
+#include "Eigen/Core"
 #include "cartographer/mapping/3d/hybrid_grid.h"
 
 namespace cartographer {
@@ -35,6 +38,16 @@ namespace scan_matching {
 template <class HybridGridType>
 class InterpolatedGrid {
  public:
+  // Values of the 8 voxels whose centers enclose a point. Evaluating points
+  // which stay between the same voxel centers, e.g. over the iterations of a
+  // scan matcher, then skips the lookups in the nested 'HybridGrid'.
+  struct CachedVoxels {
+    Eigen::Array3i lower_index =
+        Eigen::Array3i::Constant(std::numeric_limits<int>::min());
+    // Indexed by 4 * dx + 2 * dy + dz relative to 'lower_index'.
+    std::array<double, 8> values;
+  };
+
   explicit InterpolatedGrid(const HybridGridType& hybrid_grid)
       : hybrid_grid_(hybrid_grid) {}
 
@@ -103,6 +116,88 @@ class InterpolatedGrid {
            q1;
   }
 
+  // Returns the same value as 'GetInterpolatedValue' and stores its gradient
+  // in 'gradient'. 'cached_voxels' is updated if the point is not between the
+  // voxel centers it holds. It must only be used with this grid.
+  double GetInterpolatedValueAndGradient(
+      const double x, const double y, const double z,
+      CachedVoxels* const cached_voxels,
+      Eigen::Vector3d* const gradient) const {
+    double x1, y1, z1, x2, y2, z2;
+    ComputeInterpolationDataPoints(x, y, z, &x1, &y1, &z1, &x2, &y2, &z2);
+
+    const Eigen::Array3i index1 =
+        hybrid_grid_.GetCellIndex(Eigen::Vector3f(x1, y1, z1));
+    if ((cached_voxels->lower_index != index1).any()) {
+      cached_voxels->lower_index = index1;
+      for (int i = 0; i < 8; ++i) {
+        cached_voxels->values[i] = GetValue(
+            hybrid_grid_,
+            index1 + Eigen::Array3i((i >> 2) & 1, (i >> 1) & 1, i & 1));
+      }
+    }
+    const std::array<double, 8>& q = cached_voxels->values;
+    const double q111 = q[0];
+    const double q112 = q[1];
+    const double q121 = q[2];
+    const double q122 = q[3];
+    const double q211 = q[4];
+    const double q212 = q[5];
+    const double q221 = q[6];
+    const double q222 = q[7];
+
+    const double normalized_x = (x - x1) / (x2 - x1);
+    const double normalized_y = (y - y1) / (y2 - y1);
+    const double normalized_z = (z - z1) / (z2 - z1);
+
+    const double normalized_xx = normalized_x * normalized_x;
+    const double normalized_xxx = normalized_x * normalized_xx;
+    const double normalized_yy = normalized_y * normalized_y;
+    const double normalized_yyy = normalized_y * normalized_yy;
+    const double normalized_zz = normalized_z * normalized_z;
+    const double normalized_zzz = normalized_z * normalized_zz;
+
+    // Same scheme as in 'GetInterpolatedValue'. For the gradient, note that
+    // A * (2t^3 - 3t^2 + 1) + B * (-2t^3 + 3t^2) has the derivative
+    // (A - B) * (6t^2 - 6t) with respect to t.
+    const double q11 = (q111 - q112) * normalized_zzz * 2. +
+                       (q112 - q111) * normalized_zz * 3. + q111;
+    const double q12 = (q121 - q122) * normalized_zzz * 2. +
+                       (q122 - q121) * normalized_zz * 3. + q121;
+    const double q21 = (q211 - q212) * normalized_zzz * 2. +
+                       (q212 - q211) * normalized_zz * 3. + q211;
+    const double q22 = (q221 - q222) * normalized_zzz * 2. +
+                       (q222 - q221) * normalized_zz * 3. + q221;
+    const double q1 = (q11 - q12) * normalized_yyy * 2. +
+                      (q12 - q11) * normalized_yy * 3. + q11;
+    const double q2 = (q21 - q22) * normalized_yyy * 2. +
+                      (q22 - q21) * normalized_yy * 3. + q21;
+
+    const double weight_x1 = normalized_xxx * 2. - normalized_xx * 3. + 1.;
+    const double weight_x2 = 1. - weight_x1;
+    const double weight_y1 = normalized_yyy * 2. - normalized_yy * 3. + 1.;
+    const double weight_y2 = 1. - weight_y1;
+    const double derivative_x = 6. * (normalized_xx - normalized_x);
+    const double derivative_y = 6. * (normalized_yy - normalized_y);
+    const double derivative_z = 6. * (normalized_zz - normalized_z);
+
+    const double dq11_dz = (q111 - q112) * derivative_z;
+    const double dq12_dz = (q121 - q122) * derivative_z;
+    const double dq21_dz = (q211 - q212) * derivative_z;
+    const double dq22_dz = (q221 - q222) * derivative_z;
+    const double dq1_dz = dq11_dz * weight_y1 + dq12_dz * weight_y2;
+    const double dq2_dz = dq21_dz * weight_y1 + dq22_dz * weight_y2;
+    const double dq1_dy = (q11 - q12) * derivative_y;
+    const double dq2_dy = (q21 - q22) * derivative_y;
+    *gradient = Eigen::Vector3d(
+        (q1 - q2) * derivative_x / (x2 - x1),
+        (dq1_dy * weight_x1 + dq2_dy * weight_x2) / (y2 - y1),
+        (dq1_dz * weight_x1 + dq2_dz * weight_x2) / (z2 - z1));
+
+    return (q1 - q2) * normalized_xxx * 2. + (q2 - q1) * normalized_xx * 3. +
+           q1;
+  }
+
  private:
   template <typename T>
   void ComputeInterpolationDataPoints(const T& x, const T& y, const T& z,
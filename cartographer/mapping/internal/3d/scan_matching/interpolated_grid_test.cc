@@ -84,6 +84,34 @@ TEST_F(InterpolatedGridTest, MonotonicBehaviorBetweenGridPointsInX) {
   }
 }
 
+TEST_F(InterpolatedGridTest, GradientMatchesFiniteDifferences) {
+  constexpr double kDelta = 1e-6;
+  InterpolatedProbabilityGrid::CachedVoxels cached_voxels;
+  for (double z = -0.13; z < 0.2; z += 0.011) {
+    for (double y = 1.87; y < 2.2; y += 0.013) {
+      for (double x = -3.17; x < -2.8; x += 0.017) {
+        Eigen::Vector3d gradient;
+        const double value = interpolated_grid_.GetInterpolatedValueAndGradient(
+            x, y, z, &cached_voxels, &gradient);
+        EXPECT_EQ(interpolated_grid_.GetInterpolatedValue(x, y, z), value);
+        const Eigen::Vector3d expected_gradient(
+            (interpolated_grid_.GetInterpolatedValue(x + kDelta, y, z) -
+             interpolated_grid_.GetInterpolatedValue(x - kDelta, y, z)) /
+                (2. * kDelta),
+            (interpolated_grid_.GetInterpolatedValue(x, y + kDelta, z) -
+             interpolated_grid_.GetInterpolatedValue(x, y - kDelta, z)) /
+                (2. * kDelta),
+            (interpolated_grid_.GetInterpolatedValue(x, y, z + kDelta) -
+             interpolated_grid_.GetInterpolatedValue(x, y, z - kDelta)) /
+                (2. * kDelta));
+        EXPECT_NEAR(expected_gradient.x(), gradient.x(), 1e-4);
+        EXPECT_NEAR(expected_gradient.y(), gradient.y(), 1e-4);
+        EXPECT_NEAR(expected_gradient.z(), gradient.z(), 1e-4);
+      }
+    }
+  }
+}
+
 }  // namespace
 }  // namespace scan_matching
 }  // namespace mapping
@@ -14,24 +14,108 @@
  * limitations under the License.
  */
 
+
 #include "cartographer/mapping/internal/3d/scan_matching/low_resolution_matcher.h"
 
+#include <limits>
+#include <set>
+#include <tuple>
+
+#include "cartographer/common/math.h"
+#include "cartographer/mapping/probability_values.h"
+#include "glog/logging.h"
+
 namespace cartographer {
 namespace mapping {
 namespace scan_matching {
+namespace {
 
-std::function<float(const transform::Rigid3f&)> CreateLowResolutionMatcher(
-    const HybridGrid* low_resolution_grid, const sensor::PointCloud* points) {
-  return [=](const transform::Rigid3f& pose) {
-    float score = 0.f;
-    for (const sensor::RangefinderPoint& point :
-         sensor::TransformPointCloud(*points, pose)) {
-      // TODO(zhengj, whess): Interpolate the Grid to get better score.
-      score += low_resolution_grid->GetProbability(
-          low_resolution_grid->GetCellIndex(point.position));
+// The 'HybridGrid' allocates cells in blocks of 8 x 8 x 8. The dense copy may
+// take up to this many times the memory of the allocated blocks.
+constexpr int kBlockSize = 8;
+constexpr int64 kMaxDenseCellsPerAllocatedCell = 4;
+
+}  // namespace
+
+LowResolutionMatcher::LowResolutionMatcher(
+    const HybridGrid* const low_resolution_grid)
+    : low_resolution_grid_(low_resolution_grid),
+      min_cell_index_(Eigen::Array3i::Zero()),
+      size_(Eigen::Array3i::Zero()) {
+  CHECK(low_resolution_grid_ != nullptr);
+  Eigen::Array3i min_cell_index =
+      Eigen::Array3i::Constant(std::numeric_limits<int>::max());
+  Eigen::Array3i max_cell_index =
+      Eigen::Array3i::Constant(std::numeric_limits<int>::min());
+  std::set<std::tuple<int, int, int>> blocks;
+  for (auto it = HybridGrid::Iterator(*low_resolution_grid_); !it.Done();
+       it.Next()) {
+    const Eigen::Array3i cell_index = it.GetCellIndex();
+    min_cell_index = min_cell_index.min(cell_index);
+    max_cell_index = max_cell_index.max(cell_index);
+    // Floor division, since cell indices can be negative.
+    const Eigen::Array3i block =
+        (cell_index - (cell_index < 0).cast<int>() * (kBlockSize - 1)) /
+        kBlockSize;
+    blocks.emplace(block.x(), block.y(), block.z());
+  }
+  if (blocks.empty()) {
+    return;
+  }
+  const Eigen::Array3i size = max_cell_index - min_cell_index + 1;
+  const int64 num_dense_cells = size.cast<int64>().prod();
+  const int64 num_allocated_cells =
+      static_cast<int64>(blocks.size()) * common::Power(kBlockSize, 3);
+  if (num_dense_cells >
+      kMaxDenseCellsPerAllocatedCell * num_allocated_cells) {
+    return;
+  }
+  min_cell_index_ = min_cell_index;
+  size_ = size;
+  values_.reserve(num_dense_cells);
+  for (int z = 0; z != size_.z(); ++z) {
+    for (int y = 0; y != size_.y(); ++y) {
+      for (int x = 0; x != size_.x(); ++x) {
+        values_.push_back(low_resolution_grid_->value(
+            min_cell_index_ + Eigen::Array3i(x, y, z)));
+      }
     }
-    return score / points->size();
-  };
+  }
+}
+
+uint16 LowResolutionMatcher::GetValue(const Eigen::Array3i& cell_index) const {
+  if (values_.empty()) {
+    return low_resolution_grid_->value(cell_index);
+  }
+  const Eigen::Array3i offset = cell_index - min_cell_index_;
+  // All known cells are inside of the box.
+  if ((offset < 0).any() || (offset >= size_).any()) {
+    return kUnknownProbabilityValue;
+  }
+  return values_[(offset.z() * size_.y() + offset.y()) * size_.x() +
+                 offset.x()];
+}
+
+float LowResolutionMatcher::Score(const transform::Rigid3f& pose,
+                                  const sensor::PointCloud& points) const {
+  std::vector<Eigen::Vector3f> transformed_points;
+  transformed_points.reserve(points.size());
+  for (const sensor::RangefinderPoint& point : points) {
+    transformed_points.push_back(pose * point.position);
+  }
+  return ScoreTranslation(transformed_points, Eigen::Vector3f::Zero());
+}
+
+float LowResolutionMatcher::ScoreTranslation(
+    const std::vector<Eigen::Vector3f>& points,
+    const Eigen::Vector3f& translation) const {
+  float score = 0.f;
+  for (const Eigen::Vector3f& point : points) {
+    // TODO(zhengj, whess): Interpolate the Grid to get better score.
+    score += ValueToProbability(
+        GetValue(low_resolution_grid_->GetCellIndex(point + translation)));
+  }
+  return score / points.size();
 }
 
 }  // namespace scan_matching
@@ -17,8 +17,10 @@
 #ifndef CARTOGRAPHER_MAPPING_INTERNAL_3D_SCAN_MATCHING_LOW_RESOLUTION_MATCHER_H_
 #define CARTOGRAPHER_MAPPING_INTERNAL_3D_SCAN_MATCHING_LOW_RESOLUTION_MATCHER_H_
 
-#include <functional>
+#include <vector>
 
+#include "Eigen/Core"
+#include "cartographer/common/port.h"
 #include "cartographer/mapping/3d/hybrid_grid.h"
 #include "cartographer/sensor/point_cloud.h"
 #include "cartographer/transform/rigid_transform.h"
@@ -27,8 +29,36 @@ namespace cartographer {
 namespace mapping {
 namespace scan_matching {
 
-std::function<float(const transform::Rigid3f&)> CreateLowResolutionMatcher(
-    const HybridGrid* low_resolution_grid, const sensor::PointCloud* points);
+// Scores how well a low resolution point cloud matches a low resolution grid
+// as the mean probability of the cells hit. The values of the grid are copied
+// once into a dense array covering all its known cells, unless that would take
+// much more memory than the grid itself.
+class LowResolutionMatcher {
+ public:
+  explicit LowResolutionMatcher(const HybridGrid* low_resolution_grid);
+
+  LowResolutionMatcher(const LowResolutionMatcher&) = delete;
+  LowResolutionMatcher& operator=(const LowResolutionMatcher&) = delete;
+
+  // Returns the score of 'points' transformed by 'pose'.
+  float Score(const transform::Rigid3f& pose,
+              const sensor::PointCloud& points) const;
+
+  // Returns the score of 'points', which are in the frame of the grid,
+  // translated by 'translation'.
+  float ScoreTranslation(const std::vector<Eigen::Vector3f>& points,
+                         const Eigen::Vector3f& translation) const;
+
+ private:
+  uint16 GetValue(const Eigen::Array3i& cell_index) const;
+
+  const HybridGrid* const low_resolution_grid_;
+  // Box of cells copied into 'values_', which is empty if the grid is
+  // accessed directly.
+  Eigen::Array3i min_cell_index_;
+  Eigen::Array3i size_;
+  std::vector<uint16> values_;
+};
 
 }  // namespace scan_matching
 }  // namespace mapping
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cartographer/mapping/internal/3d/scan_matching/low_resolution_matcher.h"
+
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace cartographer {
+namespace mapping {
+namespace scan_matching {
+namespace {
+
+// Scores 'points' transformed by 'pose' by looking up each point in 'grid'.
+float ScoreDirectly(const HybridGrid& grid, const transform::Rigid3f& pose,
+                    const sensor::PointCloud& points) {
+  float score = 0.f;
+  for (const sensor::RangefinderPoint& point : points) {
+    score += grid.GetProbability(grid.GetCellIndex(pose * point.position));
+  }
+  return score / points.size();
+}
+
+class LowResolutionMatcherTest : public ::testing::Test {
+ protected:
+  LowResolutionMatcherTest() : grid_(0.5f) {
+    std::mt19937 prng(42);
+    std::uniform_real_distribution<float> distribution(-5.f, 5.f);
+    for (int i = 0; i < 200; ++i) {
+      const Eigen::Vector3f position(distribution(prng), distribution(prng),
+                                     0.2f * distribution(prng));
+      points_.push_back({position});
+      grid_.SetProbability(grid_.GetCellIndex(position),
+                           0.6f + 0.06f * distribution(prng));
+    }
+  }
+
+  void ExpectScoresMatch(const LowResolutionMatcher& matcher) {
+    for (const transform::Rigid3f& pose :
+         {transform::Rigid3f::Identity(),
+          transform::Rigid3f(Eigen::Vector3f(0.3f, -0.7f, 0.1f),
+                             Eigen::Quaternionf(Eigen::AngleAxisf(
+                                 0.2f, Eigen::Vector3f::UnitZ()))),
+          transform::Rigid3f::Translation(Eigen::Vector3f(20.f, 0.f, 0.f))}) {
+      EXPECT_NEAR(ScoreDirectly(grid_, pose, points_),
+                  matcher.Score(pose, points_), 1e-6f);
+    }
+
+    std::vector<Eigen::Vector3f> points;
+    for (const sensor::RangefinderPoint& point : points_) {
+      points.push_back(point.position);
+    }
+    for (const Eigen::Vector3f& translation :
+         {Eigen::Vector3f(Eigen::Vector3f::Zero()),
+          Eigen::Vector3f(0.5f, 0.f, 0.f), Eigen::Vector3f(-1.f, 1.5f, 0.5f)}) {
+      const transform::Rigid3f pose =
+          transform::Rigid3f::Translation(translation);
+      EXPECT_NEAR(ScoreDirectly(grid_, pose, points_),
+                  matcher.ScoreTranslation(points, translation), 1e-6f);
+    }
+  }
+
+  HybridGrid grid_;
+  sensor::PointCloud points_;
+};
+
+TEST_F(LowResolutionMatcherTest, MatchesGridWithDenseCopy) {
+  ExpectScoresMatch(LowResolutionMatcher(&grid_));
+}
+
+TEST_F(LowResolutionMatcherTest, MatchesSparseGrid) {
+  // Known cells far apart make the dense copy too large to be used.
+  grid_.SetProbability(grid_.GetCellIndex(Eigen::Vector3f(200.f, 0.f, 50.f)),
+                       0.7f);
+  ExpectScoresMatch(LowResolutionMatcher(&grid_));
+}
+
+}  // namespace
+}  // namespace scan_matching
+}  // namespace mapping
+}  // namespace cartographer
@@ -16,26 +16,120 @@
 
 #include "cartographer/mapping/internal/3d/scan_matching/real_time_correlative_scan_matcher_3d.h"
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
+#include <vector>
 
 #include "Eigen/Geometry"
+#include "absl/memory/memory.h"
 #include "cartographer/common/math.h"
+#include "cartographer/common/parallel_for.h"
+#include "cartographer/common/port.h"
 #include "cartographer/transform/transform.h"
 #include "glog/logging.h"
 
 namespace cartographer {
 namespace mapping {
 namespace scan_matching {
+namespace {
+
+// Upper bound on the number of cells copied into a 'DenseHybridGridWindow'.
+constexpr int64 kMaxDenseWindowNumCells = int64{1} << 24;
+
+// The values of the cells of a 'HybridGrid' inside a box, stored contiguously.
+// Cells outside of the box are looked up in the 'HybridGrid'.
+class DenseHybridGridWindow {
+ public:
+  // Creates an empty window if 'max_index' is not at least 'min_index'.
+  DenseHybridGridWindow(const HybridGrid& hybrid_grid,
+                        const Eigen::Array3i& min_index,
+                        const Eigen::Array3i& max_index)
+      : hybrid_grid_(hybrid_grid),
+        min_index_(min_index),
+        size_((max_index - min_index + 1).max(0)) {
+    values_.reserve(size_.prod());
+    for (int z = 0; z != size_.z(); ++z) {
+      for (int y = 0; y != size_.y(); ++y) {
+        for (int x = 0; x != size_.x(); ++x) {
+          values_.push_back(
+              hybrid_grid.value(min_index_ + Eigen::Array3i(x, y, z)));
+        }
+      }
+    }
+  }
+
+  float GetProbability(const Eigen::Array3i& index) const {
+    const Eigen::Array3i offset = index - min_index_;
+    if ((offset < 0).any() || (offset >= size_).any()) {
+      return hybrid_grid_.GetProbability(index);
+    }
+    return ValueToProbability(
+        values_[(offset.z() * size_.y() + offset.y()) * size_.x() +
+                offset.x()]);
+  }
+
+ private:
+  const HybridGrid& hybrid_grid_;
+  const Eigen::Array3i min_index_;
+  const Eigen::Array3i size_;
+  std::vector<uint16> values_;
+};
+
+// Returns the window of 'hybrid_grid' containing all cells the candidates can
+// hit, or an empty window if copying it is not cheaper than looking up
+// 'num_lookups' cells in 'hybrid_grid'. A rotation by up to 'max_angle' moves
+// a point by at most 'max_angle' times its range.
+DenseHybridGridWindow CreateDenseHybridGridWindow(
+    const HybridGrid& hybrid_grid, const sensor::PointCloud& point_cloud,
+    const transform::Rigid3f& initial_pose_estimate,
+    const float max_translation, const float max_angle,
+    const int64 num_lookups) {
+  Eigen::Vector3f min = Eigen::Vector3f::Constant(
+      std::numeric_limits<float>::max());
+  Eigen::Vector3f max = -min;
+  float max_range = 0.f;
+  for (const sensor::RangefinderPoint& point : point_cloud) {
+    const Eigen::Vector3f position = initial_pose_estimate * point.position;
+    min = min.cwiseMin(position);
+    max = max.cwiseMax(position);
+    max_range = std::max(max_range, point.position.norm());
+  }
+  const float margin =
+      max_translation + max_angle * max_range + hybrid_grid.resolution();
+  const Eigen::Array3i min_index =
+      hybrid_grid.GetCellIndex(min - Eigen::Vector3f::Constant(margin));
+  const Eigen::Array3i max_index =
+      hybrid_grid.GetCellIndex(max + Eigen::Vector3f::Constant(margin));
+  const int64 num_cells =
+      (max_index - min_index + 1).max(0).cast<int64>().prod();
+  if (num_cells > std::min(num_lookups, kMaxDenseWindowNumCells)) {
+    return DenseHybridGridWindow(hybrid_grid, Eigen::Array3i::Zero(),
+                                 Eigen::Array3i::Constant(-1));
+  }
+  return DenseHybridGridWindow(hybrid_grid, min_index, max_index);
+}
+
+}  // namespace
 
 RealTimeCorrelativeScanMatcher3D::RealTimeCorrelativeScanMatcher3D(
     const proto::RealTimeCorrelativeScanMatcherOptions& options)
-    : options_(options) {}
+    : options_(options) {
+  if (options_.batched_evaluation_3d() && options_.num_threads_3d() > 1) {
+    thread_pool_ =
+        absl::make_unique<common::ThreadPool>(options_.num_threads_3d() - 1);
+  }
+}
 
 float RealTimeCorrelativeScanMatcher3D::Match(
     const transform::Rigid3d& initial_pose_estimate,
     const sensor::PointCloud& point_cloud, const HybridGrid& hybrid_grid,
     transform::Rigid3d* pose_estimate) const {
   CHECK(pose_estimate != nullptr);
+  if (options_.batched_evaluation_3d()) {
+    return MatchBatched(initial_pose_estimate, point_cloud, hybrid_grid,
+                        pose_estimate);
+  }
   float best_score = -1.f;
   for (const transform::Rigid3f& transform : GenerateExhaustiveSearchTransforms(
            hybrid_grid.resolution(), point_cloud)) {
@@ -52,10 +146,96 @@ float RealTimeCorrelativeScanMatcher3D::Match(
   return best_score;
 }
 
-std::vector<transform::Rigid3f>
-RealTimeCorrelativeScanMatcher3D::GenerateExhaustiveSearchTransforms(
+float RealTimeCorrelativeScanMatcher3D::MatchBatched(
+    const transform::Rigid3d& initial_pose_estimate,
+    const sensor::PointCloud& point_cloud, const HybridGrid& hybrid_grid,
+    transform::Rigid3d* pose_estimate) const {
+  CHECK(!point_cloud.empty());
+  const SearchSpace search_space =
+      GenerateSearchSpace(hybrid_grid.resolution(), point_cloud);
+  const transform::Rigid3f initial_pose = initial_pose_estimate.cast<float>();
+  const size_t num_translations = search_space.translations.size();
+  const size_t num_rotations = search_space.rotations.size();
+
+  // The translations in the frame of the grid.
+  std::vector<Eigen::Vector3f> offsets;
+  float max_translation = 0.f;
+  for (const Eigen::Vector3f& translation : search_space.translations) {
+    offsets.push_back(initial_pose.rotation() * translation);
+    max_translation = std::max(max_translation, translation.norm());
+  }
+  std::vector<float> angles;
+  float max_angle = 0.f;
+  for (const Eigen::Quaternionf& rotation : search_space.rotations) {
+    angles.push_back(
+        transform::GetAngle(transform::Rigid3f::Rotation(rotation)));
+    max_angle = std::max(max_angle, angles.back());
+  }
+  const DenseHybridGridWindow window = CreateDenseHybridGridWindow(
+      hybrid_grid, point_cloud, initial_pose, max_translation, max_angle,
+      static_cast<int64>(num_translations * num_rotations) *
+          point_cloud.size());
+
+  // The best score and the index of its translation for each rotation.
+  std::vector<float> best_scores(num_rotations, -1.f);
+  std::vector<size_t> best_translation_indices(num_rotations, 0);
+  const auto match_rotations = [&](const size_t begin, const size_t end) {
+    std::vector<Eigen::Vector3f> rotated_points(point_cloud.size());
+    for (size_t r = begin; r != end; ++r) {
+      const Eigen::Quaternionf rotation =
+          initial_pose.rotation() * search_space.rotations[r];
+      for (size_t i = 0; i != point_cloud.size(); ++i) {
+        rotated_points[i] =
+            rotation * point_cloud[i].position + initial_pose.translation();
+      }
+      for (size_t t = 0; t != num_translations; ++t) {
+        float score = 0.f;
+        for (const Eigen::Vector3f& point : rotated_points) {
+          score += window.GetProbability(
+              hybrid_grid.GetCellIndex(point + offsets[t]));
+        }
+        score /= static_cast<float>(point_cloud.size());
+        score *= ComputeDeltaCostFactor(search_space.translations[t].norm(),
+                                        angles[r]);
+        CHECK_GT(score, 0.f);
+        if (score > best_scores[r]) {
+          best_scores[r] = score;
+          best_translation_indices[r] = t;
+        }
+      }
+    }
+  };
+  if (thread_pool_ == nullptr) {
+    match_rotations(0, num_rotations);
+  } else {
+    common::ParallelFor(thread_pool_.get(), num_rotations,
+                        options_.num_threads_3d(), match_rotations);
+  }
+
+  // Among equal scores, prefer the candidate Match() would have found first.
+  size_t best_rotation_index = 0;
+  for (size_t r = 1; r != num_rotations; ++r) {
+    if (best_scores[r] > best_scores[best_rotation_index] ||
+        (best_scores[r] == best_scores[best_rotation_index] &&
+         best_translation_indices[r] <
+             best_translation_indices[best_rotation_index])) {
+      best_rotation_index = r;
+    }
+  }
+  *pose_estimate =
+      (initial_pose *
+       transform::Rigid3f(
+           search_space
+               .translations[best_translation_indices[best_rotation_index]],
+           search_space.rotations[best_rotation_index]))
+          .cast<double>();
+  return best_scores[best_rotation_index];
+}
+
+RealTimeCorrelativeScanMatcher3D::SearchSpace
+RealTimeCorrelativeScanMatcher3D::GenerateSearchSpace(
     const float resolution, const sensor::PointCloud& point_cloud) const {
-  std::vector<transform::Rigid3f> result;
+  SearchSpace result;
   const int linear_window_size =
       common::RoundToInt(options_.linear_search_window() / resolution);
   // We set this value to something on the order of resolution to make sure that
@@ -74,26 +254,48 @@ RealTimeCorrelativeScanMatcher3D::GenerateExhaustiveSearchTransforms(
   for (int z = -linear_window_size; z <= linear_window_size; ++z) {
     for (int y = -linear_window_size; y <= linear_window_size; ++y) {
       for (int x = -linear_window_size; x <= linear_window_size; ++x) {
-        for (int rz = -angular_window_size; rz <= angular_window_size; ++rz) {
-          for (int ry = -angular_window_size; ry <= angular_window_size; ++ry) {
-            for (int rx = -angular_window_size; rx <= angular_window_size;
-                 ++rx) {
-              const Eigen::Vector3f angle_axis(rx * angular_step_size,
-                                               ry * angular_step_size,
-                                               rz * angular_step_size);
-              result.emplace_back(
-                  Eigen::Vector3f(x * resolution, y * resolution,
-                                  z * resolution),
-                  transform::AngleAxisVectorToRotationQuaternion(angle_axis));
-            }
-          }
-        }
+        result.translations.emplace_back(x * resolution, y * resolution,
+                                         z * resolution);
+      }
+    }
+  }
+  for (int rz = -angular_window_size; rz <= angular_window_size; ++rz) {
+    for (int ry = -angular_window_size; ry <= angular_window_size; ++ry) {
+      for (int rx = -angular_window_size; rx <= angular_window_size; ++rx) {
+        const Eigen::Vector3f angle_axis(rx * angular_step_size,
+                                         ry * angular_step_size,
+                                         rz * angular_step_size);
+        result.rotations.push_back(
+            transform::AngleAxisVectorToRotationQuaternion(angle_axis));
       }
     }
   }
   return result;
 }
 
+std::vector<transform::Rigid3f>
+RealTimeCorrelativeScanMatcher3D::GenerateExhaustiveSearchTransforms(
+    const float resolution, const sensor::PointCloud& point_cloud) const {
+  const SearchSpace search_space =
+      GenerateSearchSpace(resolution, point_cloud);
+  std::vector<transform::Rigid3f> result;
+  result.reserve(search_space.translations.size() *
+                 search_space.rotations.size());
+  for (const Eigen::Vector3f& translation : search_space.translations) {
+    for (const Eigen::Quaternionf& rotation : search_space.rotations) {
+      result.emplace_back(translation, rotation);
+    }
+  }
+  return result;
+}
+
+float RealTimeCorrelativeScanMatcher3D::ComputeDeltaCostFactor(
+    const float translation_norm, const float angle) const {
+  return std::exp(-common::Pow2(
+      translation_norm * options_.translation_delta_cost_weight() +
+      angle * options_.rotation_delta_cost_weight()));
+}
+
 float RealTimeCorrelativeScanMatcher3D::ScoreCandidate(
     const HybridGrid& hybrid_grid,
     const sensor::PointCloud& transformed_point_cloud,
@@ -104,11 +306,8 @@ float RealTimeCorrelativeScanMatcher3D::ScoreCandidate(
         hybrid_grid.GetProbability(hybrid_grid.GetCellIndex(point.position));
   }
   score /= static_cast<float>(transformed_point_cloud.size());
-  const float angle = transform::GetAngle(transform);
-  score *=
-      std::exp(-common::Pow2(transform.translation().norm() *
-                                 options_.translation_delta_cost_weight() +
-                             angle * options_.rotation_delta_cost_weight()));
+  score *= ComputeDeltaCostFactor(transform.translation().norm(),
+                                  transform::GetAngle(transform));
   CHECK_GT(score, 0.f);
   return score;
 }
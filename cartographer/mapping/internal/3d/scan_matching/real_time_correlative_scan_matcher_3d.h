@@ -17,9 +17,12 @@
 #ifndef CARTOGRAPHER_MAPPING_INTERNAL_3D_SCAN_MATCHING_REAL_TIME_CORRELATIVE_SCAN_MATCHER_3D_H_
 #define CARTOGRAPHER_MAPPING_INTERNAL_3D_SCAN_MATCHING_REAL_TIME_CORRELATIVE_SCAN_MATCHER_3D_H_
 
+#include <memory>
 #include <vector>
 
 #include "Eigen/Core"
+#include "Eigen/Geometry"
+#include "cartographer/common/thread_pool.h"
 #include "cartographer/mapping/3d/hybrid_grid.h"
 #include "cartographer/mapping/proto/scan_matching/real_time_correlative_scan_matcher_options.pb.h"
 #include "cartographer/sensor/point_cloud.h"
@@ -50,13 +53,35 @@ class RealTimeCorrelativeScanMatcher3D {
               transform::Rigid3d* pose_estimate) const;
 
  private:
+  // The search space is the product of 'translations' and 'rotations', with
+  // the translation varying slowest.
+  struct SearchSpace {
+    std::vector<Eigen::Vector3f> translations;
+    std::vector<Eigen::Quaternionf> rotations;
+  };
+
+  SearchSpace GenerateSearchSpace(float resolution,
+                                  const sensor::PointCloud& point_cloud) const;
   std::vector<transform::Rigid3f> GenerateExhaustiveSearchTransforms(
       float resolution, const sensor::PointCloud& point_cloud) const;
+  // Same as Match(), but the point cloud is rotated once per rotation and
+  // shared by all translations, and cells are looked up in a dense copy of
+  // the relevant part of 'hybrid_grid' if that is cheaper. Rotations are
+  // split across 'num_threads_3d' threads, all but the calling one from
+  // 'thread_pool_'.
+  float MatchBatched(const transform::Rigid3d& initial_pose_estimate,
+                     const sensor::PointCloud& point_cloud,
+                     const HybridGrid& hybrid_grid,
+                     transform::Rigid3d* pose_estimate) const;
+  float ComputeDeltaCostFactor(float translation_norm, float angle) const;
   float ScoreCandidate(const HybridGrid& hybrid_grid,
                        const sensor::PointCloud& transformed_point_cloud,
                        const transform::Rigid3f& transform) const;
 
   const proto::RealTimeCorrelativeScanMatcherOptions options_;
+  // Only set if 'batched_evaluation_3d' is true and 'num_threads_3d' is
+  // larger than 1.
+  std::unique_ptr<common::ThreadPool> thread_pool_;
 };
 
 }  // namespace scan_matching
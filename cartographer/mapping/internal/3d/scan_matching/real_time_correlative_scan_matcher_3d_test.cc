@@ -17,6 +17,7 @@
 #include "cartographer/mapping/internal/3d/scan_matching/real_time_correlative_scan_matcher_3d.h"
 
 #include <memory>
+#include <string>
 
 #include "Eigen/Core"
 #include "cartographer/common/internal/testing/lua_parameter_dictionary_test_helpers.h"
@@ -49,17 +50,27 @@ class RealTimeCorrelativeScanMatcher3DTest : public ::testing::Test {
           hybrid_grid_.GetCellIndex(expected_pose_.cast<float>() * point), 1.);
     }
 
-    auto parameter_dictionary = common::MakeDictionary(R"text(
-        return {
-          linear_search_window = 0.3,
-          angular_search_window = math.rad(1.),
-          translation_delta_cost_weight = 1e-1,
-          rotation_delta_cost_weight = 1.,
-        })text");
     real_time_correlative_scan_matcher_.reset(
-        new RealTimeCorrelativeScanMatcher3D(
-            CreateRealTimeCorrelativeScanMatcherOptions(
-                parameter_dictionary.get())));
+        new RealTimeCorrelativeScanMatcher3D(CreateOptions(false)));
+    batched_real_time_correlative_scan_matcher_.reset(
+        new RealTimeCorrelativeScanMatcher3D(CreateOptions(true)));
+  }
+
+  static proto::RealTimeCorrelativeScanMatcherOptions CreateOptions(
+      const bool batched_evaluation) {
+    auto parameter_dictionary = common::MakeDictionary(
+        "return { "
+        "linear_search_window = 0.3, "
+        "angular_search_window = math.rad(1.), "
+        "translation_delta_cost_weight = 1e-1, "
+        "rotation_delta_cost_weight = 1., "
+        "batched_evaluation_3d = " +
+        std::string(batched_evaluation ? "true" : "false") +
+        ", "
+        "num_threads_3d = 2, "
+        "}");
+    return CreateRealTimeCorrelativeScanMatcherOptions(
+        parameter_dictionary.get());
   }
 
   void TestFromInitialPose(const transform::Rigid3d& initial_pose) {
@@ -69,6 +80,13 @@ class RealTimeCorrelativeScanMatcher3DTest : public ::testing::Test {
         initial_pose, point_cloud_, hybrid_grid_, &pose);
     LOG(INFO) << "Score: " << score;
     EXPECT_THAT(pose, transform::IsNearly(expected_pose_, 1e-3));
+
+    transform::Rigid3d batched_pose;
+    const float batched_score =
+        batched_real_time_correlative_scan_matcher_->Match(
+            initial_pose, point_cloud_, hybrid_grid_, &batched_pose);
+    EXPECT_NEAR(score, batched_score, 1e-5f);
+    EXPECT_THAT(batched_pose, transform::IsNearly(expected_pose_, 1e-3));
   }
 
   HybridGrid hybrid_grid_;
@@ -76,6 +94,8 @@ class RealTimeCorrelativeScanMatcher3DTest : public ::testing::Test {
   sensor::PointCloud point_cloud_;
   std::unique_ptr<RealTimeCorrelativeScanMatcher3D>
       real_time_correlative_scan_matcher_;
+  std::unique_ptr<RealTimeCorrelativeScanMatcher3D>
+      batched_real_time_correlative_scan_matcher_;
 };
 
 TEST_F(RealTimeCorrelativeScanMatcher3DTest, PerfectEstimate) {
@@ -17,6 +17,7 @@
 #include "cartographer/mapping/internal/connected_components.h"
 
 #include <algorithm>
+#include <atomic>
 
 #include "absl/container/flat_hash_set.h"
 #include "cartographer/mapping/proto/connected_components.pb.h"
@@ -26,30 +27,56 @@ namespace cartographer {
 namespace mapping {
 
 ConnectedComponents::ConnectedComponents()
-    : lock_(), forest_(), connection_map_() {}
+    : lock_(),
+      forest_(),
+      connection_map_(),
+      snapshot_(std::make_shared<const Snapshot>(Snapshot{0, {}})) {}
 
 void ConnectedComponents::Add(const int trajectory_id) {
   absl::MutexLock locker(&lock_);
-  forest_.emplace(trajectory_id, trajectory_id);
+  if (forest_.emplace(trajectory_id, trajectory_id).second) {
+    UpdateSnapshot();
+  }
 }
 
 void ConnectedComponents::Connect(const int trajectory_id_a,
                                   const int trajectory_id_b) {
   absl::MutexLock locker(&lock_);
-  Union(trajectory_id_a, trajectory_id_b);
+  if (Union(trajectory_id_a, trajectory_id_b)) {
+    UpdateSnapshot();
+  }
   auto sorted_pair = std::minmax(trajectory_id_a, trajectory_id_b);
   ++connection_map_[sorted_pair];
 }
 
-void ConnectedComponents::Union(const int trajectory_id_a,
+bool ConnectedComponents::Union(const int trajectory_id_a,
                                 const int trajectory_id_b) {
-  forest_.emplace(trajectory_id_a, trajectory_id_a);
-  forest_.emplace(trajectory_id_b, trajectory_id_b);
+  const bool added_a = forest_.emplace(trajectory_id_a, trajectory_id_a).second;
+  const bool added_b = forest_.emplace(trajectory_id_b, trajectory_id_b).second;
   const int representative_a = FindSet(trajectory_id_a);
   const int representative_b = FindSet(trajectory_id_b);
   forest_[representative_a] = representative_b;
+  return added_a || added_b || representative_a != representative_b;
+}
+
+void ConnectedComponents::UpdateSnapshot() {
+  auto snapshot = std::make_shared<Snapshot>();
+  snapshot->version = GetSnapshot()->version + 1;
+  snapshot->component_ids.reserve(forest_.size());
+  for (const auto& entry : forest_) {
+    snapshot->component_ids.emplace(entry.first, FindSet(entry.first));
+  }
+  std::atomic_store(&snapshot_,
+                    std::shared_ptr<const Snapshot>(std::move(snapshot)));
+}
+
+std::shared_ptr<const ConnectedComponents::Snapshot>
+ConnectedComponents::GetSnapshot() const {
+  return std::atomic_load(&snapshot_);
 }
 
+int64 ConnectedComponents::version() const { return GetSnapshot()->version; }
+
 int ConnectedComponents::FindSet(const int trajectory_id) {
   auto it = forest_.find(trajectory_id);
   CHECK(it != forest_.end());
@@ -60,47 +87,51 @@ int ConnectedComponents::FindSet(const int trajectory_id) {
   return it->second;
 }
 
-bool ConnectedComponents::TransitivelyConnected(const int trajectory_id_a,
-                                                const int trajectory_id_b) {
+bool ConnectedComponents::TransitivelyConnected(
+    const int trajectory_id_a, const int trajectory_id_b) const {
   if (trajectory_id_a == trajectory_id_b) {
     return true;
   }
 
-  absl::MutexLock locker(&lock_);
-
-  if (forest_.count(trajectory_id_a) == 0 ||
-      forest_.count(trajectory_id_b) == 0) {
+  const std::shared_ptr<const Snapshot> snapshot = GetSnapshot();
+  const auto it_a = snapshot->component_ids.find(trajectory_id_a);
+  const auto it_b = snapshot->component_ids.find(trajectory_id_b);
+  if (it_a == snapshot->component_ids.end() ||
+      it_b == snapshot->component_ids.end()) {
     return false;
   }
-  return FindSet(trajectory_id_a) == FindSet(trajectory_id_b);
+  return it_a->second == it_b->second;
 }
 
-std::vector<std::vector<int>> ConnectedComponents::Components() {
+std::vector<std::vector<int>> ConnectedComponents::Components() const {
   // Map from cluster exemplar -> growing cluster.
   absl::flat_hash_map<int, std::vector<int>> map;
-  absl::MutexLock locker(&lock_);
-  for (const auto& trajectory_id_entry : forest_) {
-    map[FindSet(trajectory_id_entry.first)].push_back(
-        trajectory_id_entry.first);
+  const std::shared_ptr<const Snapshot> snapshot = GetSnapshot();
+  for (const auto& entry : snapshot->component_ids) {
+    map[entry.second].push_back(entry.first);
   }
 
   std::vector<std::vector<int>> result;
   result.reserve(map.size());
   for (auto& pair : map) {
+    std::sort(pair.second.begin(), pair.second.end());
     result.emplace_back(std::move(pair.second));
   }
   return result;
 }
 
-std::vector<int> ConnectedComponents::GetComponent(const int trajectory_id) {
-  absl::MutexLock locker(&lock_);
-  const int set_id = FindSet(trajectory_id);
+std::vector<int> ConnectedComponents::GetComponent(
+    const int trajectory_id) const {
+  const std::shared_ptr<const Snapshot> snapshot = GetSnapshot();
+  const auto it = snapshot->component_ids.find(trajectory_id);
+  CHECK(it != snapshot->component_ids.end());
   std::vector<int> trajectory_ids;
-  for (const auto& entry : forest_) {
-    if (FindSet(entry.first) == set_id) {
+  for (const auto& entry : snapshot->component_ids) {
+    if (entry.second == it->second) {
       trajectory_ids.push_back(entry.first);
     }
   }
+  std::sort(trajectory_ids.begin(), trajectory_ids.end());
   return trajectory_ids;
 }
 
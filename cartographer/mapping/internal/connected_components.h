@@ -18,9 +18,12 @@
 #define CARTOGRAPHER_MAPPING_INTERNAL_CONNECTED_COMPONENTS_H_
 
 #include <map>
+#include <memory>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/synchronization/mutex.h"
+#include "cartographer/common/port.h"
 #include "cartographer/mapping/proto/connected_components.pb.h"
 #include "cartographer/mapping/submaps.h"
 
@@ -32,7 +35,9 @@ namespace mapping {
 // Connectivity includes both the count ("How many times have I _directly_
 // connected trajectories i and j?") and the transitive connectivity.
 //
-// This class is thread-safe.
+// This class is thread-safe. Queries about transitive connectivity read an
+// immutable snapshot which is only replaced when 'Add' or 'Connect' change it,
+// so they do not take the lock.
 class ConnectedComponents {
  public:
   ConnectedComponents();
@@ -52,8 +57,7 @@ class ConnectedComponents {
   // either trajectory is not being tracked, returns false, except when it is
   // the same trajectory, where it returns true. This function is invariant to
   // the order of its arguments.
-  bool TransitivelyConnected(int trajectory_id_a, int trajectory_id_b)
-      LOCKS_EXCLUDED(lock_);
+  bool TransitivelyConnected(int trajectory_id_a, int trajectory_id_b) const;
 
   // Return the number of _direct_ connections between 'trajectory_id_a' and
   // 'trajectory_id_b'. If either trajectory is not being tracked, returns 0.
@@ -62,16 +66,30 @@ class ConnectedComponents {
       LOCKS_EXCLUDED(lock_);
 
   // The trajectory IDs, grouped by connectivity.
-  std::vector<std::vector<int>> Components() LOCKS_EXCLUDED(lock_);
+  std::vector<std::vector<int>> Components() const;
 
   // The list of trajectory IDs that belong to the same connected component as
   // 'trajectory_id'.
-  std::vector<int> GetComponent(int trajectory_id) LOCKS_EXCLUDED(lock_);
+  std::vector<int> GetComponent(int trajectory_id) const;
+
+  // Returns a number which is incremented whenever the transitive connectivity
+  // changes, i.e. a trajectory is added or two components are joined.
+  int64 version() const;
 
  private:
+  struct Snapshot {
+    int64 version;
+    // Maps each tracked trajectory ID to an ID identifying its component.
+    absl::flat_hash_map<int, int> component_ids;
+  };
+
+  std::shared_ptr<const Snapshot> GetSnapshot() const;
+  void UpdateSnapshot() EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   // Find the representative and compresses the path to it.
   int FindSet(int trajectory_id) EXCLUSIVE_LOCKS_REQUIRED(lock_);
-  void Union(int trajectory_id_a, int trajectory_id_b)
+  // Returns true if the connectivity changed.
+  bool Union(int trajectory_id_a, int trajectory_id_b)
       EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
   absl::Mutex lock_;
@@ -80,6 +98,9 @@ class ConnectedComponents {
   std::map<int, int> forest_ GUARDED_BY(lock_);
   // Tracks the number of direct connections between a pair of trajectories.
   std::map<std::pair<int, int>, int> connection_map_ GUARDED_BY(lock_);
+  // Only written while holding 'lock_'. Accessed using 'std::atomic_load' and
+  // 'std::atomic_store' so that readers do not need the lock.
+  std::shared_ptr<const Snapshot> snapshot_;
 };
 
 // Returns a proto encoding connected components.
@@ -112,6 +112,24 @@ TEST(ConnectedComponentsTest, ReflexiveConnectivity) {
   EXPECT_EQ(0, connected_components.ConnectionCount(0, 0));
 }
 
+TEST(ConnectedComponentsTest, VersionChangesOnlyWithConnectivity) {
+  ConnectedComponents connected_components;
+  const int64 initial_version = connected_components.version();
+  connected_components.Add(0);
+  connected_components.Add(1);
+  const int64 added_version = connected_components.version();
+  EXPECT_GT(added_version, initial_version);
+  connected_components.Add(1);
+  EXPECT_EQ(added_version, connected_components.version());
+  connected_components.Connect(0, 1);
+  const int64 connected_version = connected_components.version();
+  EXPECT_GT(connected_version, added_version);
+  connected_components.Connect(1, 0);
+  EXPECT_EQ(connected_version, connected_components.version());
+  EXPECT_EQ(2, connected_components.ConnectionCount(0, 1));
+  EXPECT_EQ(std::vector<int>({0, 1}), connected_components.GetComponent(1));
+}
+
 }  // namespace
 }  // namespace mapping
 }  // namespace cartographer
@@ -16,6 +16,7 @@
 
 #include "cartographer/mapping/internal/constraints/constraint_builder_2d.h"
 
+#include <chrono>
 #include <cmath>
 #include <functional>
 #include <iomanip>
@@ -31,6 +32,7 @@
 #include "absl/memory/memory.h"
 #include "cartographer/common/math.h"
 #include "cartographer/common/thread_pool.h"
+#include "cartographer/mapping/internal/2d/scan_matching/scan_descriptor_2d.h"
 #include "cartographer/mapping/proto/scan_matching/ceres_scan_matcher_options_2d.pb.h"
 #include "cartographer/mapping/proto/scan_matching/fast_correlative_scan_matcher_options_2d.pb.h"
 #include "cartographer/metrics/counter.h"
@@ -47,11 +49,25 @@ static auto* kConstraintsSearchedMetric = metrics::Counter::Null();
 static auto* kConstraintsFoundMetric = metrics::Counter::Null();
 static auto* kGlobalConstraintsSearchedMetric = metrics::Counter::Null();
 static auto* kGlobalConstraintsFoundMetric = metrics::Counter::Null();
+static auto* kConstraintsRejectedMetric = metrics::Counter::Null();
+static auto* kGlobalConstraintsRejectedMetric = metrics::Counter::Null();
+static auto* kScanDescriptorSecondsMetric = metrics::Counter::Null();
+static auto* kScanMatchSecondsMetric = metrics::Counter::Null();
 static auto* kQueueLengthMetric = metrics::Gauge::Null();
 static auto* kConstraintScoresMetric = metrics::Histogram::Null();
 static auto* kGlobalConstraintScoresMetric = metrics::Histogram::Null();
 static auto* kNumSubmapScanMatchersMetric = metrics::Gauge::Null();
 
+namespace {
+
+double SecondsSince(const std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::duration<double>>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+}  // namespace
+
 transform::Rigid2d ComputeSubmapPose(const Submap2D& submap) {
   return transform::Project2D(submap.local_pose());
 }
@@ -94,6 +110,10 @@ void ConstraintBuilder2D::MaybeAddConstraint(
     LOG(WARNING)
         << "MaybeAddConstraint was called while WhenDone was scheduled.";
   }
+  if (!MatchesScanDescriptors(submap, node_id, constant_data)) {
+    kConstraintsRejectedMetric->Increment();
+    return;
+  }
   constraints_.emplace_back();
   kQueueLengthMetric->Set(constraints_.size());
   auto* const constraint = &constraints_.back();
@@ -119,6 +139,10 @@ void ConstraintBuilder2D::MaybeAddGlobalConstraint(
     LOG(WARNING)
         << "MaybeAddGlobalConstraint was called while WhenDone was scheduled.";
   }
+  if (!MatchesScanDescriptors(submap, node_id, constant_data)) {
+    kGlobalConstraintsRejectedMetric->Increment();
+    return;
+  }
   constraints_.emplace_back();
   kQueueLengthMetric->Set(constraints_.size());
   auto* const constraint = &constraints_.back();
@@ -185,6 +209,29 @@ ConstraintBuilder2D::DispatchScanMatcherConstruction(const SubmapId& submap_id,
   return &submap_scan_matchers_.at(submap_id);
 }
 
+bool ConstraintBuilder2D::MatchesScanDescriptors(
+    const Submap2D* const submap, const NodeId& node_id,
+    const TrajectoryNode::Data* const constant_data) {
+  if (options_.min_scan_descriptor_similarity_2d() <= 0.) {
+    return true;
+  }
+  const auto start = std::chrono::steady_clock::now();
+  // Candidates are added node by node, so this computes the descriptor of
+  // most nodes only once.
+  if (node_id != last_descriptor_node_id_) {
+    last_descriptor_node_id_ = node_id;
+    last_node_descriptor_ = scan_matching::ScanDescriptor2D::Compute(
+        constant_data->filtered_gravity_aligned_point_cloud);
+  }
+  // The pose graph only searches for constraints in finished submaps.
+  const Eigen::VectorXf submap_descriptor = submap->scan_descriptor();
+  CHECK_NE(submap_descriptor.size(), 0);
+  const float similarity = scan_matching::ScanDescriptor2D::Similarity(
+      last_node_descriptor_, submap_descriptor);
+  kScanDescriptorSecondsMetric->Increment(SecondsSince(start));
+  return similarity >= options_.min_scan_descriptor_similarity_2d();
+}
+
 void ConstraintBuilder2D::ComputeConstraint(
     const SubmapId& submap_id, const Submap2D* const submap,
     const NodeId& node_id, bool match_full_submap,
@@ -208,32 +255,38 @@ void ConstraintBuilder2D::ComputeConstraint(
   // 1. Fast estimate using the fast correlative scan matcher.
   // 2. Prune if the score is too low.
   // 3. Refine.
+  const auto start = std::chrono::steady_clock::now();
+  bool match_found;
   if (match_full_submap) {
     kGlobalConstraintsSearchedMetric->Increment();
-    if (submap_scan_matcher.fast_correlative_scan_matcher->MatchFullSubmap(
+    match_found =
+        submap_scan_matcher.fast_correlative_scan_matcher->MatchFullSubmap(
             constant_data->filtered_gravity_aligned_point_cloud,
-            options_.global_localization_min_score(), &score, &pose_estimate)) {
+            options_.global_localization_min_score(), &score, &pose_estimate);
+    if (match_found) {
       CHECK_GT(score, options_.global_localization_min_score());
       CHECK_GE(node_id.trajectory_id, 0);
       CHECK_GE(submap_id.trajectory_id, 0);
       kGlobalConstraintsFoundMetric->Increment();
       kGlobalConstraintScoresMetric->Observe(score);
-    } else {
-      return;
     }
   } else {
     kConstraintsSearchedMetric->Increment();
-    if (submap_scan_matcher.fast_correlative_scan_matcher->Match(
-            initial_pose, constant_data->filtered_gravity_aligned_point_cloud,
-            options_.min_score(), &score, &pose_estimate)) {
+    match_found = submap_scan_matcher.fast_correlative_scan_matcher->Match(
+        initial_pose, constant_data->filtered_gravity_aligned_point_cloud,
+        options_.min_score(), &score, &pose_estimate);
+    if (match_found) {
       // We've reported a successful local match.
       CHECK_GT(score, options_.min_score());
       kConstraintsFoundMetric->Increment();
       kConstraintScoresMetric->Observe(score);
-    } else {
-      return;
     }
   }
+  // Failed searches are usually the expensive ones, so they are timed too.
+  kScanMatchSecondsMetric->Increment(SecondsSince(start));
+  if (!match_found) {
+    return;
+  }
   {
     absl::MutexLock locker(&mutex_);
     score_histogram_.Add(score);
@@ -327,6 +380,15 @@ void ConstraintBuilder2D::RegisterMetrics(metrics::FamilyFactory* factory) {
       counts->Add({{"search_region", "global"}, {"matcher", "searched"}});
   kGlobalConstraintsFoundMetric =
       counts->Add({{"search_region", "global"}, {"matcher", "found"}});
+  kConstraintsRejectedMetric = counts->Add(
+      {{"search_region", "local"}, {"matcher", "rejected_by_descriptor"}});
+  kGlobalConstraintsRejectedMetric = counts->Add(
+      {{"search_region", "global"}, {"matcher", "rejected_by_descriptor"}});
+  auto* seconds = factory->NewCounterFamily(
+      "mapping_constraints_constraint_builder_2d_compute_seconds",
+      "Time spent on constraint candidates");
+  kScanDescriptorSecondsMetric = seconds->Add({{"stage", "scan_descriptor"}});
+  kScanMatchSecondsMetric = seconds->Add({{"stage", "scan_match"}});
   auto* queue_length = factory->NewGaugeFamily(
       "mapping_constraints_constraint_builder_2d_queue_length", "Queue length");
   kQueueLengthMetric = queue_length->Add({});
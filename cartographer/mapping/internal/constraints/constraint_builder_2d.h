@@ -120,6 +120,12 @@ class ConstraintBuilder2D {
       const SubmapId& submap_id, const Grid2D* grid)
       EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
+  // Returns false if the scan descriptors of the node and the submap are too
+  // dissimilar for a match, see 'min_scan_descriptor_similarity_2d'.
+  bool MatchesScanDescriptors(const Submap2D* submap, const NodeId& node_id,
+                              const TrajectoryNode::Data* constant_data)
+      EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
   // Runs in a background thread and does computations for an additional
   // constraint, assuming 'submap' and 'compressed_point_cloud' do not change
   // anymore. As output, it may create a new Constraint in 'constraint'.
@@ -163,6 +169,11 @@ class ConstraintBuilder2D {
       GUARDED_BY(mutex_);
   std::map<SubmapId, common::FixedRatioSampler> per_submap_sampler_;
 
+  // Scan descriptor of the node last considered. Only used if
+  // 'min_scan_descriptor_similarity_2d' is positive.
+  NodeId last_descriptor_node_id_ GUARDED_BY(mutex_){-1, -1};
+  Eigen::VectorXf last_node_descriptor_ GUARDED_BY(mutex_);
+
   scan_matching::CeresScanMatcher2D ceres_scan_matcher_;
 
   // Histogram of scan matcher scores.
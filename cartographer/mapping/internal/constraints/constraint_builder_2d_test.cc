@@ -16,6 +16,7 @@
 
 #include "cartographer/mapping/internal/constraints/constraint_builder_2d.h"
 
+#include <cmath>
 #include <functional>
 
 #include "cartographer/common/internal/testing/thread_pool_for_testing.h"
@@ -111,6 +112,93 @@ TEST_F(ConstraintBuilder2DTest, FindsConstraints) {
   }
 }
 
+// Returns node data with returns on a circle of 'radius' around the origin.
+TrajectoryNode::Data CreateCircularRoomNodeData(const float radius) {
+  TrajectoryNode::Data node_data;
+  for (float angle = 0.f; angle < 2.f * M_PI; angle += 0.05f) {
+    node_data.filtered_gravity_aligned_point_cloud.push_back(
+        {Eigen::Vector3f(radius * std::cos(angle), radius * std::sin(angle),
+                         0.f)});
+  }
+  node_data.gravity_alignment = Eigen::Quaterniond::Identity();
+  node_data.local_pose = transform::Rigid3d::Identity();
+  return node_data;
+}
+
+// Returns a finished submap whose grid has occupied cells on a circle of
+// 'radius' around the origin.
+std::unique_ptr<Submap2D> CreateCircularRoomSubmap(
+    const float radius, ValueConversionTables* conversion_tables) {
+  auto grid = absl::make_unique<ProbabilityGrid>(
+      MapLimits(0.05, Eigen::Vector2d(10., 10.), CellLimits(400, 400)),
+      conversion_tables);
+  for (float angle = 0.f; angle < 2.f * M_PI; angle += 0.005f) {
+    const Eigen::Array2i cell_index = grid->limits().GetCellIndex(
+        Eigen::Vector2f(radius * std::cos(angle), radius * std::sin(angle)));
+    if (!grid->IsKnown(cell_index)) {
+      grid->SetProbability(cell_index, kMaxProbability);
+    }
+  }
+  auto submap = absl::make_unique<Submap2D>(
+      Eigen::Vector2f::Zero(), std::move(grid), conversion_tables);
+  submap->Finish();
+  return submap;
+}
+
+class ConstraintBuilder2DPrefilterTest : public ConstraintBuilder2DTest {
+ protected:
+  void SetUp() override {
+    auto constraint_builder_parameters = testing::ResolveLuaParameters(R"text(
+          include "pose_graph.lua"
+          POSE_GRAPH.constraint_builder.sampling_ratio = 1
+          POSE_GRAPH.constraint_builder.min_score = 0
+          POSE_GRAPH.constraint_builder.global_localization_min_score = 0
+          POSE_GRAPH.constraint_builder.min_scan_descriptor_similarity_2d = 0.5
+          return POSE_GRAPH.constraint_builder)text");
+    constraint_builder_ = absl::make_unique<ConstraintBuilder2D>(
+        CreateConstraintBuilderOptions(constraint_builder_parameters.get()),
+        &thread_pool_);
+  }
+
+  // Adds a local and a global constraint search between 'submap' and
+  // 'node_data', and expects 'num_expected_constraints' to be found.
+  void ExpectConstraintsFound(const Submap2D& submap,
+                              const TrajectoryNode::Data& node_data,
+                              const int num_expected_constraints) {
+    const SubmapId submap_id{0, 0};
+    constraint_builder_->MaybeAddConstraint(submap_id, &submap, NodeId{0, 0},
+                                            &node_data,
+                                            transform::Rigid2d::Identity());
+    constraint_builder_->MaybeAddGlobalConstraint(submap_id, &submap,
+                                                  NodeId{0, 0}, &node_data);
+    constraint_builder_->NotifyEndOfNode();
+    EXPECT_CALL(mock_, Run(::testing::SizeIs(num_expected_constraints)));
+    constraint_builder_->WhenDone(
+        [this](const constraints::ConstraintBuilder2D::Result& result) {
+          mock_.Run(result);
+        });
+    thread_pool_.WaitUntilIdle();
+    EXPECT_EQ(constraint_builder_->GetNumFinishedNodes(), 1);
+  }
+};
+
+TEST_F(ConstraintBuilder2DPrefilterTest, RejectsDissimilarScanDescriptors) {
+  // The node is in a small circular room, the submap shows a large one.
+  ValueConversionTables conversion_tables;
+  const std::unique_ptr<Submap2D> submap =
+      CreateCircularRoomSubmap(6.25f, &conversion_tables);
+  ExpectConstraintsFound(*submap, CreateCircularRoomNodeData(1.25f), 0);
+}
+
+TEST_F(ConstraintBuilder2DPrefilterTest, AcceptsSimilarScanDescriptors) {
+  // The node and the submap show the same room, so the prefilter lets both
+  // searches through and they find constraints.
+  ValueConversionTables conversion_tables;
+  const std::unique_ptr<Submap2D> submap =
+      CreateCircularRoomSubmap(1.25f, &conversion_tables);
+  ExpectConstraintsFound(*submap, CreateCircularRoomNodeData(1.25f), 2);
+}
+
 }  // namespace
 }  // namespace constraints
 }  // namespace mapping
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cartographer/mapping/internal/constraints/place_recognition_index.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "cartographer/mapping/internal/2d/scan_matching/scan_descriptor_2d.h"
+#include "glog/logging.h"
+
+namespace cartographer {
+namespace mapping {
+namespace constraints {
+
+void PlaceRecognitionIndex::Insert(const SubmapId& submap_id,
+                                   const Eigen::VectorXf& descriptor) {
+  descriptors_[submap_id] = descriptor;
+}
+
+void PlaceRecognitionIndex::Erase(const SubmapId& submap_id) {
+  descriptors_.erase(submap_id);
+}
+
+std::vector<SubmapId> PlaceRecognitionIndex::Query(
+    const Eigen::VectorXf& descriptor, const int num_results,
+    const std::function<bool(const SubmapId&)>& filter) const {
+  CHECK_GE(num_results, 0);
+  std::vector<std::pair<float, SubmapId>> candidates;
+  for (const auto& entry : descriptors_) {
+    if (filter(entry.first)) {
+      candidates.emplace_back(
+          scan_matching::ScanDescriptor2D::Similarity(descriptor, entry.second),
+          entry.first);
+    }
+  }
+  const size_t num_candidates =
+      std::min(candidates.size(), static_cast<size_t>(num_results));
+  // Ties are broken by submap ID to make the result deterministic.
+  std::partial_sort(
+      candidates.begin(), candidates.begin() + num_candidates, candidates.end(),
+      [](const std::pair<float, SubmapId>& lhs,
+         const std::pair<float, SubmapId>& rhs) {
+        return lhs.first > rhs.first ||
+               (lhs.first == rhs.first && lhs.second < rhs.second);
+      });
+  std::vector<SubmapId> result;
+  result.reserve(num_candidates);
+  for (size_t i = 0; i != num_candidates; ++i) {
+    result.push_back(candidates[i].second);
+  }
+  return result;
+}
+
+}  // namespace constraints
+}  // namespace mapping
+}  // namespace cartographer
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CARTOGRAPHER_MAPPING_INTERNAL_CONSTRAINTS_PLACE_RECOGNITION_INDEX_H_
+#define CARTOGRAPHER_MAPPING_INTERNAL_CONSTRAINTS_PLACE_RECOGNITION_INDEX_H_
+
+#include <functional>
+#include <map>
+#include <vector>
+
+#include "Eigen/Core"
+#include "cartographer/mapping/id.h"
+
+namespace cartographer {
+namespace mapping {
+namespace constraints {
+
+// Finds the submaps which most likely show the same place as a node by
+// comparing their scan descriptors, see 'ScanDescriptor2D'. Descriptors are
+// added as submaps finish, so the index is built incrementally. Since the
+// descriptors are compact, queries are answered exactly by comparing against
+// all of them.
+class PlaceRecognitionIndex {
+ public:
+  PlaceRecognitionIndex() = default;
+
+  PlaceRecognitionIndex(const PlaceRecognitionIndex&) = delete;
+  PlaceRecognitionIndex& operator=(const PlaceRecognitionIndex&) = delete;
+
+  // Adds or replaces the 'descriptor' of 'submap_id'.
+  void Insert(const SubmapId& submap_id, const Eigen::VectorXf& descriptor);
+  void Erase(const SubmapId& submap_id);
+
+  // Returns up to 'num_results' of the submaps accepted by 'filter', most
+  // similar to 'descriptor' first.
+  std::vector<SubmapId> Query(
+      const Eigen::VectorXf& descriptor, int num_results,
+      const std::function<bool(const SubmapId&)>& filter) const;
+
+  size_t size() const { return descriptors_.size(); }
+
+ private:
+  std::map<SubmapId, Eigen::VectorXf> descriptors_;
+};
+
+}  // namespace constraints
+}  // namespace mapping
+}  // namespace cartographer
+
+#endif  // CARTOGRAPHER_MAPPING_INTERNAL_CONSTRAINTS_PLACE_RECOGNITION_INDEX_H_
@@ -0,0 +1,60 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cartographer/mapping/internal/constraints/place_recognition_index.h"
+
+#include "gtest/gtest.h"
+
+namespace cartographer {
+namespace mapping {
+namespace constraints {
+namespace {
+
+// A normalized histogram with all its mass in 'bucket'.
+Eigen::VectorXf CreateDescriptor(const int bucket) {
+  Eigen::VectorXf descriptor = Eigen::VectorXf::Zero(4);
+  descriptor[bucket] = 1.f;
+  return descriptor;
+}
+
+TEST(PlaceRecognitionIndexTest, ReturnsMostSimilarSubmaps) {
+  PlaceRecognitionIndex index;
+  index.Insert({0, 0}, CreateDescriptor(0));
+  index.Insert({0, 1}, CreateDescriptor(1));
+  index.Insert({1, 0}, 0.5f * (CreateDescriptor(1) + CreateDescriptor(2)));
+  index.Insert({1, 1}, CreateDescriptor(3));
+  ASSERT_EQ(4, index.size());
+
+  const auto accept_all = [](const SubmapId&) { return true; };
+  EXPECT_EQ(std::vector<SubmapId>({{0, 1}, {1, 0}}),
+            index.Query(CreateDescriptor(1), 2, accept_all));
+  EXPECT_EQ(4, index.Query(CreateDescriptor(1), 10, accept_all).size());
+  EXPECT_TRUE(index.Query(CreateDescriptor(1), 0, accept_all).empty());
+  EXPECT_EQ(std::vector<SubmapId>({{1, 0}}),
+            index.Query(CreateDescriptor(1), 1, [](const SubmapId& submap_id) {
+              return submap_id.trajectory_id == 1;
+            }));
+
+  index.Erase({0, 1});
+  EXPECT_EQ(3, index.size());
+  EXPECT_EQ(std::vector<SubmapId>({{1, 0}}),
+            index.Query(CreateDescriptor(1), 1, accept_all));
+}
+
+}  // namespace
+}  // namespace constraints
+}  // namespace mapping
+}  // namespace cartographer
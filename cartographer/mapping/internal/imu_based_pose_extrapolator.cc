@@ -92,6 +92,8 @@ void ImuBasedPoseExtrapolator::AddPose(const common::Time time,
       CHECK_EQ(timed_pose_queue_.front().time, previous_solution_.front().time);
       previous_solution_.pop_front();
     }
+    if (!imu_delta_rotations_.empty()) imu_delta_rotations_.pop_front();
+    if (!imu_delta_velocities_.empty()) imu_delta_velocities_.pop_front();
     timed_pose_queue_.pop_front();
   }
   TrimImuData();
@@ -180,11 +182,7 @@ ImuBasedPoseExtrapolator::ExtrapolatePosesWithGravity(
     gravity_constant = options_.gravity_constant();
   }
 
-  auto imu_it_prev_prev = imu_data_.begin();
-  while (imu_it_prev_prev != std::prev(imu_data_.end()) &&
-         std::next(imu_it_prev_prev)->time <= timed_pose_queue_.back().time) {
-    ++imu_it_prev_prev;
-  }
+  auto imu_it_prev_prev = FindImuData(timed_pose_queue_.back().time);
 
   const TimestampedTransform prev_gravity_from_tracking =
       TimestampedTransform{node_times.back(), nodes.back().ToRigid()};
@@ -226,39 +224,38 @@ ImuBasedPoseExtrapolator::ExtrapolatePosesWithGravity(
                             new ceres::QuaternionParameterization());
   problem.SetParameterBlockConstant(imu_calibration.data());
 
-  auto imu_it = imu_data_.begin();
   CHECK(imu_data_.size() == 1 ||
-        std::next(imu_it)->time > timed_pose_queue_.front().time);
+        std::next(imu_data_.begin())->time > timed_pose_queue_.front().time);
+  UpdateImuIntegrationBetweenPoses();
 
   transform::Rigid3d last_node_odometry;
   common::Time last_node_odometry_time;
 
+  // Only the IMU data after the last queued pose is integrated here, the rest
+  // is cached.
+  const size_t last_pose_index = timed_pose_queue_.size() - 1;
+  auto last_pose_imu_it = FindImuData(node_times[last_pose_index]);
+  const Eigen::Quaterniond extrapolated_delta_rotation =
+      IntegrateImu(imu_data_, node_times[last_pose_index], time,
+                   &last_pose_imu_it)
+          .delta_rotation;
+
   for (size_t i = 1; i < nodes.size(); i++) {
     const common::Time first_time = node_times[i - 1];
     const common::Time second_time = node_times[i];
 
-    auto imu_it2 = imu_it;
-    const IntegrateImuResult<double> result =
-        IntegrateImu(imu_data_, first_time, second_time, &imu_it);
+    const Eigen::Quaterniond& delta_rotation =
+        i <= last_pose_index ? imu_delta_rotations_.at(i - 1)
+                             : extrapolated_delta_rotation;
     if ((i + 1) < nodes.size()) {
       const common::Time third_time = node_times[i + 1];
       const common::Duration first_duration = second_time - first_time;
       const common::Duration second_duration = third_time - second_time;
-      const common::Time first_center = first_time + first_duration / 2;
-      const common::Time second_center = second_time + second_duration / 2;
-      const IntegrateImuResult<double> result_to_first_center =
-          IntegrateImu(imu_data_, first_time, first_center, &imu_it2);
-      const IntegrateImuResult<double> result_center_to_center =
-          IntegrateImu(imu_data_, first_center, second_center, &imu_it2);
-      // 'delta_velocity' is the change in velocity from the point in time
-      // halfway between the first and second poses to halfway between
-      // second and third pose. It is computed from IMU data and still
-      // contains a delta due to gravity. The orientation of this vector is
-      // in the IMU frame at the second pose.
       const Eigen::Vector3d delta_velocity =
-          (result.delta_rotation.inverse() *
-           result_to_first_center.delta_rotation) *
-          result_center_to_center.delta_velocity;
+          (i + 1) <= last_pose_index
+              ? imu_delta_velocities_.at(i - 1)
+              : IntegrateImuDeltaVelocity(delta_rotation, first_time,
+                                          second_time, third_time);
       problem.AddResidualBlock(
           AccelerationCostFunction3D::CreateAutoDiffCostFunction(
               options_.imu_acceleration_weight(), delta_velocity,
@@ -278,7 +275,7 @@ ImuBasedPoseExtrapolator::ExtrapolatePosesWithGravity(
     }
     problem.AddResidualBlock(
         RotationCostFunction3D::CreateAutoDiffCostFunction(
-            options_.imu_rotation_weight(), result.delta_rotation),
+            options_.imu_rotation_weight(), delta_rotation),
         nullptr /* loss function */, nodes.at(i - 1).rotation(),
         nodes.at(i).rotation(), imu_calibration.data());
 
@@ -394,6 +391,50 @@ void ImuBasedPoseExtrapolator::TrimDequeData(std::deque<T>* data) {
   }
 }
 
+std::deque<sensor::ImuData>::const_iterator
+ImuBasedPoseExtrapolator::FindImuData(const common::Time& time) const {
+  CHECK(!imu_data_.empty());
+  const auto it = std::upper_bound(
+      imu_data_.begin(), imu_data_.end(), time,
+      [](const common::Time& time, const sensor::ImuData& imu_data) {
+        return time < imu_data.time;
+      });
+  return it == imu_data_.begin() ? it : std::prev(it);
+}
+
+Eigen::Vector3d ImuBasedPoseExtrapolator::IntegrateImuDeltaVelocity(
+    const Eigen::Quaterniond& delta_rotation, const common::Time& first_time,
+    const common::Time& second_time, const common::Time& third_time) const {
+  const common::Time first_center = first_time + (second_time - first_time) / 2;
+  const common::Time second_center =
+      second_time + (third_time - second_time) / 2;
+  auto imu_it = FindImuData(first_time);
+  const IntegrateImuResult<double> result_to_first_center =
+      IntegrateImu(imu_data_, first_time, first_center, &imu_it);
+  const IntegrateImuResult<double> result_center_to_center =
+      IntegrateImu(imu_data_, first_center, second_center, &imu_it);
+  // The result still contains a delta due to gravity.
+  return (delta_rotation.inverse() * result_to_first_center.delta_rotation) *
+         result_center_to_center.delta_velocity;
+}
+
+void ImuBasedPoseExtrapolator::UpdateImuIntegrationBetweenPoses() {
+  while (imu_delta_rotations_.size() + 1 < timed_pose_queue_.size()) {
+    const size_t i = imu_delta_rotations_.size();
+    auto imu_it = FindImuData(timed_pose_queue_[i].time);
+    imu_delta_rotations_.push_back(
+        IntegrateImu(imu_data_, timed_pose_queue_[i].time,
+                     timed_pose_queue_[i + 1].time, &imu_it)
+            .delta_rotation);
+  }
+  while (imu_delta_velocities_.size() + 2 < timed_pose_queue_.size()) {
+    const size_t i = imu_delta_velocities_.size();
+    imu_delta_velocities_.push_back(IntegrateImuDeltaVelocity(
+        imu_delta_rotations_.at(i), timed_pose_queue_[i].time,
+        timed_pose_queue_[i + 1].time, timed_pose_queue_[i + 2].time));
+  }
+}
+
 void ImuBasedPoseExtrapolator::TrimImuData() {
   TrimDequeData<sensor::ImuData>(&imu_data_);
 }
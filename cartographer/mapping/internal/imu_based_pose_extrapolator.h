@@ -59,6 +59,18 @@ class ImuBasedPoseExtrapolator : public PoseExtrapolatorInterface {
   // Gravity alignment estimate.
   Eigen::Quaterniond EstimateGravityOrientation(common::Time time) override;
 
+  // Returns the cached IMU integration between the queued poses, see
+  // 'imu_delta_rotations_' and 'imu_delta_velocities_'. Only updated when
+  // extrapolating.
+  //
+  // Visible for testing.
+  const std::deque<Eigen::Quaterniond>& imu_delta_rotations() const {
+    return imu_delta_rotations_;
+  }
+  const std::deque<Eigen::Vector3d>& imu_delta_velocities() const {
+    return imu_delta_velocities_;
+  }
+
  private:
   template <typename T>
   void TrimDequeData(std::deque<T>* data);
@@ -66,6 +78,23 @@ class ImuBasedPoseExtrapolator : public PoseExtrapolatorInterface {
   void TrimImuData();
   void TrimOdometryData();
 
+  // IMU methods.
+  // Returns the last IMU data not after 'time', or the first one if there is
+  // none.
+  std::deque<sensor::ImuData>::const_iterator FindImuData(
+      const common::Time& time) const;
+  // Returns the change in velocity from halfway between 'first_time' and
+  // 'second_time' to halfway between 'second_time' and 'third_time' computed
+  // from IMU data, in the IMU frame at 'second_time'. 'delta_rotation' is the
+  // rotation from 'first_time' to 'second_time'.
+  Eigen::Vector3d IntegrateImuDeltaVelocity(
+      const Eigen::Quaterniond& delta_rotation, const common::Time& first_time,
+      const common::Time& second_time, const common::Time& third_time) const;
+  // Integrates the IMU data between queued poses which was not integrated
+  // yet. These results only depend on the queued poses, so each interval is
+  // integrated once instead of on every extrapolation.
+  void UpdateImuIntegrationBetweenPoses();
+
   // Odometry methods.
   bool HasOdometryData() const;
   bool HasOdometryDataForTime(const common::Time& first_time) const;
@@ -84,6 +113,13 @@ class ImuBasedPoseExtrapolator : public PoseExtrapolatorInterface {
   std::deque<::cartographer::transform::TimestampedTransform>
       previous_solution_;
 
+  // Rotation measured by the IMU from each queued pose to the next one.
+  std::deque<Eigen::Quaterniond> imu_delta_rotations_;
+  // Change in velocity measured by the IMU around each queued pose except the
+  // first and last one, see 'IntegrateImuDeltaVelocity'. Entry 'i' belongs to
+  // the pose at index 'i + 1'.
+  std::deque<Eigen::Vector3d> imu_delta_velocities_;
+
   std::deque<sensor::ImuData> imu_data_;
   std::deque<sensor::OdometryData> odometry_data_;
   common::Time last_extrapolated_time_ = common::Time::min();
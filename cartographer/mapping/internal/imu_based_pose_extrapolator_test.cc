@@ -0,0 +1,164 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cartographer/mapping/internal/imu_based_pose_extrapolator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "cartographer/mapping/internal/3d/imu_integration.h"
+#include "gtest/gtest.h"
+
+namespace cartographer {
+namespace mapping {
+namespace {
+
+constexpr double kPoseQueueDuration = 0.5;
+constexpr double kImuPeriod = 0.01;
+constexpr int kImuSamplesPerPose = 10;
+
+proto::ImuBasedPoseExtrapolatorOptions CreateOptions() {
+  proto::ImuBasedPoseExtrapolatorOptions options;
+  options.set_pose_queue_duration(kPoseQueueDuration);
+  options.set_gravity_constant(9.806);
+  options.set_pose_translation_weight(1.);
+  options.set_pose_rotation_weight(1.);
+  options.set_imu_acceleration_weight(1.);
+  options.set_imu_rotation_weight(1.);
+  options.set_odometry_translation_weight(1.);
+  options.set_odometry_rotation_weight(1.);
+  options.mutable_solver_options()->set_use_nonmonotonic_steps(false);
+  options.mutable_solver_options()->set_max_num_iterations(10);
+  options.mutable_solver_options()->set_num_threads(1);
+  return options;
+}
+
+// Times are multiples of the IMU period, so that pose times compare exactly.
+common::Time ImuSampleTime(const int imu_index) {
+  return common::FromUniversal(1000000000) +
+         imu_index * common::FromSeconds(kImuPeriod);
+}
+
+// IMU data of a tracking frame which turns and accelerates non-uniformly.
+sensor::ImuData CreateImuData(const int imu_index) {
+  const double seconds = kImuPeriod * imu_index;
+  return sensor::ImuData{
+      ImuSampleTime(imu_index),
+      Eigen::Vector3d(0.3 * std::sin(seconds), 0.2 * std::cos(2. * seconds),
+                      9.806 + 0.1 * seconds),
+      Eigen::Vector3d(0.05 * seconds, -0.1, 0.2 + 0.3 * std::sin(seconds))};
+}
+
+transform::Rigid3d CreatePose(const int imu_index) {
+  const double seconds = kImuPeriod * imu_index;
+  return transform::Rigid3d(
+      Eigen::Vector3d(0.5 * seconds, 0.1 * seconds * seconds, 0.),
+      transform::RollPitchYaw(0., 0., 0.2 * seconds));
+}
+
+// Returns the last element of 'imu_data' not after 'time'.
+std::vector<sensor::ImuData>::const_iterator FindImuData(
+    const std::vector<sensor::ImuData>& imu_data, const common::Time time) {
+  const auto it = std::upper_bound(
+      imu_data.begin(), imu_data.end(), time,
+      [](const common::Time time, const sensor::ImuData& imu_data) {
+        return time < imu_data.time;
+      });
+  CHECK(it != imu_data.begin());
+  return std::prev(it);
+}
+
+Eigen::Quaterniond IntegrateDeltaRotation(
+    const std::vector<sensor::ImuData>& imu_data, const common::Time start,
+    const common::Time end) {
+  auto it = FindImuData(imu_data, start);
+  return IntegrateImu(imu_data, start, end, &it).delta_rotation;
+}
+
+// Same as ImuBasedPoseExtrapolator::IntegrateImuDeltaVelocity().
+Eigen::Vector3d IntegrateDeltaVelocity(
+    const std::vector<sensor::ImuData>& imu_data, const common::Time first,
+    const common::Time second, const common::Time third) {
+  const common::Time first_center = first + (second - first) / 2;
+  const common::Time second_center = second + (third - second) / 2;
+  auto it = FindImuData(imu_data, first);
+  const IntegrateImuResult<double> result_to_first_center =
+      IntegrateImu(imu_data, first, first_center, &it);
+  const IntegrateImuResult<double> result_center_to_center =
+      IntegrateImu(imu_data, first_center, second_center, &it);
+  return (IntegrateDeltaRotation(imu_data, first, second).inverse() *
+          result_to_first_center.delta_rotation) *
+         result_center_to_center.delta_velocity;
+}
+
+TEST(ImuBasedPoseExtrapolatorTest, CachedImuIntegrationMatchesFreshOne) {
+  constexpr int kNumPoses = 30;
+  // The queue always holds the poses of the last 'kPoseQueueDuration'.
+  constexpr int kNumQueuedPoses =
+      static_cast<int>(kPoseQueueDuration / (kImuSamplesPerPose * kImuPeriod) +
+                       0.5) +
+      1;
+  ImuBasedPoseExtrapolator extrapolator(CreateOptions());
+  std::vector<sensor::ImuData> imu_data;
+  std::vector<common::Time> pose_times;
+  for (int i = 0; i != kNumPoses; ++i) {
+    const int pose_imu_index = kImuSamplesPerPose * (i + 1);
+    const int extrapolation_imu_index =
+        pose_imu_index + kImuSamplesPerPose / 2;
+    // IMU data must not be older than the last pose when it is added.
+    while (static_cast<int>(imu_data.size()) <= pose_imu_index) {
+      imu_data.push_back(CreateImuData(imu_data.size()));
+      extrapolator.AddImuData(imu_data.back());
+    }
+    pose_times.push_back(ImuSampleTime(pose_imu_index));
+    extrapolator.AddPose(pose_times.back(), CreatePose(pose_imu_index));
+    while (static_cast<int>(imu_data.size()) <= extrapolation_imu_index) {
+      imu_data.push_back(CreateImuData(imu_data.size()));
+      extrapolator.AddImuData(imu_data.back());
+    }
+    extrapolator.ExtrapolatePose(ImuSampleTime(extrapolation_imu_index));
+
+    const int num_queued_poses = std::min(i + 1, kNumQueuedPoses);
+    if (num_queued_poses < 3) {
+      // Nothing is integrated while extrapolating from fewer poses.
+      continue;
+    }
+    const auto& delta_rotations = extrapolator.imu_delta_rotations();
+    const auto& delta_velocities = extrapolator.imu_delta_velocities();
+    ASSERT_EQ(num_queued_poses - 1, static_cast<int>(delta_rotations.size()));
+    ASSERT_EQ(num_queued_poses - 2, static_cast<int>(delta_velocities.size()));
+    // The queued poses are the last 'num_queued_poses' which were added.
+    const int first_queued_index = i + 1 - num_queued_poses;
+    for (int j = 0; j + 1 < num_queued_poses; ++j) {
+      const common::Time first = pose_times[first_queued_index + j];
+      const common::Time second = pose_times[first_queued_index + j + 1];
+      EXPECT_TRUE(delta_rotations[j].isApprox(
+          IntegrateDeltaRotation(imu_data, first, second), 1e-12))
+          << "Pose " << i << ", interval " << j;
+      if (j + 2 < num_queued_poses) {
+        const common::Time third = pose_times[first_queued_index + j + 2];
+        EXPECT_TRUE(delta_velocities[j].isApprox(
+            IntegrateDeltaVelocity(imu_data, first, second, third), 1e-12))
+            << "Pose " << i << ", interval " << j;
+      }
+    }
+  }
+}
+
+}  // namespace
+}  // namespace mapping
+}  // namespace cartographer
@@ -253,6 +253,9 @@ void OptimizationProblem2D::Solve(
       frozen_trajectories.insert(it.first);
     }
   }
+  if (options_.discard_unused_sensor_data()) {
+    DiscardUnusedSensorData(frozen_trajectories);
+  }
 
   ceres::Problem::Options problem_options;
   ceres::Problem problem(problem_options);
@@ -427,6 +430,163 @@ void OptimizationProblem2D::Solve(
   }
 }
 
+void OptimizationProblem2D::SolveWindow(
+    const std::vector<Constraint>& constraints,
+    const std::set<SubmapId>& submap_ids, const std::set<NodeId>& node_ids) {
+  if (submap_ids.empty() && node_ids.empty()) {
+    // Nothing to optimize.
+    return;
+  }
+
+  ceres::Problem::Options problem_options;
+  ceres::Problem problem(problem_options);
+
+  // Parameter blocks are only created for the poses in the window and the
+  // poses outside of it which are needed as constant anchors. As in Solve(),
+  // the pose of the first submap stays fixed.
+  std::map<SubmapId, std::array<double, 3>> C_submaps;
+  std::map<NodeId, std::array<double, 3>> C_nodes;
+  const SubmapId first_submap_id = submap_data_.begin()->id;
+  const auto get_submap_pose = [&](const SubmapId& submap_id) {
+    auto it = C_submaps.find(submap_id);
+    if (it == C_submaps.end()) {
+      it = C_submaps
+               .emplace(submap_id,
+                        FromPose(submap_data_.at(submap_id).global_pose))
+               .first;
+      problem.AddParameterBlock(it->second.data(), 3);
+      if (submap_ids.count(submap_id) == 0 || submap_id == first_submap_id) {
+        problem.SetParameterBlockConstant(it->second.data());
+      }
+    }
+    return it->second.data();
+  };
+  const auto get_node_pose = [&](const NodeId& node_id) {
+    auto it = C_nodes.find(node_id);
+    if (it == C_nodes.end()) {
+      it = C_nodes
+               .emplace(node_id,
+                        FromPose(node_data_.at(node_id).global_pose_2d))
+               .first;
+      problem.AddParameterBlock(it->second.data(), 3);
+      if (node_ids.count(node_id) == 0) {
+        problem.SetParameterBlockConstant(it->second.data());
+      }
+    }
+    return it->second.data();
+  };
+
+  // Add cost functions for intra- and inter-submap constraints.
+  for (const Constraint& constraint : constraints) {
+    if (submap_ids.count(constraint.submap_id) == 0 &&
+        node_ids.count(constraint.node_id) == 0) {
+      continue;
+    }
+    problem.AddResidualBlock(
+        CreateAutoDiffSpaCostFunction(constraint.pose),
+        // Loop closure constraints should have a loss function.
+        constraint.tag == Constraint::INTER_SUBMAP
+            ? new ceres::HuberLoss(options_.huber_scale())
+            : nullptr,
+        get_submap_pose(constraint.submap_id),
+        get_node_pose(constraint.node_id));
+  }
+
+  // Add penalties for violating odometry or changes between consecutive nodes
+  // of which at least one is in the window.
+  const auto add_consecutive_nodes_cost_functions =
+      [&](const NodeId& first_node_id, const NodeId& second_node_id) {
+        const NodeSpec2D& first_node_data = node_data_.at(first_node_id);
+        const NodeSpec2D& second_node_data = node_data_.at(second_node_id);
+        const std::unique_ptr<transform::Rigid3d> relative_odometry =
+            CalculateOdometryBetweenNodes(first_node_id.trajectory_id,
+                                          first_node_data, second_node_data);
+        if (relative_odometry != nullptr) {
+          problem.AddResidualBlock(
+              CreateAutoDiffSpaCostFunction(Constraint::Pose{
+                  *relative_odometry, options_.odometry_translation_weight(),
+                  options_.odometry_rotation_weight()}),
+              nullptr /* loss function */, get_node_pose(first_node_id),
+              get_node_pose(second_node_id));
+        }
+        const transform::Rigid3d relative_local_slam_pose =
+            transform::Embed3D(first_node_data.local_pose_2d.inverse() *
+                               second_node_data.local_pose_2d);
+        problem.AddResidualBlock(
+            CreateAutoDiffSpaCostFunction(
+                Constraint::Pose{relative_local_slam_pose,
+                                 options_.local_slam_pose_translation_weight(),
+                                 options_.local_slam_pose_rotation_weight()}),
+            nullptr /* loss function */, get_node_pose(first_node_id),
+            get_node_pose(second_node_id));
+      };
+  for (const NodeId& node_id : node_ids) {
+    const NodeId previous_node_id{node_id.trajectory_id,
+                                  node_id.node_index - 1};
+    if (node_data_.Contains(previous_node_id)) {
+      add_consecutive_nodes_cost_functions(previous_node_id, node_id);
+    }
+    const NodeId next_node_id{node_id.trajectory_id, node_id.node_index + 1};
+    if (node_ids.count(next_node_id) == 0 &&
+        node_data_.Contains(next_node_id)) {
+      add_consecutive_nodes_cost_functions(node_id, next_node_id);
+    }
+  }
+
+  // Solve.
+  ceres::Solver::Summary summary;
+  ceres::Solve(
+      common::CreateCeresSolverOptions(options_.ceres_solver_options()),
+      &problem, &summary);
+  if (options_.log_solver_summary()) {
+    LOG(INFO) << summary.BriefReport();
+  }
+
+  // Store the result.
+  for (const auto& C_submap : C_submaps) {
+    if (submap_ids.count(C_submap.first) != 0) {
+      submap_data_.at(C_submap.first).global_pose = ToPose(C_submap.second);
+    }
+  }
+  for (const auto& C_node : C_nodes) {
+    if (node_ids.count(C_node.first) != 0) {
+      node_data_.at(C_node.first).global_pose_2d = ToPose(C_node.second);
+    }
+  }
+}
+
+void OptimizationProblem2D::DiscardUnusedSensorData(
+    const std::set<int>& frozen_trajectories) {
+  size_t num_odometry_data = 0;
+  size_t num_fixed_frame_pose_data = 0;
+  for (const int trajectory_id : node_data_.trajectory_ids()) {
+    // Data before the first node is only needed to interpolate at its time.
+    const common::Time first_node_time =
+        node_data_.BeginOfTrajectory(trajectory_id)->data.time;
+    if (frozen_trajectories.count(trajectory_id) != 0) {
+      // Odometry data only constrains non-frozen nodes.
+      num_odometry_data += odometry_data_.EraseTrajectory(trajectory_id);
+    } else {
+      num_odometry_data +=
+          odometry_data_.TrimBefore(trajectory_id, first_node_time);
+    }
+    num_fixed_frame_pose_data +=
+        fixed_frame_pose_data_.TrimBefore(trajectory_id, first_node_time);
+  }
+  const size_t num_bytes =
+      num_odometry_data *
+          sensor::MapByTime<sensor::OdometryData>::ApproximateBytesPerData() +
+      num_fixed_frame_pose_data *
+          sensor::MapByTime<
+              sensor::FixedFramePoseData>::ApproximateBytesPerData();
+  if (num_bytes > 0) {
+    LOG(INFO) << "Discarded " << num_odometry_data << " odometry and "
+              << num_fixed_frame_pose_data
+              << " fixed frame pose data, reclaiming about "
+              << num_bytes / 1024 << " KiB.";
+  }
+}
+
 std::unique_ptr<transform::Rigid3d> OptimizationProblem2D::InterpolateOdometry(
     const int trajectory_id, const common::Time time) const {
   const auto it = odometry_data_.lower_bound(trajectory_id, time);
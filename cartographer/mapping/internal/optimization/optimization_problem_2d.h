@@ -83,6 +83,16 @@ class OptimizationProblem2D
           trajectories_state,
       const std::map<std::string, LandmarkNode>& landmark_nodes) override;
 
+  // Optimizes only the global poses of the submaps in 'submap_ids' and of the
+  // nodes in 'node_ids', which must not belong to frozen trajectories. Poses
+  // of other submaps and nodes they are constrained to are held constant.
+  // Only the elements of 'constraints' touching the window are used. Odometry
+  // and local SLAM poses are taken into account, landmarks and fixed frame
+  // poses are not.
+  void SolveWindow(const std::vector<Constraint>& constraints,
+                   const std::set<SubmapId>& submap_ids,
+                   const std::set<NodeId>& node_ids);
+
   const MapById<NodeId, NodeSpec2D>& node_data() const override {
     return node_data_;
   }
@@ -117,6 +127,9 @@ class OptimizationProblem2D
   }
 
  private:
+  // Discards sensor data which cannot influence the optimization anymore,
+  // see 'discard_unused_sensor_data' in the options.
+  void DiscardUnusedSensorData(const std::set<int>& frozen_trajectories);
   std::unique_ptr<transform::Rigid3d> InterpolateOdometry(
       int trajectory_id, common::Time time) const;
   // Computes the relative pose between two nodes based on odometry data.
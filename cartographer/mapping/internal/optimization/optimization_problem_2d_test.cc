@@ -0,0 +1,134 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cartographer/mapping/internal/optimization/optimization_problem_2d.h"
+
+#include <set>
+#include <vector>
+
+#include "cartographer/common/internal/testing/lua_parameter_dictionary_test_helpers.h"
+#include "cartographer/common/time.h"
+#include "cartographer/mapping/internal/optimization/optimization_problem_options.h"
+#include "cartographer/transform/rigid_transform_test_helpers.h"
+#include "cartographer/transform/transform.h"
+#include "gmock/gmock.h"
+
+namespace cartographer {
+namespace mapping {
+namespace optimization {
+namespace {
+
+using Constraint = PoseGraphInterface::Constraint;
+
+constexpr int kTrajectoryId = 0;
+constexpr int kNumSubmaps = 4;
+constexpr int kNumNodesPerSubmap = 2;
+
+proto::OptimizationProblemOptions CreateOptions() {
+  auto parameter_dictionary = common::MakeDictionary(R"text(
+      return {
+        acceleration_weight = 1.,
+        rotation_weight = 1.,
+        huber_scale = 1.,
+        local_slam_pose_translation_weight = 1.,
+        local_slam_pose_rotation_weight = 1.,
+        odometry_translation_weight = 1.,
+        odometry_rotation_weight = 1.,
+        fixed_frame_pose_translation_weight = 1.,
+        fixed_frame_pose_rotation_weight = 1.,
+        fixed_frame_pose_use_tolerant_loss = false,
+        fixed_frame_pose_tolerant_loss_param_a = 1,
+        fixed_frame_pose_tolerant_loss_param_b = 1,
+        log_solver_summary = false,
+        discard_unused_sensor_data = false,
+        use_online_imu_extrinsics_in_3d = true,
+        fix_z_in_3d = false,
+        ceres_solver_options = {
+          use_nonmonotonic_steps = false,
+          max_num_iterations = 50,
+          num_threads = 1,
+        },
+      })text");
+  return CreateOptimizationProblemOptions(parameter_dictionary.get());
+}
+
+transform::Rigid2d SubmapPose(const int submap_index) {
+  return transform::Rigid2d({2. * submap_index, 0.}, 0.1 * submap_index);
+}
+
+transform::Rigid2d NodePose(const int node_index) {
+  return transform::Rigid2d({1. * node_index, 0.2 * node_index},
+                            0.05 * node_index);
+}
+
+TEST(OptimizationProblem2DTest, SolveWindowOnlyChangesWindow) {
+  OptimizationProblem2D optimization_problem(CreateOptions());
+  const transform::Rigid2d error({0.3, -0.2}, 0.1);
+  const int last_submap_index = kNumSubmaps - 1;
+  std::vector<Constraint> constraints;
+  for (int submap_index = 0; submap_index != kNumSubmaps; ++submap_index) {
+    optimization_problem.AddSubmap(
+        kTrajectoryId, submap_index == last_submap_index
+                           ? error * SubmapPose(submap_index)
+                           : SubmapPose(submap_index));
+    for (int i = 0; i != kNumNodesPerSubmap; ++i) {
+      const int node_index = kNumNodesPerSubmap * submap_index + i;
+      optimization_problem.AddTrajectoryNode(
+          kTrajectoryId,
+          NodeSpec2D{common::FromUniversal(node_index), NodePose(node_index),
+                     submap_index == last_submap_index
+                         ? error * NodePose(node_index)
+                         : NodePose(node_index),
+                     Eigen::Quaterniond::Identity()});
+      constraints.push_back(Constraint{
+          SubmapId{kTrajectoryId, submap_index},
+          NodeId{kTrajectoryId, node_index},
+          {transform::Embed3D(SubmapPose(submap_index).inverse() *
+                              NodePose(node_index)),
+           1., 1.},
+          Constraint::INTRA_SUBMAP});
+    }
+  }
+
+  std::set<NodeId> node_ids;
+  for (int i = 0; i != kNumNodesPerSubmap; ++i) {
+    node_ids.insert(
+        NodeId{kTrajectoryId, kNumNodesPerSubmap * last_submap_index + i});
+  }
+  optimization_problem.SolveWindow(
+      constraints, {SubmapId{kTrajectoryId, last_submap_index}}, node_ids);
+
+  for (int submap_index = 0; submap_index != kNumSubmaps; ++submap_index) {
+    EXPECT_THAT(optimization_problem.submap_data()
+                    .at(SubmapId{kTrajectoryId, submap_index})
+                    .global_pose,
+                transform::IsNearly(SubmapPose(submap_index), 1e-4))
+        << submap_index;
+  }
+  for (int node_index = 0; node_index != kNumSubmaps * kNumNodesPerSubmap;
+       ++node_index) {
+    EXPECT_THAT(optimization_problem.node_data()
+                    .at(NodeId{kTrajectoryId, node_index})
+                    .global_pose_2d,
+                transform::IsNearly(NodePose(node_index), 1e-4))
+        << node_index;
+  }
+}
+
+}  // namespace
+}  // namespace optimization
+}  // namespace mapping
+}  // namespace cartographer
@@ -225,6 +225,12 @@ void OptimizationProblem3D::InsertTrajectoryNode(const NodeId& node_id,
 }
 
 void OptimizationProblem3D::TrimTrajectoryNode(const NodeId& node_id) {
+  // Drop the cached IMU integrals over intervals ending at or starting from
+  // this node.
+  for (int i = std::max(0, node_id.node_index - 2); i <= node_id.node_index;
+       ++i) {
+    imu_integration_cache_.erase(NodeId{node_id.trajectory_id, i});
+  }
   imu_data_.Trim(node_data_, node_id);
   odometry_data_.Trim(node_data_, node_id);
   fixed_frame_pose_data_.Trim(node_data_, node_id);
@@ -270,6 +276,9 @@ void OptimizationProblem3D::Solve(
       frozen_trajectories.insert(it.first);
     }
   }
+  if (options_.discard_unused_sensor_data()) {
+    DiscardUnusedSensorData(frozen_trajectories);
+  }
 
   ceres::Problem::Options problem_options;
   ceres::Problem problem(problem_options);
@@ -369,10 +378,7 @@ void OptimizationProblem3D::Solve(
             trajectory_data.imu_calibration.data());
       }
       CHECK(imu_data_.HasTrajectory(trajectory_id));
-      const auto imu_data = imu_data_.trajectory(trajectory_id);
-      CHECK(imu_data.begin() != imu_data.end());
 
-      auto imu_it = imu_data.begin();
       auto prev_node_it = node_it;
 
       bool gravity_block_added = false;
@@ -387,45 +393,26 @@ void OptimizationProblem3D::Solve(
           continue;
         }
 
-        // Skip IMU data before the node.
-        while (std::next(imu_it) != imu_data.end() &&
-               std::next(imu_it)->time <= first_node_data.time) {
-          ++imu_it;
-        }
-
-        auto imu_it2 = imu_it;
-        const IntegrateImuResult<double> result = IntegrateImu(
-            imu_data, first_node_data.time, second_node_data.time, &imu_it);
         const auto next_node_it = std::next(node_it);
+        const bool has_third_node =
+            next_node_it != trajectory_end &&
+            next_node_it->id.node_index == second_node_id.node_index + 1;
         const common::Time first_time = first_node_data.time;
         const common::Time second_time = second_node_data.time;
         const common::Duration first_duration = second_time - first_time;
-        if (next_node_it != trajectory_end &&
-            next_node_it->id.node_index == second_node_id.node_index + 1) {
+        const ImuIntegration integration = IntegrateImuBetweenNodes(
+            first_node_id, first_time, second_time,
+            has_third_node ? absl::make_optional(next_node_it->data.time)
+                           : absl::nullopt);
+        if (has_third_node) {
           const NodeId third_node_id = next_node_it->id;
-          const NodeSpec3D& third_node_data = next_node_it->data;
-          const common::Time third_time = third_node_data.time;
-          const common::Duration second_duration = third_time - second_time;
-          const common::Time first_center = first_time + first_duration / 2;
-          const common::Time second_center = second_time + second_duration / 2;
-          const IntegrateImuResult<double> result_to_first_center =
-              IntegrateImu(imu_data, first_time, first_center, &imu_it2);
-          const IntegrateImuResult<double> result_center_to_center =
-              IntegrateImu(imu_data, first_center, second_center, &imu_it2);
-          // 'delta_velocity' is the change in velocity from the point in time
-          // halfway between the first and second poses to halfway between
-          // second and third pose. It is computed from IMU data and still
-          // contains a delta due to gravity. The orientation of this vector is
-          // in the IMU frame at the second pose.
-          const Eigen::Vector3d delta_velocity =
-              (result.delta_rotation.inverse() *
-               result_to_first_center.delta_rotation) *
-              result_center_to_center.delta_velocity;
+          const common::Duration second_duration =
+              *integration.third_time - second_time;
           problem.AddResidualBlock(
               AccelerationCostFunction3D::CreateAutoDiffCostFunction(
                   options_.acceleration_weight() /
                       common::ToSeconds(first_duration + second_duration),
-                  delta_velocity, common::ToSeconds(first_duration),
+                  integration.delta_velocity, common::ToSeconds(first_duration),
                   common::ToSeconds(second_duration)),
               nullptr /* loss function */,
               C_nodes.at(second_node_id).rotation(),
@@ -439,7 +426,7 @@ void OptimizationProblem3D::Solve(
         problem.AddResidualBlock(
             RotationCostFunction3D::CreateAutoDiffCostFunction(
                 options_.rotation_weight() / common::ToSeconds(first_duration),
-                result.delta_rotation),
+                integration.delta_rotation),
             nullptr /* loss function */, C_nodes.at(first_node_id).rotation(),
             C_nodes.at(second_node_id).rotation(),
             trajectory_data.imu_calibration.data());
@@ -610,6 +597,107 @@ void OptimizationProblem3D::Solve(
   }
 }
 
+void OptimizationProblem3D::DiscardUnusedSensorData(
+    const std::set<int>& frozen_trajectories) {
+  size_t num_imu_data = 0;
+  size_t num_odometry_data = 0;
+  size_t num_fixed_frame_pose_data = 0;
+  for (const int trajectory_id : node_data_.trajectory_ids()) {
+    // Data before the first node is only needed to interpolate at its time.
+    const common::Time first_node_time =
+        node_data_.BeginOfTrajectory(trajectory_id)->data.time;
+    if (frozen_trajectories.count(trajectory_id) != 0) {
+      // IMU and odometry data only constrain non-frozen nodes.
+      num_imu_data += imu_data_.EraseTrajectory(trajectory_id);
+      num_odometry_data += odometry_data_.EraseTrajectory(trajectory_id);
+    } else {
+      num_imu_data += imu_data_.TrimBefore(trajectory_id, first_node_time);
+      num_odometry_data +=
+          odometry_data_.TrimBefore(trajectory_id, first_node_time);
+    }
+    num_fixed_frame_pose_data +=
+        fixed_frame_pose_data_.TrimBefore(trajectory_id, first_node_time);
+  }
+  const size_t num_bytes =
+      num_imu_data *
+          sensor::MapByTime<sensor::ImuData>::ApproximateBytesPerData() +
+      num_odometry_data *
+          sensor::MapByTime<sensor::OdometryData>::ApproximateBytesPerData() +
+      num_fixed_frame_pose_data *
+          sensor::MapByTime<
+              sensor::FixedFramePoseData>::ApproximateBytesPerData();
+  if (num_bytes > 0) {
+    LOG(INFO) << "Discarded " << num_imu_data << " IMU, " << num_odometry_data
+              << " odometry and " << num_fixed_frame_pose_data
+              << " fixed frame pose data, reclaiming about "
+              << num_bytes / 1024 << " KiB.";
+  }
+}
+
+OptimizationProblem3D::ImuIntegration
+OptimizationProblem3D::IntegrateImuBetweenNodes(
+    const NodeId& first_node_id, const common::Time first_time,
+    const common::Time second_time,
+    const absl::optional<common::Time> third_time) {
+  const auto cache_it = imu_integration_cache_.find(first_node_id);
+  if (cache_it != imu_integration_cache_.end() &&
+      cache_it->second.first_time == first_time &&
+      cache_it->second.second_time == second_time &&
+      cache_it->second.third_time == third_time) {
+    return cache_it->second;
+  }
+
+  const int trajectory_id = first_node_id.trajectory_id;
+  const auto imu_data = imu_data_.trajectory(trajectory_id);
+  CHECK(imu_data.begin() != imu_data.end());
+  // Start at the last IMU data not after 'first_time', or the first one.
+  auto imu_it = imu_data_.lower_bound(trajectory_id, first_time);
+  if ((imu_it == imu_data.end() || imu_it->time > first_time) &&
+      imu_it != imu_data.begin()) {
+    --imu_it;
+  }
+
+  ImuIntegration integration;
+  integration.first_time = first_time;
+  integration.second_time = second_time;
+  integration.third_time = third_time;
+  auto imu_it2 = imu_it;
+  const IntegrateImuResult<double> result =
+      IntegrateImu(imu_data, first_time, second_time, &imu_it);
+  integration.delta_rotation = result.delta_rotation;
+  common::Time end_time = second_time;
+  if (third_time.has_value()) {
+    const common::Duration first_duration = second_time - first_time;
+    const common::Duration second_duration = *third_time - second_time;
+    const common::Time first_center = first_time + first_duration / 2;
+    const common::Time second_center = second_time + second_duration / 2;
+    const IntegrateImuResult<double> result_to_first_center =
+        IntegrateImu(imu_data, first_time, first_center, &imu_it2);
+    const IntegrateImuResult<double> result_center_to_center =
+        IntegrateImu(imu_data, first_center, second_center, &imu_it2);
+    // 'delta_velocity' is the change in velocity from the point in time
+    // halfway between the first and second poses to halfway between
+    // second and third pose. It is computed from IMU data and still
+    // contains a delta due to gravity. The orientation of this vector is
+    // in the IMU frame at the second pose.
+    integration.delta_velocity = (result.delta_rotation.inverse() *
+                                  result_to_first_center.delta_rotation) *
+                                 result_center_to_center.delta_velocity;
+    end_time = second_center;
+  } else {
+    integration.delta_velocity = Eigen::Vector3d::Zero();
+  }
+
+  // IMU data is appended in time order, so once data at or after 'end_time'
+  // was received, the integrals are final.
+  if (std::prev(imu_data.end())->time >= end_time) {
+    imu_integration_cache_[first_node_id] = integration;
+  } else if (cache_it != imu_integration_cache_.end()) {
+    imu_integration_cache_.erase(cache_it);
+  }
+  return integration;
+}
+
 std::unique_ptr<transform::Rigid3d>
 OptimizationProblem3D::CalculateOdometryBetweenNodes(
     const int trajectory_id, const NodeSpec3D& first_node_data,
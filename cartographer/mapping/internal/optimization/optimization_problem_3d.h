@@ -116,7 +116,37 @@ class OptimizationProblem3D
     return trajectory_data_;
   }
 
+  // Returns true if the IMU integrals for the nodes starting at
+  // 'first_node_id' are cached.
+  //
+  // Visible for testing.
+  bool HasCachedImuIntegration(const NodeId& first_node_id) const {
+    return imu_integration_cache_.count(first_node_id) != 0;
+  }
+
  private:
+  // Discards sensor data which cannot influence the optimization anymore,
+  // see 'discard_unused_sensor_data' in the options.
+  void DiscardUnusedSensorData(const std::set<int>& frozen_trajectories);
+  // IMU integrals over the interval from a node to the next one and, if there
+  // is a third consecutive node, the velocity change between the centers of
+  // the two intervals.
+  struct ImuIntegration {
+    common::Time first_time;
+    common::Time second_time;
+    absl::optional<common::Time> third_time;
+    Eigen::Quaterniond delta_rotation;
+    // Only valid if 'third_time' is set.
+    Eigen::Vector3d delta_velocity;
+  };
+
+  // Returns the IMU integrals for the nodes starting at 'first_node_id' with
+  // the given times. Results are cached per node and reused as long as the
+  // node times are unchanged.
+  ImuIntegration IntegrateImuBetweenNodes(
+      const NodeId& first_node_id, common::Time first_time,
+      common::Time second_time, absl::optional<common::Time> third_time);
+
   // Computes the relative pose between two nodes based on odometry data.
   std::unique_ptr<transform::Rigid3d> CalculateOdometryBetweenNodes(
       int trajectory_id, const NodeSpec3D& first_node_data,
@@ -130,6 +160,9 @@ class OptimizationProblem3D
   sensor::MapByTime<sensor::OdometryData> odometry_data_;
   sensor::MapByTime<sensor::FixedFramePoseData> fixed_frame_pose_data_;
   std::map<int, PoseGraphInterface::TrajectoryData> trajectory_data_;
+  // Only holds integrals for which all IMU data has been received, i.e. which
+  // newly added IMU data cannot change.
+  std::map<NodeId, ImuIntegration> imu_integration_cache_;
 };
 
 }  // namespace optimization
@@ -16,12 +16,17 @@
 
 #include "cartographer/mapping/internal/optimization/optimization_problem_3d.h"
 
+#include <algorithm>
+#include <cmath>
+#include <memory>
 #include <random>
 
 #include "Eigen/Core"
+#include "absl/memory/memory.h"
 #include "cartographer/common/internal/testing/lua_parameter_dictionary_test_helpers.h"
 #include "cartographer/common/time.h"
 #include "cartographer/mapping/internal/optimization/optimization_problem_options.h"
+#include "cartographer/transform/rigid_transform_test_helpers.h"
 #include "cartographer/transform/transform.h"
 #include "glog/logging.h"
 #include "gmock/gmock.h"
@@ -31,6 +36,14 @@ namespace mapping {
 namespace optimization {
 namespace {
 
+transform::Rigid3d AddNoise(const transform::Rigid3d& transform,
+                            const transform::Rigid3d& noise) {
+  const Eigen::Quaterniond noisy_rotation(noise.rotation() *
+                                          transform.rotation());
+  return transform::Rigid3d(transform.translation() + noise.translation(),
+                            noisy_rotation);
+}
+
 class OptimizationProblem3DTest : public ::testing::Test {
  protected:
   OptimizationProblem3DTest()
@@ -52,6 +65,7 @@ class OptimizationProblem3DTest : public ::testing::Test {
           fixed_frame_pose_tolerant_loss_param_a = 1,
           fixed_frame_pose_tolerant_loss_param_b = 1,
           log_solver_summary = true,
+          discard_unused_sensor_data = false,
           use_online_imu_extrinsics_in_3d = true,
           fix_z_in_3d = false,
           ceres_solver_options = {
@@ -96,18 +110,77 @@ class OptimizationProblem3DTest : public ::testing::Test {
                                   Eigen::Vector3d(0., 0., rz)));
   }
 
+  // Appends 'num_nodes' noisy nodes 0.1 s apart to trajectory 0 of
+  // 'optimization_problem_' together with IMU data of a wobbling rotation,
+  // which extends past the last node. Adds a constraint to submap 0 for each
+  // node.
+  void AddNodesWithImuData(
+      const int num_nodes,
+      std::vector<OptimizationProblem3D::Constraint>* constraints) {
+    for (int i = 0; i != num_nodes; ++i) {
+      const common::Time node_time =
+          common::FromUniversal(0) +
+          common::FromSeconds(0.1 * next_node_index_);
+      while (next_imu_time_ <= node_time + common::FromSeconds(0.1)) {
+        const double t = common::ToSeconds(next_imu_time_ -
+                                           common::FromUniversal(0));
+        optimization_problem_.AddImuData(
+            0, sensor::ImuData{next_imu_time_, Eigen::Vector3d::UnitZ() * 9.81,
+                               Eigen::Vector3d(0.1 * std::sin(t), 0.,
+                                               0.3 * std::cos(2. * t))});
+        next_imu_time_ += common::FromSeconds(0.02);
+      }
+      const transform::Rigid3d ground_truth_pose(
+          Eigen::Vector3d(0.1 * next_node_index_,
+                          0.5 * std::sin(0.1 * next_node_index_), 0.),
+          transform::RollPitchYaw(0., 0., 0.05 * next_node_index_));
+      const transform::Rigid3d pose =
+          AddNoise(ground_truth_pose, RandomYawOnlyTransform(0.02, 0.03));
+      optimization_problem_.AddTrajectoryNode(
+          0, NodeSpec3D{node_time, pose, pose});
+      constraints->push_back(OptimizationProblem3D::Constraint{
+          SubmapId{0, 0}, NodeId{0, next_node_index_},
+          OptimizationProblem3D::Constraint::Pose{ground_truth_pose, 1., 1.}});
+      ++next_node_index_;
+    }
+  }
+
+  // Returns a problem with the same data as 'optimization_problem_', but
+  // without cached IMU integrals.
+  std::unique_ptr<OptimizationProblem3D> CopyWithoutCache() {
+    auto copy = absl::make_unique<OptimizationProblem3D>(CreateOptions());
+    for (const auto& node : optimization_problem_.node_data()) {
+      copy->InsertTrajectoryNode(node.id, node.data);
+    }
+    for (const auto& submap : optimization_problem_.submap_data()) {
+      copy->InsertSubmap(submap.id, submap.data.global_pose);
+    }
+    for (const sensor::ImuData& imu_data :
+         optimization_problem_.imu_data().trajectory(0)) {
+      copy->AddImuData(0, imu_data);
+    }
+    for (const auto& entry : optimization_problem_.trajectory_data()) {
+      copy->SetTrajectoryData(entry.first, entry.second);
+    }
+    return copy;
+  }
+
+  void ExpectSameNodePoses(const OptimizationProblem3D& expected,
+                           const OptimizationProblem3D& actual) {
+    ASSERT_EQ(expected.node_data().size(), actual.node_data().size());
+    for (const auto& node : expected.node_data()) {
+      EXPECT_THAT(actual.node_data().at(node.id).global_pose,
+                  transform::IsNearly(node.data.global_pose, 1e-6))
+          << node.id;
+    }
+  }
+
   OptimizationProblem3D optimization_problem_;
   std::mt19937 rng_;
+  int next_node_index_ = 0;
+  common::Time next_imu_time_ = common::FromUniversal(0);
 };
 
-transform::Rigid3d AddNoise(const transform::Rigid3d& transform,
-                            const transform::Rigid3d& noise) {
-  const Eigen::Quaterniond noisy_rotation(noise.rotation() *
-                                          transform.rotation());
-  return transform::Rigid3d(transform.translation() + noise.translation(),
-                            noisy_rotation);
-}
-
 TEST_F(OptimizationProblem3DTest, ReducesNoise) {
   constexpr int kNumNodes = 100;
   const transform::Rigid3d kSubmap0Transform = transform::Rigid3d::Identity();
@@ -196,6 +269,69 @@ TEST_F(OptimizationProblem3DTest, ReducesNoise) {
   EXPECT_GT(0.8 * rotation_error_before, rotation_error_after);
 }
 
+TEST_F(OptimizationProblem3DTest, CachedImuIntegrationMatchesFreshIntegration) {
+  const std::map<int, PoseGraphInterface::TrajectoryState> kTrajectoriesState =
+      {{0, PoseGraphInterface::TrajectoryState::ACTIVE}};
+  optimization_problem_.AddSubmap(0, transform::Rigid3d::Identity());
+  std::vector<OptimizationProblem3D::Constraint> constraints;
+  for (int i = 0; i != 3; ++i) {
+    AddNodesWithImuData(10, &constraints);
+    // Integrates all IMU data from scratch.
+    const std::unique_ptr<OptimizationProblem3D> fresh_optimization_problem =
+        CopyWithoutCache();
+    fresh_optimization_problem->Solve(constraints, kTrajectoriesState, {});
+    optimization_problem_.Solve(constraints, kTrajectoriesState, {});
+    ExpectSameNodePoses(*fresh_optimization_problem, optimization_problem_);
+    // All intervals which are followed by IMU data have been cached.
+    EXPECT_TRUE(optimization_problem_.HasCachedImuIntegration(NodeId{0, 0}));
+    EXPECT_TRUE(optimization_problem_.HasCachedImuIntegration(
+        NodeId{0, next_node_index_ - 2}));
+    EXPECT_FALSE(optimization_problem_.HasCachedImuIntegration(
+        NodeId{0, next_node_index_ - 1}));
+  }
+}
+
+TEST_F(OptimizationProblem3DTest, TrimmingNodeInvalidatesImuIntegrationCache) {
+  const std::map<int, PoseGraphInterface::TrajectoryState> kTrajectoriesState =
+      {{0, PoseGraphInterface::TrajectoryState::ACTIVE}};
+  optimization_problem_.AddSubmap(0, transform::Rigid3d::Identity());
+  std::vector<OptimizationProblem3D::Constraint> constraints;
+  AddNodesWithImuData(20, &constraints);
+  optimization_problem_.Solve(constraints, kTrajectoriesState, {});
+  for (int i = 0; i != 19; ++i) {
+    EXPECT_TRUE(optimization_problem_.HasCachedImuIntegration(NodeId{0, i}));
+  }
+
+  // Node 10 is the first, second or third node of the intervals starting at
+  // nodes 8, 9 and 10.
+  constexpr int kTrimmedNodeIndex = 10;
+  optimization_problem_.TrimTrajectoryNode(NodeId{0, kTrimmedNodeIndex});
+  constraints.erase(
+      std::remove_if(constraints.begin(), constraints.end(),
+                     [](const OptimizationProblem3D::Constraint& constraint) {
+                       return constraint.node_id.node_index ==
+                              kTrimmedNodeIndex;
+                     }),
+      constraints.end());
+  EXPECT_TRUE(optimization_problem_.HasCachedImuIntegration(NodeId{0, 7}));
+  for (int i = 8; i <= kTrimmedNodeIndex; ++i) {
+    EXPECT_FALSE(optimization_problem_.HasCachedImuIntegration(NodeId{0, i}));
+  }
+  EXPECT_TRUE(optimization_problem_.HasCachedImuIntegration(NodeId{0, 11}));
+
+  AddNodesWithImuData(5, &constraints);
+  const std::unique_ptr<OptimizationProblem3D> fresh_optimization_problem =
+      CopyWithoutCache();
+  fresh_optimization_problem->Solve(constraints, kTrajectoriesState, {});
+  optimization_problem_.Solve(constraints, kTrajectoriesState, {});
+  ExpectSameNodePoses(*fresh_optimization_problem, optimization_problem_);
+  // Node 8 is now followed by only one consecutive node, and node 9 by none.
+  EXPECT_TRUE(optimization_problem_.HasCachedImuIntegration(NodeId{0, 8}));
+  EXPECT_FALSE(optimization_problem_.HasCachedImuIntegration(NodeId{0, 9}));
+  EXPECT_FALSE(optimization_problem_.HasCachedImuIntegration(
+      NodeId{0, kTrimmedNodeIndex}));
+}
+
 }  // namespace
 }  // namespace optimization
 }  // namespace mapping
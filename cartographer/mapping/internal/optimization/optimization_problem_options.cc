@@ -50,6 +50,8 @@ proto::OptimizationProblemOptions CreateOptimizationProblemOptions(
       parameter_dictionary->GetDouble("fixed_frame_pose_tolerant_loss_param_b"));
   options.set_log_solver_summary(
       parameter_dictionary->GetBool("log_solver_summary"));
+  options.set_discard_unused_sensor_data(
+      parameter_dictionary->GetBool("discard_unused_sensor_data"));
   options.set_use_online_imu_extrinsics_in_3d(
       parameter_dictionary->GetBool("use_online_imu_extrinsics_in_3d"));
   options.set_fix_z_in_3d(parameter_dictionary->GetBool("fix_z_in_3d"));
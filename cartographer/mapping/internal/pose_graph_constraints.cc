@@ -0,0 +1,188 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cartographer/mapping/internal/pose_graph_constraints.h"
+
+#include <algorithm>
+#include <functional>
+
+#include "glog/logging.h"
+
+namespace cartographer {
+namespace mapping {
+namespace {
+
+// Replaces 'old_index' in 'indices' by 'new_index'.
+void ReplaceIndex(const size_t old_index, const size_t new_index,
+                  std::vector<size_t>* indices) {
+  const auto it = std::find(indices->begin(), indices->end(), old_index);
+  CHECK(it != indices->end());
+  *it = new_index;
+}
+
+// Removes 'index' from 'indices'.
+void EraseIndex(const size_t index, std::vector<size_t>* indices) {
+  const auto it = std::find(indices->begin(), indices->end(), index);
+  CHECK(it != indices->end());
+  *it = indices->back();
+  indices->pop_back();
+}
+
+}  // namespace
+
+void PoseGraphConstraints::Add(const Constraint& constraint) {
+  const size_t index = constraints_.size();
+  constraints_.push_back(constraint);
+  SubmapEntry& submap_entry = submap_index_[constraint.submap_id];
+  submap_entry.indices.push_back(index);
+  node_index_[constraint.node_id].push_back(index);
+  if (constraint.tag == Constraint::INTER_SUBMAP) {
+    ++submap_entry.num_inter_submap_constraints;
+    ++num_inter_submap_constraints_[std::make_pair(
+        constraint.node_id.trajectory_id,
+        constraint.submap_id.trajectory_id)];
+  }
+}
+
+void PoseGraphConstraints::Add(const std::vector<Constraint>& constraints) {
+  constraints_.reserve(constraints_.size() + constraints.size());
+  for (const Constraint& constraint : constraints) {
+    Add(constraint);
+  }
+}
+
+std::set<SubmapId> PoseGraphConstraints::Remove(
+    const std::set<SubmapId>& submap_ids, const std::set<NodeId>& node_ids) {
+  std::vector<size_t> indices_to_remove;
+  for (const SubmapId& submap_id : submap_ids) {
+    const auto it = submap_index_.find(submap_id);
+    if (it != submap_index_.end()) {
+      indices_to_remove.insert(indices_to_remove.end(),
+                               it->second.indices.begin(),
+                               it->second.indices.end());
+    }
+  }
+  std::set<SubmapId> other_submap_ids_losing_constraints;
+  for (const NodeId& node_id : node_ids) {
+    const auto it = node_index_.find(node_id);
+    if (it == node_index_.end()) {
+      continue;
+    }
+    for (const size_t index : it->second) {
+      const SubmapId& submap_id = constraints_[index].submap_id;
+      // Constraints to removed submaps have already been collected above.
+      if (submap_ids.count(submap_id) == 0) {
+        indices_to_remove.push_back(index);
+        other_submap_ids_losing_constraints.insert(submap_id);
+      }
+    }
+  }
+
+  // Removing from the back guarantees that the constraint moved into a freed
+  // slot is never one that still has to be removed.
+  std::sort(indices_to_remove.begin(), indices_to_remove.end(),
+            std::greater<size_t>());
+  for (const size_t index : indices_to_remove) {
+    RemoveAt(index);
+  }
+  // Give back the memory of the removed constraints once a substantial part
+  // of them is gone, without reallocating on every call.
+  if (constraints_.capacity() > 2 * constraints_.size()) {
+    constraints_.shrink_to_fit();
+  }
+  return other_submap_ids_losing_constraints;
+}
+
+void PoseGraphConstraints::RemoveAt(const size_t index) {
+  CHECK_LT(index, constraints_.size());
+  {
+    const Constraint& constraint = constraints_[index];
+    const auto submap_it = submap_index_.find(constraint.submap_id);
+    CHECK(submap_it != submap_index_.end());
+    EraseIndex(index, &submap_it->second.indices);
+    if (constraint.tag == Constraint::INTER_SUBMAP) {
+      --submap_it->second.num_inter_submap_constraints;
+      const auto trajectories_it =
+          num_inter_submap_constraints_.find(std::make_pair(
+              constraint.node_id.trajectory_id,
+              constraint.submap_id.trajectory_id));
+      CHECK(trajectories_it != num_inter_submap_constraints_.end());
+      if (--trajectories_it->second == 0) {
+        num_inter_submap_constraints_.erase(trajectories_it);
+      }
+    }
+    if (submap_it->second.indices.empty()) {
+      submap_index_.erase(submap_it);
+    }
+    const auto node_it = node_index_.find(constraint.node_id);
+    CHECK(node_it != node_index_.end());
+    EraseIndex(index, &node_it->second);
+    if (node_it->second.empty()) {
+      node_index_.erase(node_it);
+    }
+  }
+
+  const size_t last_index = constraints_.size() - 1;
+  if (index != last_index) {
+    constraints_[index] = constraints_[last_index];
+    const Constraint& moved_constraint = constraints_[index];
+    ReplaceIndex(last_index, index,
+                 &submap_index_.at(moved_constraint.submap_id).indices);
+    ReplaceIndex(last_index, index, &node_index_.at(moved_constraint.node_id));
+  }
+  constraints_.pop_back();
+}
+
+std::vector<PoseGraphConstraints::Constraint>
+PoseGraphConstraints::GetSubmapConstraints(const SubmapId& submap_id) const {
+  std::vector<Constraint> result;
+  const auto it = submap_index_.find(submap_id);
+  if (it != submap_index_.end()) {
+    for (const size_t index : it->second.indices) {
+      result.push_back(constraints_[index]);
+    }
+  }
+  return result;
+}
+
+std::vector<PoseGraphConstraints::Constraint>
+PoseGraphConstraints::GetNodeConstraints(const NodeId& node_id) const {
+  std::vector<Constraint> result;
+  const auto it = node_index_.find(node_id);
+  if (it != node_index_.end()) {
+    for (const size_t index : it->second) {
+      result.push_back(constraints_[index]);
+    }
+  }
+  return result;
+}
+
+bool PoseGraphConstraints::HasInterSubmapConstraints(
+    const SubmapId& submap_id) const {
+  const auto it = submap_index_.find(submap_id);
+  return it != submap_index_.end() &&
+         it->second.num_inter_submap_constraints > 0;
+}
+
+int PoseGraphConstraints::NumInterSubmapConstraints(
+    const int node_trajectory_id, const int submap_trajectory_id) const {
+  const auto it = num_inter_submap_constraints_.find(
+      std::make_pair(node_trajectory_id, submap_trajectory_id));
+  return it == num_inter_submap_constraints_.end() ? 0 : it->second;
+}
+
+}  // namespace mapping
+}  // namespace cartographer
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CARTOGRAPHER_MAPPING_INTERNAL_POSE_GRAPH_CONSTRAINTS_H_
+#define CARTOGRAPHER_MAPPING_INTERNAL_POSE_GRAPH_CONSTRAINTS_H_
+
+#include <cstddef>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "cartographer/mapping/id.h"
+#include "cartographer/mapping/pose_graph_interface.h"
+
+namespace cartographer {
+namespace mapping {
+
+// The constraints of the pose graph, stored contiguously and indexed by
+// submap, by node and by pair of trajectories. This allows to find and remove
+// the constraints touching a submap or node in time proportional to their
+// number. Removal moves the last constraint into the freed slot, so the order
+// of the constraints is not preserved.
+class PoseGraphConstraints {
+ public:
+  using Constraint = PoseGraphInterface::Constraint;
+  using const_iterator = std::vector<Constraint>::const_iterator;
+
+  PoseGraphConstraints() = default;
+
+  void Add(const Constraint& constraint);
+  void Add(const std::vector<Constraint>& constraints);
+
+  // Removes all constraints to the submaps in 'submap_ids' and from the nodes
+  // in 'node_ids'. Returns the IDs of the submaps not in 'submap_ids' which
+  // lost constraints this way.
+  std::set<SubmapId> Remove(const std::set<SubmapId>& submap_ids,
+                            const std::set<NodeId>& node_ids);
+
+  // The constraints to 'submap_id' and from 'node_id', respectively.
+  std::vector<Constraint> GetSubmapConstraints(const SubmapId& submap_id) const;
+  std::vector<Constraint> GetNodeConstraints(const NodeId& node_id) const;
+
+  // Returns true if a node is connected to 'submap_id' by an INTER_SUBMAP
+  // constraint.
+  bool HasInterSubmapConstraints(const SubmapId& submap_id) const;
+
+  // Returns the number of INTER_SUBMAP constraints from nodes of
+  // 'node_trajectory_id' to submaps of 'submap_trajectory_id'.
+  int NumInterSubmapConstraints(int node_trajectory_id,
+                                int submap_trajectory_id) const;
+
+  // The number of INTER_SUBMAP constraints keyed by the trajectory IDs of the
+  // node and the submap. Pairs without constraints are omitted.
+  const std::map<std::pair<int, int>, int>& num_inter_submap_constraints()
+      const {
+    return num_inter_submap_constraints_;
+  }
+
+  const std::vector<Constraint>& vector() const { return constraints_; }
+  const_iterator begin() const { return constraints_.begin(); }
+  const_iterator end() const { return constraints_.end(); }
+  size_t size() const { return constraints_.size(); }
+  bool empty() const { return constraints_.empty(); }
+
+ private:
+  struct SubmapEntry {
+    std::vector<size_t> indices;
+    int num_inter_submap_constraints = 0;
+  };
+
+  // Removes the constraint at 'index' by moving the last one into its place.
+  void RemoveAt(size_t index);
+
+  std::vector<Constraint> constraints_;
+  // Indices into 'constraints_'.
+  std::map<SubmapId, SubmapEntry> submap_index_;
+  std::map<NodeId, std::vector<size_t>> node_index_;
+  std::map<std::pair<int, int>, int> num_inter_submap_constraints_;
+};
+
+}  // namespace mapping
+}  // namespace cartographer
+
+#endif  // CARTOGRAPHER_MAPPING_INTERNAL_POSE_GRAPH_CONSTRAINTS_H_
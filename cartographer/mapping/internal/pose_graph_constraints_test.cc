@@ -0,0 +1,126 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cartographer/mapping/internal/pose_graph_constraints.h"
+
+#include <random>
+#include <set>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace cartographer {
+namespace mapping {
+namespace {
+
+using Constraint = PoseGraphInterface::Constraint;
+
+Constraint CreateConstraint(const SubmapId& submap_id, const NodeId& node_id,
+                            const Constraint::Tag tag) {
+  return Constraint{submap_id,
+                    node_id,
+                    {transform::Rigid3d::Identity(), 1., 1.},
+                    tag};
+}
+
+int CountConstraints(const std::vector<Constraint>& constraints,
+                     const SubmapId& submap_id) {
+  int count = 0;
+  for (const Constraint& constraint : constraints) {
+    if (constraint.submap_id == submap_id) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+TEST(PoseGraphConstraintsTest, IndexesConstraints) {
+  PoseGraphConstraints constraints;
+  constraints.Add(CreateConstraint({0, 0}, {0, 0}, Constraint::INTRA_SUBMAP));
+  constraints.Add(CreateConstraint({0, 0}, {0, 1}, Constraint::INTRA_SUBMAP));
+  constraints.Add(CreateConstraint({0, 1}, {0, 1}, Constraint::INTRA_SUBMAP));
+  constraints.Add(CreateConstraint({0, 0}, {1, 0}, Constraint::INTER_SUBMAP));
+  ASSERT_EQ(4, constraints.size());
+  EXPECT_EQ(3, constraints.GetSubmapConstraints({0, 0}).size());
+  EXPECT_EQ(2, constraints.GetNodeConstraints({0, 1}).size());
+  EXPECT_TRUE(constraints.HasInterSubmapConstraints({0, 0}));
+  EXPECT_FALSE(constraints.HasInterSubmapConstraints({0, 1}));
+  EXPECT_EQ(1, constraints.NumInterSubmapConstraints(1, 0));
+  EXPECT_EQ(0, constraints.NumInterSubmapConstraints(0, 1));
+
+  const std::set<SubmapId> other_submap_ids =
+      constraints.Remove({SubmapId{0, 1}}, {NodeId{1, 0}});
+  EXPECT_EQ(std::set<SubmapId>({SubmapId{0, 0}}), other_submap_ids);
+  ASSERT_EQ(2, constraints.size());
+  EXPECT_TRUE(constraints.GetSubmapConstraints({0, 1}).empty());
+  EXPECT_EQ(1, constraints.GetNodeConstraints({0, 1}).size());
+  EXPECT_FALSE(constraints.HasInterSubmapConstraints({0, 0}));
+  EXPECT_TRUE(constraints.num_inter_submap_constraints().empty());
+}
+
+TEST(PoseGraphConstraintsTest, RemoveMatchesLinearScan) {
+  std::mt19937 prng(42);
+  std::uniform_int_distribution<int> id_distribution(0, 9);
+  std::uniform_int_distribution<int> tag_distribution(0, 1);
+  PoseGraphConstraints constraints;
+  std::vector<Constraint> expected_constraints;
+  for (int i = 0; i < 500; ++i) {
+    const Constraint constraint = CreateConstraint(
+        {id_distribution(prng) % 3, id_distribution(prng)},
+        {id_distribution(prng) % 3, id_distribution(prng)},
+        tag_distribution(prng) == 0 ? Constraint::INTRA_SUBMAP
+                                    : Constraint::INTER_SUBMAP);
+    constraints.Add(constraint);
+    expected_constraints.push_back(constraint);
+  }
+
+  for (int round = 0; round < 5; ++round) {
+    std::set<SubmapId> submap_ids;
+    std::set<NodeId> node_ids;
+    for (int i = 0; i < 3; ++i) {
+      submap_ids.insert({id_distribution(prng) % 3, id_distribution(prng)});
+      node_ids.insert({id_distribution(prng) % 3, id_distribution(prng)});
+    }
+    constraints.Remove(submap_ids, node_ids);
+    std::vector<Constraint> remaining_constraints;
+    for (const Constraint& constraint : expected_constraints) {
+      if (submap_ids.count(constraint.submap_id) == 0 &&
+          node_ids.count(constraint.node_id) == 0) {
+        remaining_constraints.push_back(constraint);
+      }
+    }
+    expected_constraints = remaining_constraints;
+
+    ASSERT_EQ(expected_constraints.size(), constraints.size());
+    for (int trajectory_id = 0; trajectory_id < 3; ++trajectory_id) {
+      for (int submap_index = 0; submap_index < 10; ++submap_index) {
+        const SubmapId submap_id{trajectory_id, submap_index};
+        EXPECT_EQ(CountConstraints(expected_constraints, submap_id),
+                  CountConstraints(constraints.vector(), submap_id));
+        EXPECT_EQ(CountConstraints(expected_constraints, submap_id),
+                  constraints.GetSubmapConstraints(submap_id).size());
+        for (const Constraint& constraint :
+             constraints.GetSubmapConstraints(submap_id)) {
+          EXPECT_EQ(submap_id, constraint.submap_id);
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+}  // namespace mapping
+}  // namespace cartographer
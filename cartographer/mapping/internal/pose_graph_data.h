@@ -23,6 +23,7 @@
 
 #include "cartographer/mapping/internal/optimization/optimization_problem_2d.h"
 #include "cartographer/mapping/internal/optimization/optimization_problem_3d.h"
+#include "cartographer/mapping/internal/pose_graph_constraints.h"
 #include "cartographer/mapping/internal/trajectory_connectivity_state.h"
 #include "cartographer/mapping/pose_graph.h"
 #include "cartographer/mapping/pose_graph_interface.h"
@@ -83,7 +84,7 @@ struct PoseGraphData {
   // Set of all initial trajectory poses.
   std::map<int, PoseGraph::InitialTrajectoryPose> initial_trajectory_poses;
 
-  std::vector<PoseGraphInterface::Constraint> constraints;
+  PoseGraphConstraints constraints;
 };
 
 }  // namespace mapping
@@ -16,8 +16,12 @@ CreateRealTimeCorrelativeScanMatcherOptions(
       parameter_dictionary->GetDouble("translation_delta_cost_weight"));
   options.set_rotation_delta_cost_weight(
       parameter_dictionary->GetDouble("rotation_delta_cost_weight"));
+  options.set_batched_evaluation_3d(
+      parameter_dictionary->GetBool("batched_evaluation_3d"));
+  options.set_num_threads_3d(parameter_dictionary->GetInt("num_threads_3d"));
   CHECK_GE(options.translation_delta_cost_weight(), 0.);
   CHECK_GE(options.rotation_delta_cost_weight(), 0.);
+  CHECK_GT(options.num_threads_3d(), 0);
   return options;
 }
 
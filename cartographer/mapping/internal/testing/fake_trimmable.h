@@ -94,6 +94,12 @@ class FakeTrimmable : public Trimmable {
     trimmed_submaps_.push_back(submap_id);
   }
 
+  void TrimSubmaps(const std::vector<SubmapId>& submap_ids) override {
+    ++num_trim_submaps_calls_;
+    trimmed_submaps_.insert(trimmed_submaps_.end(), submap_ids.begin(),
+                            submap_ids.end());
+  }
+
   bool IsFinished(const int trajectory_id) const override { return false; }
 
   void SetTrajectoryState(
@@ -102,8 +108,11 @@ class FakeTrimmable : public Trimmable {
 
   std::vector<SubmapId> trimmed_submaps() { return trimmed_submaps_; }
 
+  int num_trim_submaps_calls() const { return num_trim_submaps_calls_; }
+
  private:
   std::vector<SubmapId> trimmed_submaps_;
+  int num_trim_submaps_calls_ = 0;
 
   std::vector<PoseGraphInterface::Constraint> constraints_;
   MapById<NodeId, TrajectoryNode> trajectory_nodes_;
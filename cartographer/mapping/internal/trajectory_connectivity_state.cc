@@ -16,23 +16,30 @@
 
 #include "cartographer/mapping/internal/trajectory_connectivity_state.h"
 
+#include <algorithm>
+
+#include "glog/logging.h"
+
 namespace cartographer {
 namespace mapping {
 
 void TrajectoryConnectivityState::Add(const int trajectory_id) {
+  Reserve(trajectory_id);
   connected_components_.Add(trajectory_id);
 }
 
 void TrajectoryConnectivityState::Connect(const int trajectory_id_a,
                                           const int trajectory_id_b,
                                           const common::Time time) {
+  // Both branches below store connection times of 'trajectory_id_a' and
+  // 'trajectory_id_b', which may not have been tracked before.
+  Reserve(std::max(trajectory_id_a, trajectory_id_b));
   if (TransitivelyConnected(trajectory_id_a, trajectory_id_b)) {
     // The trajectories are transitively connected, i.e. they belong to the same
     // connected component. In this case we only update the last connection time
     // of those two trajectories.
-    auto sorted_pair = std::minmax(trajectory_id_a, trajectory_id_b);
-    if (last_connection_time_map_[sorted_pair] < time) {
-      last_connection_time_map_[sorted_pair] = time;
+    if (LastConnectionTime(trajectory_id_a, trajectory_id_b) < time) {
+      SetLastConnectionTime(trajectory_id_a, trajectory_id_b, time);
     }
   } else {
     // The connection between these two trajectories is about to join to
@@ -40,14 +47,15 @@ void TrajectoryConnectivityState::Connect(const int trajectory_id_a,
     // the two connected components with the connection time. This is to quickly
     // change to a more efficient loop closure search (by constraining the
     // search window) when connected components are joined.
-    std::vector<int> component_a =
+    connected_components_.Add(trajectory_id_a);
+    connected_components_.Add(trajectory_id_b);
+    const std::vector<int> component_a =
         connected_components_.GetComponent(trajectory_id_a);
-    std::vector<int> component_b =
+    const std::vector<int> component_b =
         connected_components_.GetComponent(trajectory_id_b);
     for (const auto id_a : component_a) {
       for (const auto id_b : component_b) {
-        auto id_pair = std::minmax(id_a, id_b);
-        last_connection_time_map_[id_pair] = time;
+        SetLastConnectionTime(id_a, id_b, time);
       }
     }
   }
@@ -65,9 +73,42 @@ std::vector<std::vector<int>> TrajectoryConnectivityState::Components() const {
 }
 
 common::Time TrajectoryConnectivityState::LastConnectionTime(
-    const int trajectory_id_a, const int trajectory_id_b) {
-  const auto sorted_pair = std::minmax(trajectory_id_a, trajectory_id_b);
-  return last_connection_time_map_[sorted_pair];
+    const int trajectory_id_a, const int trajectory_id_b) const {
+  if (trajectory_id_a < 0 || trajectory_id_a >= num_trajectories_ ||
+      trajectory_id_b < 0 || trajectory_id_b >= num_trajectories_) {
+    return common::Time();
+  }
+  return last_connection_times_[trajectory_id_a * num_trajectories_ +
+                                trajectory_id_b];
+}
+
+void TrajectoryConnectivityState::Reserve(const int trajectory_id) {
+  CHECK_GE(trajectory_id, 0);
+  if (trajectory_id < num_trajectories_) {
+    return;
+  }
+  // Grow geometrically, so that adding trajectories one by one takes
+  // amortized time linear in the size of the matrix.
+  const int new_num_trajectories =
+      std::max(trajectory_id + 1, 2 * num_trajectories_);
+  std::vector<common::Time> new_last_connection_times(
+      new_num_trajectories * new_num_trajectories);
+  for (int a = 0; a < num_trajectories_; ++a) {
+    std::copy_n(last_connection_times_.begin() + a * num_trajectories_,
+                num_trajectories_,
+                new_last_connection_times.begin() + a * new_num_trajectories);
+  }
+  num_trajectories_ = new_num_trajectories;
+  last_connection_times_ = std::move(new_last_connection_times);
+}
+
+void TrajectoryConnectivityState::SetLastConnectionTime(
+    const int trajectory_id_a, const int trajectory_id_b,
+    const common::Time time) {
+  last_connection_times_[trajectory_id_a * num_trajectories_ +
+                         trajectory_id_b] = time;
+  last_connection_times_[trajectory_id_b * num_trajectories_ +
+                         trajectory_id_a] = time;
 }
 
 }  // namespace mapping
@@ -17,6 +17,8 @@
 #ifndef CARTOGRAPHER_MAPPING_INTERNAL_TRAJECTORY_CONNECTIVITY_STATE_H_
 #define CARTOGRAPHER_MAPPING_INTERNAL_TRAJECTORY_CONNECTIVITY_STATE_H_
 
+#include <vector>
+
 #include "cartographer/common/time.h"
 #include "cartographer/mapping/internal/connected_components.h"
 
@@ -56,19 +58,29 @@ class TrajectoryConnectivityState {
 
   // Return the last connection count between the two trajectories. If either of
   // the trajectories is untracked or they have never been connected returns the
-  // beginning of time.
-  common::Time LastConnectionTime(int trajectory_id_a, int trajectory_id_b);
+  // beginning of time. Takes constant time.
+  common::Time LastConnectionTime(int trajectory_id_a,
+                                  int trajectory_id_b) const;
 
  private:
+  // Grows 'last_connection_times_' to hold 'trajectory_id'.
+  void Reserve(int trajectory_id);
+  void SetLastConnectionTime(int trajectory_id_a, int trajectory_id_b,
+                             common::Time time);
+
   // ConnectedComponents are thread safe.
-  mutable ConnectedComponents connected_components_;
+  ConnectedComponents connected_components_;
 
   // Tracks the last time a direct connection between two trajectories has
   // been added. The exception is when a connection between two trajectories
   // connects two formerly unconnected connected components. In this case all
   // bipartite trajectories entries for these components are updated with the
   // new connection time.
-  std::map<std::pair<int, int>, common::Time> last_connection_time_map_;
+  //
+  // Trajectory IDs are small and dense, so this is stored as a symmetric
+  // 'num_trajectories_' x 'num_trajectories_' row-major matrix.
+  int num_trajectories_ = 0;
+  std::vector<common::Time> last_connection_times_;
 };
 
 }  // namespace mapping
@@ -87,5 +87,17 @@ TEST(TrajectoryConnectivityStateTest, JoinTwoComponents) {
   EXPECT_EQ(state.LastConnectionTime(0, 1), common::FromUniversal(123456));
 }
 
+TEST(TrajectoryConnectivityStateTest, ConnectUntrackedTrajectoryToItself) {
+  TrajectoryConnectivityState state;
+  state.Add(0);
+  // An untracked trajectory is transitively connected to itself, so this
+  // only stores the connection time, beyond the tracked trajectories.
+  state.Connect(5, 5, common::FromUniversal(123456));
+  EXPECT_TRUE(state.TransitivelyConnected(5, 5));
+  EXPECT_EQ(state.LastConnectionTime(5, 5), common::FromUniversal(123456));
+  EXPECT_EQ(state.LastConnectionTime(0, 5), common::Time());
+  EXPECT_FALSE(state.TransitivelyConnected(0, 5));
+}
+
 }  // namespace mapping
 }  // namespace cartographer
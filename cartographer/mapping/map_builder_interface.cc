@@ -16,6 +16,7 @@
 
 #include "cartographer/mapping/map_builder_interface.h"
 
+#include "cartographer/common/configuration_cache.h"
 #include "cartographer/mapping/pose_graph.h"
 
 namespace cartographer {
@@ -39,5 +40,25 @@ proto::MapBuilderOptions CreateMapBuilderOptions(
   return options;
 }
 
+proto::CompiledConfiguration CreateCompiledConfiguration(
+    common::LuaParameterDictionary* const parameter_dictionary) {
+  proto::CompiledConfiguration configuration;
+  *configuration.mutable_map_builder_options() = CreateMapBuilderOptions(
+      parameter_dictionary->GetDictionary("map_builder").get());
+  *configuration.mutable_trajectory_builder_options() =
+      CreateTrajectoryBuilderOptions(
+          parameter_dictionary->GetDictionary("trajectory_builder").get());
+  return configuration;
+}
+
+proto::CompiledConfiguration LoadCompiledConfiguration(
+    const std::vector<std::string>& configuration_directories,
+    const std::string& configuration_basename,
+    const std::string& cache_filename) {
+  return common::LoadOptionsWithCache<proto::CompiledConfiguration>(
+      configuration_directories, configuration_basename, cache_filename,
+      CreateCompiledConfiguration);
+}
+
 }  // namespace mapping
 }  // namespace cartographer
@@ -27,6 +27,7 @@
 #include "cartographer/io/proto_stream_interface.h"
 #include "cartographer/mapping/id.h"
 #include "cartographer/mapping/pose_graph_interface.h"
+#include "cartographer/mapping/proto/compiled_configuration.pb.h"
 #include "cartographer/mapping/proto/map_builder_options.pb.h"
 #include "cartographer/mapping/proto/submap_visualization.pb.h"
 #include "cartographer/mapping/proto/trajectory_builder_options.pb.h"
@@ -39,6 +40,21 @@ namespace mapping {
 proto::MapBuilderOptions CreateMapBuilderOptions(
     common::LuaParameterDictionary* const parameter_dictionary);
 
+// Creates the options from the 'map_builder' and 'trajectory_builder' entries
+// of 'parameter_dictionary', which must not have any other entries if it is
+// reference counted.
+proto::CompiledConfiguration CreateCompiledConfiguration(
+    common::LuaParameterDictionary* const parameter_dictionary);
+
+// Like 'CreateCompiledConfiguration' for the Lua file 'configuration_basename'.
+// The result is cached in 'cache_filename' and reused without running Lua for
+// as long as none of the Lua files it was compiled from changed, which saves
+// most of the startup time of short-lived tools.
+proto::CompiledConfiguration LoadCompiledConfiguration(
+    const std::vector<std::string>& configuration_directories,
+    const std::string& configuration_basename,
+    const std::string& cache_filename);
+
 // This interface is used for both library and RPC implementations.
 // Implementations wire up the complete SLAM stack.
 class MapBuilderInterface {
@@ -110,6 +110,12 @@ proto::PoseGraphOptions CreatePoseGraphOptions(
   options.set_global_constraint_search_after_n_seconds(
       parameter_dictionary->GetDouble(
           "global_constraint_search_after_n_seconds"));
+  options.set_local_optimization_window_num_submaps(
+      parameter_dictionary->GetNonNegativeInt(
+          "local_optimization_window_num_submaps"));
+  options.set_global_constraint_search_num_submaps(
+      parameter_dictionary->GetNonNegativeInt(
+          "global_constraint_search_num_submaps"));
   PopulateOverlappingSubmapsTrimmerOptions2D(&options, parameter_dictionary);
   return options;
 }
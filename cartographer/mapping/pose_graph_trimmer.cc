@@ -33,8 +33,10 @@ void PureLocalizationTrimmer::Trim(Trimmable* const pose_graph) {
   }
 
   auto submap_ids = pose_graph->GetSubmapIds(trajectory_id_);
-  for (std::size_t i = 0; i + num_submaps_to_keep_ < submap_ids.size(); ++i) {
-    pose_graph->TrimSubmap(submap_ids.at(i));
+  if (submap_ids.size() > static_cast<size_t>(num_submaps_to_keep_)) {
+    submap_ids.erase(submap_ids.end() - num_submaps_to_keep_,
+                     submap_ids.end());
+    pose_graph->TrimSubmaps(submap_ids);
   }
 
   if (num_submaps_to_keep_ == 0) {
@@ -17,6 +17,8 @@
 #ifndef CARTOGRAPHER_MAPPING_POSE_GRAPH_TRIMMER_H_
 #define CARTOGRAPHER_MAPPING_POSE_GRAPH_TRIMMER_H_
 
+#include <vector>
+
 #include "cartographer/mapping/id.h"
 #include "cartographer/mapping/pose_graph_interface.h"
 
@@ -44,6 +46,11 @@ class Trimmable {
   // The numbering remains unchanged.
   virtual void TrimSubmap(const SubmapId& submap_id) = 0;
 
+  // Same as calling 'TrimSubmap' for each of 'submap_ids', but the constraints
+  // and nodes are only visited once for all of them. Prefer this when trimming
+  // more than one submap at a time.
+  virtual void TrimSubmaps(const std::vector<SubmapId>& submap_ids) = 0;
+
   // Checks if the given trajectory is finished or not.
   virtual bool IsFinished(int trajectory_id) const = 0;
 
@@ -38,6 +38,19 @@ TEST(PureLocalizationTrimmerTest, MarksSubmapsAsExpected) {
   EXPECT_EQ((SubmapId{kTrajectoryId, 1}), trimmed_submaps[1]);
 }
 
+TEST(PureLocalizationTrimmerTest, TrimsAllSubmapsInOneCall) {
+  const int kTrajectoryId = 7;
+  PureLocalizationTrimmer trimmer(kTrajectoryId, 3);
+  testing::FakeTrimmable fake_pose_graph(kTrajectoryId, 40);
+  trimmer.Trim(&fake_pose_graph);
+  EXPECT_EQ(1, fake_pose_graph.num_trim_submaps_calls());
+  const auto trimmed_submaps = fake_pose_graph.trimmed_submaps();
+  ASSERT_EQ(37, trimmed_submaps.size());
+  for (int i = 0; i < 37; ++i) {
+    EXPECT_EQ((SubmapId{kTrajectoryId, i}), trimmed_submaps[i]);
+  }
+}
+
 }  // namespace
 }  // namespace mapping
 }  // namespace cartographer
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cartographer/metrics/sharded_cell.h"
+
+#include <algorithm>
+
+#include "glog/logging.h"
+
+namespace cartographer {
+namespace metrics {
+
+int GetThreadShardIndex() {
+  static std::atomic<int> next_shard_index(0);
+  thread_local const int shard_index =
+      next_shard_index.fetch_add(1, std::memory_order_relaxed) % kNumShards;
+  return shard_index;
+}
+
+ShardedDoubleCell::ShardedDoubleCell() {
+  for (Shard& shard : shards_) {
+    shard.value.store(0., std::memory_order_relaxed);
+  }
+}
+
+namespace {
+
+// std::atomic<double> has no 'fetch_add' before C++20.
+void AtomicAdd(const double value, std::atomic<double>* const target) {
+  double current = target->load(std::memory_order_relaxed);
+  while (!target->compare_exchange_weak(current, current + value,
+                                        std::memory_order_relaxed)) {
+  }
+}
+
+}  // namespace
+
+void ShardedDoubleCell::Add(const double value) {
+  // Only the calling thread and threads assigned the same shard write this
+  // shard, so this practically never contends.
+  AtomicAdd(value, &shards_[GetThreadShardIndex()].value);
+}
+
+double ShardedDoubleCell::Value() const {
+  double result = 0.;
+  for (const Shard& shard : shards_) {
+    result += shard.value.load(std::memory_order_relaxed);
+  }
+  return result;
+}
+
+void AtomicDoubleCell::Add(const double value) { AtomicAdd(value, &value_); }
+
+ShardedHistogramCell::ShardedHistogramCell(
+    const Histogram::BucketBoundaries& bucket_boundaries)
+    : bucket_boundaries_(bucket_boundaries),
+      shard_stride_([&bucket_boundaries]() {
+        constexpr size_t kCountersPerCacheLine =
+            kCacheLineSize / sizeof(std::atomic<uint64>);
+        const size_t num_buckets = bucket_boundaries.size() + 1;
+        return (num_buckets + kCountersPerCacheLine - 1) /
+               kCountersPerCacheLine * kCountersPerCacheLine;
+      }()),
+      bucket_counts_(new std::atomic<uint64>[kNumShards * shard_stride_]) {
+  CHECK(std::is_sorted(bucket_boundaries_.begin(), bucket_boundaries_.end()));
+  for (size_t i = 0; i < kNumShards * shard_stride_; ++i) {
+    bucket_counts_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+void ShardedHistogramCell::Observe(const double value) {
+  // Same bucket semantics as Prometheus: the upper boundary is inclusive.
+  const size_t bucket_index =
+      std::lower_bound(bucket_boundaries_.begin(), bucket_boundaries_.end(),
+                       value) -
+      bucket_boundaries_.begin();
+  bucket_counts_[GetThreadShardIndex() * shard_stride_ + bucket_index]
+      .fetch_add(1, std::memory_order_relaxed);
+  sum_.Add(value);
+}
+
+ShardedHistogramCell::Snapshot ShardedHistogramCell::Collect() const {
+  Snapshot snapshot;
+  snapshot.bucket_counts.resize(bucket_boundaries_.size() + 1, 0);
+  for (int shard = 0; shard < kNumShards; ++shard) {
+    for (size_t i = 0; i < snapshot.bucket_counts.size(); ++i) {
+      snapshot.bucket_counts[i] += bucket_counts_[shard * shard_stride_ + i]
+                                       .load(std::memory_order_relaxed);
+    }
+  }
+  for (const uint64 count : snapshot.bucket_counts) {
+    snapshot.sample_count += count;
+  }
+  snapshot.sample_sum = sum_.Value();
+  return snapshot;
+}
+
+}  // namespace metrics
+}  // namespace cartographer
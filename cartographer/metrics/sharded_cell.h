@@ -0,0 +1,122 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CARTOGRAPHER_METRICS_SHARDED_CELL_H_
+#define CARTOGRAPHER_METRICS_SHARDED_CELL_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "cartographer/common/port.h"
+#include "cartographer/metrics/histogram.h"
+
+namespace cartographer {
+namespace metrics {
+
+// Number of shards each cell is split into. Threads are assigned to shards
+// round-robin, so up to this many threads update a cell without contending.
+constexpr int kNumShards = 16;
+constexpr size_t kCacheLineSize = 64;
+
+// Returns the shard assigned to the calling thread, in [0, kNumShards).
+int GetThreadShardIndex();
+
+// A double-valued cell for metrics on hot paths. Updates only touch the
+// calling thread's shard with relaxed atomics and never take a lock. Reading
+// the value sums over all shards and is meant to happen lazily, e.g. when the
+// metrics are scraped.
+class ShardedDoubleCell {
+ public:
+  ShardedDoubleCell();
+
+  ShardedDoubleCell(const ShardedDoubleCell&) = delete;
+  ShardedDoubleCell& operator=(const ShardedDoubleCell&) = delete;
+
+  void Add(double value);
+
+  // Returns the sum of all values added since construction.
+  double Value() const;
+
+ private:
+  // Padded so that shards of the same cell do not share a cache line.
+  struct Shard {
+    std::atomic<double> value;
+    char padding[kCacheLineSize - sizeof(std::atomic<double>)];
+  };
+
+  std::array<Shard, kNumShards> shards_;
+};
+
+// A double-valued cell which, unlike ShardedDoubleCell, can be overwritten.
+// All updates go to a single atomic, so concurrent calls to 'Add' and 'Set'
+// are linearizable.
+class AtomicDoubleCell {
+ public:
+  AtomicDoubleCell() : value_(0.) {}
+
+  AtomicDoubleCell(const AtomicDoubleCell&) = delete;
+  AtomicDoubleCell& operator=(const AtomicDoubleCell&) = delete;
+
+  void Add(double value);
+  void Set(double value) { value_.store(value, std::memory_order_relaxed); }
+  double Value() const { return value_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<double> value_;
+};
+
+// Sharded bucket counts and sum of a histogram, see ShardedDoubleCell.
+class ShardedHistogramCell {
+ public:
+  struct Snapshot {
+    // Non-cumulative count per bucket. The last bucket holds all values
+    // larger than the last boundary.
+    std::vector<uint64> bucket_counts;
+    uint64 sample_count = 0;
+    double sample_sum = 0.;
+  };
+
+  explicit ShardedHistogramCell(
+      const Histogram::BucketBoundaries& bucket_boundaries);
+
+  ShardedHistogramCell(const ShardedHistogramCell&) = delete;
+  ShardedHistogramCell& operator=(const ShardedHistogramCell&) = delete;
+
+  void Observe(double value);
+
+  // Aggregates all shards.
+  Snapshot Collect() const;
+
+  const Histogram::BucketBoundaries& bucket_boundaries() const {
+    return bucket_boundaries_;
+  }
+
+ private:
+  const Histogram::BucketBoundaries bucket_boundaries_;
+  // Number of counters per shard, rounded up to whole cache lines.
+  const size_t shard_stride_;
+  // 'kNumShards' blocks of 'shard_stride_' bucket counters each.
+  std::unique_ptr<std::atomic<uint64>[]> bucket_counts_;
+  ShardedDoubleCell sum_;
+};
+
+}  // namespace metrics
+}  // namespace cartographer
+
+#endif  // CARTOGRAPHER_METRICS_SHARDED_CELL_H_
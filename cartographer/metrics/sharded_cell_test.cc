@@ -0,0 +1,105 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cartographer/metrics/sharded_cell.h"
+
+#include <thread>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace cartographer {
+namespace metrics {
+namespace {
+
+constexpr int kNumThreads = 2 * kNumShards + 1;
+constexpr int kNumUpdatesPerThread = 1000;
+
+TEST(ShardedCellTest, DoubleCellAggregatesAllThreads) {
+  ShardedDoubleCell cell;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([&cell]() {
+      for (int j = 0; j < kNumUpdatesPerThread; ++j) {
+        cell.Add(1.);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(cell.Value(), kNumThreads * kNumUpdatesPerThread);
+}
+
+TEST(ShardedCellTest, AtomicDoubleCellSetIsNotMixedWithOtherUpdates) {
+  AtomicDoubleCell cell;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([&cell, i]() {
+      for (int j = 0; j < kNumUpdatesPerThread; ++j) {
+        cell.Set(i);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  // Concurrent calls to 'Set' leave one of the values, never their sum.
+  EXPECT_GE(cell.Value(), 0.);
+  EXPECT_LT(cell.Value(), kNumThreads);
+  cell.Set(-3.);
+  EXPECT_EQ(cell.Value(), -3.);
+
+  threads.clear();
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([&cell]() {
+      for (int j = 0; j < kNumUpdatesPerThread; ++j) {
+        cell.Add(1.);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(cell.Value(), kNumThreads * kNumUpdatesPerThread - 3.);
+}
+
+TEST(ShardedCellTest, HistogramCellAggregatesAllThreads) {
+  ShardedHistogramCell cell(Histogram::FixedWidth(1., 3));
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([&cell]() {
+      for (int j = 0; j < kNumUpdatesPerThread; ++j) {
+        cell.Observe(j % 5);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  const ShardedHistogramCell::Snapshot snapshot = cell.Collect();
+  const uint64 n = kNumThreads * kNumUpdatesPerThread / 5;
+  // Boundaries are 1, 2 and 3; values 3 and 4 fall into the last two buckets.
+  EXPECT_THAT(snapshot.bucket_counts,
+              ::testing::ElementsAre(2 * n, n, n, n));
+  EXPECT_EQ(snapshot.sample_count, 5 * n);
+  EXPECT_EQ(snapshot.sample_sum, n * (0 + 1 + 2 + 3 + 4));
+}
+
+}  // namespace
+}  // namespace metrics
+}  // namespace cartographer
@@ -21,6 +21,7 @@
 #include <iterator>
 #include <map>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "cartographer/common/port.h"
@@ -96,6 +97,44 @@ class MapByTime {
     }
   }
 
+  // Removes the data of 'trajectory_id' before the last data preceding 'time'.
+  // Interpolation at 'time' or later is still possible afterwards. Returns the
+  // number of removed data.
+  size_t TrimBefore(const int trajectory_id, const common::Time time) {
+    const auto trajectory_it = data_.find(trajectory_id);
+    if (trajectory_it == data_.end()) {
+      return 0;
+    }
+    auto& trajectory = trajectory_it->second;
+    auto data_end = trajectory.lower_bound(time);
+    if (data_end == trajectory.begin()) {
+      return 0;
+    }
+    // Retain the last data before 'time'.
+    data_end = std::prev(data_end);
+    const size_t num_removed = std::distance(trajectory.begin(), data_end);
+    trajectory.erase(trajectory.begin(), data_end);
+    return num_removed;
+  }
+
+  // Removes all data of 'trajectory_id'. Returns the number of removed data.
+  size_t EraseTrajectory(const int trajectory_id) {
+    const auto trajectory_it = data_.find(trajectory_id);
+    if (trajectory_it == data_.end()) {
+      return 0;
+    }
+    const size_t num_removed = trajectory_it->second.size();
+    data_.erase(trajectory_it);
+    return num_removed;
+  }
+
+  // Approximate memory used to store one data, including the overhead of
+  // the tree node holding it.
+  static constexpr size_t ApproximateBytesPerData() {
+    return sizeof(std::pair<const common::Time, DataType>) +
+           4 * sizeof(void*);
+  }
+
   bool HasTrajectory(const int trajectory_id) const {
     return data_.count(trajectory_id) != 0;
   }
@@ -97,6 +97,30 @@ TEST(MapByTimeTest, TrimmingDoesNotCreateTrajectory) {
   EXPECT_FALSE(map_by_time.HasTrajectory(42));
 }
 
+TEST(MapByTimeTest, TrimBeforeAndEraseTrajectory) {
+  MapByTime<Data> map_by_time;
+  EXPECT_EQ(0, map_by_time.TrimBefore(42, CreateTime(10)));
+  for (const int milliseconds : {1, 5, 9, 10, 11}) {
+    map_by_time.Append(42, Data{CreateTime(milliseconds)});
+  }
+  map_by_time.Append(7, Data{CreateTime(3)});
+  EXPECT_EQ(0, map_by_time.TrimBefore(42, CreateTime(1)));
+  // The data at 9 is kept to allow interpolation at 10.
+  EXPECT_EQ(2, map_by_time.TrimBefore(42, CreateTime(10)));
+  std::deque<Data> expected_data = {Data{CreateTime(9)}, Data{CreateTime(10)},
+                                    Data{CreateTime(11)}};
+  for (const Data& data : map_by_time.trajectory(42)) {
+    ASSERT_FALSE(expected_data.empty());
+    EXPECT_EQ(expected_data.front().time, data.time);
+    expected_data.pop_front();
+  }
+  EXPECT_TRUE(expected_data.empty());
+  EXPECT_EQ(3, map_by_time.EraseTrajectory(42));
+  EXPECT_FALSE(map_by_time.HasTrajectory(42));
+  EXPECT_EQ(0, map_by_time.EraseTrajectory(42));
+  EXPECT_TRUE(map_by_time.HasTrajectory(7));
+}
+
 }  // namespace
 }  // namespace sensor
 }  // namespace cartographer
@@ -0,0 +1,192 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cartographer/sensor/packed_point_cloud.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string>
+
+#include "cartographer/common/port.h"
+
+namespace cartographer {
+namespace sensor {
+namespace {
+
+// Values are written byte by byte so that the encoding is little-endian
+// independent of the host. Compilers turn this into plain loads and stores on
+// little-endian hosts.
+void WriteUint32(const uint32 value, char** out) {
+  for (int i = 0; i != 4; ++i) {
+    (*out)[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+  }
+  *out += 4;
+}
+
+uint32 ReadUint32(const char** in) {
+  uint32 value = 0;
+  for (int i = 0; i != 4; ++i) {
+    value |= static_cast<uint32>(static_cast<unsigned char>((*in)[i]))
+             << (8 * i);
+  }
+  *in += 4;
+  return value;
+}
+
+void WriteFloat(const float value, char** out) {
+  uint32 bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  WriteUint32(bits, out);
+}
+
+float ReadFloat(const char** in) {
+  const uint32 bits = ReadUint32(in);
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+void WriteInt16(const int16 value, char** out) {
+  const uint16 bits = static_cast<uint16>(value);
+  (*out)[0] = static_cast<char>(bits & 0xff);
+  (*out)[1] = static_cast<char>(bits >> 8);
+  *out += 2;
+}
+
+int16 ReadInt16(const char** in) {
+  const uint16 bits = static_cast<uint16>(
+      static_cast<unsigned char>((*in)[0]) |
+      (static_cast<unsigned char>((*in)[1]) << 8));
+  *in += 2;
+  return static_cast<int16>(bits);
+}
+
+float GetTime(const RangefinderPoint&) { return 0.f; }
+float GetTime(const TimedRangefinderPoint& point) { return point.time; }
+
+template <typename PointType>
+bool FitsIntoInt16(const std::vector<PointType>& points,
+                   const float resolution) {
+  const float limit = std::numeric_limits<int16>::max();
+  for (const PointType& point : points) {
+    for (int i = 0; i != 3; ++i) {
+      if (!(std::abs(std::round(point.position[i] / resolution)) <= limit)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+template <typename PointType>
+proto::PackedPointCloud Pack(const std::vector<PointType>& points,
+                             const bool has_time, float resolution) {
+  if (resolution > 0.f && !FitsIntoInt16(points, resolution)) {
+    resolution = 0.f;
+  }
+  const bool quantized = resolution > 0.f;
+  const size_t bytes_per_point = (quantized ? 6 : 12) + (has_time ? 4 : 0);
+
+  proto::PackedPointCloud proto;
+  proto.set_num_points(points.size());
+  proto.set_resolution(resolution);
+  proto.set_has_time(has_time);
+  std::string* const data = proto.mutable_data();
+  data->resize(points.size() * bytes_per_point);
+  char* out = &(*data)[0];
+  for (const PointType& point : points) {
+    for (int i = 0; i != 3; ++i) {
+      if (quantized) {
+        WriteInt16(
+            static_cast<int16>(std::lround(point.position[i] / resolution)),
+            &out);
+      } else {
+        WriteFloat(point.position[i], &out);
+      }
+    }
+    if (has_time) {
+      WriteFloat(GetTime(point), &out);
+    }
+  }
+  return proto;
+}
+
+void AppendPoint(const Eigen::Vector3f& position, float,
+                 std::vector<RangefinderPoint>* const points) {
+  points->push_back({position});
+}
+
+void AppendPoint(const Eigen::Vector3f& position, const float time,
+                 std::vector<TimedRangefinderPoint>* const points) {
+  points->push_back({position, time});
+}
+
+// Appends the points in 'proto' to 'points'. Times are zero if 'proto' has no
+// times. Returns false without touching 'points' if 'proto' is malformed.
+template <typename PointType>
+bool Unpack(const proto::PackedPointCloud& proto,
+            std::vector<PointType>* const points) {
+  if (proto.num_points() < 0 || !std::isfinite(proto.resolution()) ||
+      proto.resolution() < 0.f) {
+    return false;
+  }
+  const bool quantized = proto.resolution() > 0.f;
+  const uint64 bytes_per_point =
+      (quantized ? 6 : 12) + (proto.has_time() ? 4 : 0);
+  if (proto.data().size() !=
+      static_cast<uint64>(proto.num_points()) * bytes_per_point) {
+    return false;
+  }
+  points->reserve(points->size() + proto.num_points());
+  const char* in = proto.data().data();
+  for (int index = 0; index != proto.num_points(); ++index) {
+    Eigen::Vector3f position;
+    for (int i = 0; i != 3; ++i) {
+      position[i] = quantized ? ReadInt16(&in) * proto.resolution()
+                              : ReadFloat(&in);
+    }
+    AppendPoint(position, proto.has_time() ? ReadFloat(&in) : 0.f, points);
+  }
+  return true;
+}
+
+}  // namespace
+
+proto::PackedPointCloud PackPoints(const std::vector<RangefinderPoint>& points,
+                                   const float resolution) {
+  return Pack(points, false /* has_time */, resolution);
+}
+
+proto::PackedPointCloud PackPoints(
+    const std::vector<TimedRangefinderPoint>& points, const float resolution) {
+  return Pack(points, true /* has_time */, resolution);
+}
+
+bool UnpackPoints(const proto::PackedPointCloud& proto,
+                  std::vector<RangefinderPoint>* const points) {
+  points->clear();
+  return Unpack(proto, points);
+}
+
+bool UnpackTimedPoints(const proto::PackedPointCloud& proto,
+                       std::vector<TimedRangefinderPoint>* const points) {
+  points->clear();
+  return proto.has_time() && Unpack(proto, points);
+}
+
+}  // namespace sensor
+}  // namespace cartographer
@@ -0,0 +1,48 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CARTOGRAPHER_SENSOR_PACKED_POINT_CLOUD_H_
+#define CARTOGRAPHER_SENSOR_PACKED_POINT_CLOUD_H_
+
+#include <vector>
+
+#include "cartographer/sensor/proto/sensor.pb.h"
+#include "cartographer/sensor/rangefinder_point.h"
+
+namespace cartographer {
+namespace sensor {
+
+// Packs 'points' into a proto::PackedPointCloud. If 'resolution' is positive,
+// positions are quantized to multiples of it, unless a coordinate does not fit
+// into 16 bits at that resolution, in which case 32-bit floats are used.
+proto::PackedPointCloud PackPoints(const std::vector<RangefinderPoint>& points,
+                                   float resolution);
+proto::PackedPointCloud PackPoints(
+    const std::vector<TimedRangefinderPoint>& points, float resolution);
+
+// Unpacks 'proto' into 'points'. Times are dropped by UnpackPoints(), and
+// UnpackTimedPoints() requires them to be present. Since 'proto' may come from
+// a remote peer, malformed data is not trusted: false is returned and 'points'
+// is left empty.
+bool UnpackPoints(const proto::PackedPointCloud& proto,
+                  std::vector<RangefinderPoint>* points);
+bool UnpackTimedPoints(const proto::PackedPointCloud& proto,
+                       std::vector<TimedRangefinderPoint>* points);
+
+}  // namespace sensor
+}  // namespace cartographer
+
+#endif  // CARTOGRAPHER_SENSOR_PACKED_POINT_CLOUD_H_
@@ -0,0 +1,147 @@
+/*
+ * Copyright 2018 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cartographer/sensor/packed_point_cloud.h"
+
+#include <vector>
+
+#include "cartographer/sensor/timed_point_cloud_data.h"
+#include "gtest/gtest.h"
+
+namespace cartographer {
+namespace sensor {
+namespace {
+
+std::vector<TimedRangefinderPoint> CreateTimedPoints() {
+  return {{Eigen::Vector3f(0.f, 1.f, 2.f), -0.1f},
+          {Eigen::Vector3f(-3.25f, 4.5f, 1e-3f), -0.05f},
+          {Eigen::Vector3f(120.f, -80.f, 7.125f), 0.f}};
+}
+
+TEST(PackedPointCloudTest, RoundTripsExactly) {
+  const std::vector<TimedRangefinderPoint> points = CreateTimedPoints();
+  const proto::PackedPointCloud proto = PackPoints(points, 0.f);
+  EXPECT_EQ(points.size() * 16, proto.data().size());
+  std::vector<TimedRangefinderPoint> unpacked;
+  ASSERT_TRUE(UnpackTimedPoints(proto, &unpacked));
+  EXPECT_EQ(points, unpacked);
+
+  std::vector<RangefinderPoint> untimed_points;
+  for (const TimedRangefinderPoint& point : points) {
+    untimed_points.push_back({point.position});
+  }
+  std::vector<RangefinderPoint> unpacked_untimed;
+  ASSERT_TRUE(UnpackPoints(proto, &unpacked_untimed));
+  EXPECT_EQ(untimed_points, unpacked_untimed);
+  ASSERT_TRUE(
+      UnpackPoints(PackPoints(untimed_points, 0.f), &unpacked_untimed));
+  EXPECT_EQ(untimed_points, unpacked_untimed);
+}
+
+TEST(PackedPointCloudTest, IsLittleEndian) {
+  const std::vector<RangefinderPoint> points{{Eigen::Vector3f(1.f, 0.f, 0.f)}};
+  const proto::PackedPointCloud proto = PackPoints(points, 0.f);
+  ASSERT_EQ(12, proto.data().size());
+  // 1.f is 0x3f800000.
+  EXPECT_EQ('\x00', proto.data()[0]);
+  EXPECT_EQ('\x00', proto.data()[1]);
+  EXPECT_EQ('\x80', proto.data()[2]);
+  EXPECT_EQ('\x3f', proto.data()[3]);
+}
+
+TEST(PackedPointCloudTest, Quantizes) {
+  constexpr float kResolution = 0.01f;
+  std::vector<TimedRangefinderPoint> points = CreateTimedPoints();
+  points.pop_back();
+  const proto::PackedPointCloud proto = PackPoints(points, kResolution);
+  EXPECT_EQ(kResolution, proto.resolution());
+  EXPECT_EQ(points.size() * 10, proto.data().size());
+  std::vector<TimedRangefinderPoint> unpacked;
+  ASSERT_TRUE(UnpackTimedPoints(proto, &unpacked));
+  ASSERT_EQ(points.size(), unpacked.size());
+  for (size_t i = 0; i < points.size(); ++i) {
+    EXPECT_TRUE(
+        (points[i].position - unpacked[i].position).isZero(kResolution / 2.f));
+    EXPECT_EQ(points[i].time, unpacked[i].time);
+  }
+}
+
+TEST(PackedPointCloudTest, FallsBackToFloatsIfOutOfRange) {
+  const std::vector<TimedRangefinderPoint> points = CreateTimedPoints();
+  const proto::PackedPointCloud proto = PackPoints(points, 0.001f);
+  EXPECT_EQ(0.f, proto.resolution());
+  std::vector<TimedRangefinderPoint> unpacked;
+  ASSERT_TRUE(UnpackTimedPoints(proto, &unpacked));
+  EXPECT_EQ(points, unpacked);
+}
+
+TEST(PackedPointCloudTest, RejectsMalformedData) {
+  const proto::PackedPointCloud valid = PackPoints(CreateTimedPoints(), 0.f);
+  std::vector<TimedRangefinderPoint> unpacked;
+  ASSERT_TRUE(UnpackTimedPoints(valid, &unpacked));
+
+  proto::PackedPointCloud proto = valid;
+  proto.set_num_points(-1);
+  EXPECT_FALSE(UnpackTimedPoints(proto, &unpacked));
+  EXPECT_TRUE(unpacked.empty());
+  proto = valid;
+  proto.set_num_points(valid.num_points() + 1);
+  EXPECT_FALSE(UnpackTimedPoints(proto, &unpacked));
+  proto = valid;
+  proto.mutable_data()->pop_back();
+  EXPECT_FALSE(UnpackTimedPoints(proto, &unpacked));
+  proto = valid;
+  proto.set_resolution(-0.01f);
+  EXPECT_FALSE(UnpackTimedPoints(proto, &unpacked));
+  proto = valid;
+  proto.set_has_time(false);
+  EXPECT_FALSE(UnpackTimedPoints(proto, &unpacked));
+
+  TimedPointCloudData data{common::FromUniversal(123),
+                           Eigen::Vector3f(1.f, 2.f, 3.f),
+                           CreateTimedPoints(),
+                           {1.f, 2.f, 3.f}};
+  proto::TimedPointCloudData data_proto =
+      ToProto(data, true /* pack_points */);
+  data_proto.mutable_packed_point_data()->mutable_data()->pop_back();
+  const TimedPointCloudData dropped = FromProto(data_proto);
+  EXPECT_TRUE(dropped.ranges.empty());
+  EXPECT_TRUE(dropped.intensities.empty());
+}
+
+TEST(PackedPointCloudTest, ReadsRepeatedPointData) {
+  const TimedPointCloudData data{common::FromUniversal(123),
+                                 Eigen::Vector3f(1.f, 2.f, 3.f),
+                                 CreateTimedPoints(),
+                                 {1.f, 2.f, 3.f}};
+  proto::TimedPointCloudData proto = ToProto(data, true /* pack_points */);
+  EXPECT_TRUE(proto.has_packed_point_data());
+  EXPECT_EQ(0, proto.point_data_size());
+  EXPECT_EQ(data.ranges, FromProto(proto).ranges);
+
+  // Packing is opt-in, so that older readers understand the default.
+  proto = ToProto(data);
+  EXPECT_FALSE(proto.has_packed_point_data());
+  EXPECT_EQ(data.ranges.size(), proto.point_data_size());
+  const TimedPointCloudData unpacked = FromProto(proto);
+  EXPECT_EQ(data.time, unpacked.time);
+  EXPECT_EQ(data.ranges, unpacked.ranges);
+  EXPECT_EQ(data.intensities, unpacked.intensities);
+}
+
+}  // namespace
+}  // namespace sensor
+}  // namespace cartographer
@@ -18,6 +18,7 @@
 
 #include "cartographer/sensor/proto/sensor.pb.h"
 #include "cartographer/transform/transform.h"
+#include "cartographer/transform/transform_points.h"
 
 namespace cartographer {
 namespace sensor {
@@ -55,21 +56,17 @@ void PointCloud::push_back(PointCloud::PointType value) {
 
 PointCloud TransformPointCloud(const PointCloud& point_cloud,
                                const transform::Rigid3f& transform) {
-  std::vector<RangefinderPoint> points;
-  points.reserve(point_cloud.size());
-  for (const RangefinderPoint& point : point_cloud.points()) {
-    points.emplace_back(transform * point);
-  }
-  return PointCloud(points, point_cloud.intensities());
+  std::vector<RangefinderPoint> points(point_cloud.size());
+  transform::TransformPointPositions(transform, point_cloud.points().data(),
+                                     point_cloud.size(), points.data());
+  return PointCloud(std::move(points), point_cloud.intensities());
 }
 
 TimedPointCloud TransformTimedPointCloud(const TimedPointCloud& point_cloud,
                                          const transform::Rigid3f& transform) {
-  TimedPointCloud result;
-  result.reserve(point_cloud.size());
-  for (const TimedRangefinderPoint& point : point_cloud) {
-    result.push_back(transform * point);
-  }
+  TimedPointCloud result(point_cloud.size());
+  transform::TransformPointPositions(transform, point_cloud.data(),
+                                     point_cloud.size(), result.data());
   return result;
 }
 
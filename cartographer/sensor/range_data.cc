@@ -24,8 +24,10 @@
 
 #include "cartographer/sensor/range_data.h"
 
+#include "cartographer/sensor/packed_point_cloud.h"
 #include "cartographer/sensor/proto/sensor.pb.h"
 #include "cartographer/transform/transform.h"
+#include "glog/logging.h"
 
 namespace cartographer {
 namespace sensor {
@@ -56,9 +58,17 @@ RangeData CropRangeData(const RangeData& range_data, const float min_z,
                    CropPointCloud(range_data.misses, min_z, max_z)};
 }
 
-proto::RangeData ToProto(const RangeData& range_data) {
+proto::RangeData ToProto(const RangeData& range_data,
+                         const bool pack_points) {
   proto::RangeData proto;
   *proto.mutable_origin() = transform::ToProto(range_data.origin);
+  if (pack_points) {
+    *proto.mutable_packed_returns() =
+        PackPoints(range_data.returns.points(), 0.f /* resolution */);
+    *proto.mutable_packed_misses() =
+        PackPoints(range_data.misses.points(), 0.f /* resolution */);
+    return proto;
+  }
   proto.mutable_returns()->Reserve(range_data.returns.size());
   for (const RangefinderPoint& point : range_data.returns) {
     *proto.add_returns() = ToProto(point);
@@ -72,7 +82,11 @@ proto::RangeData ToProto(const RangeData& range_data) {
 
 RangeData FromProto(const proto::RangeData& proto) {
   std::vector<RangefinderPoint> returns;
-  if (proto.returns_size() > 0) {
+  if (proto.has_packed_returns()) {
+    if (!UnpackPoints(proto.packed_returns(), &returns)) {
+      LOG(ERROR) << "Dropping malformed packed returns.";
+    }
+  } else if (proto.returns_size() > 0) {
     returns.reserve(proto.returns().size());
     for (const auto& point_proto : proto.returns()) {
       returns.push_back(FromProto(point_proto));
@@ -84,7 +98,11 @@ RangeData FromProto(const proto::RangeData& proto) {
     }
   }
   std::vector<RangefinderPoint> misses;
-  if (proto.misses_size() > 0) {
+  if (proto.has_packed_misses()) {
+    if (!UnpackPoints(proto.packed_misses(), &misses)) {
+      LOG(ERROR) << "Dropping malformed packed misses.";
+    }
+  } else if (proto.misses_size() > 0) {
     misses.reserve(proto.misses().size());
     for (const auto& point_proto : proto.misses()) {
       misses.push_back(FromProto(point_proto));
@@ -54,8 +54,10 @@ RangeData TransformRangeData(const RangeData& range_data,
 // Crops 'range_data' according to the region defined by 'min_z' and 'max_z'.
 RangeData CropRangeData(const RangeData& range_data, float min_z, float max_z);
 
-// Converts 'range_data' to a proto::RangeData.
-proto::RangeData ToProto(const RangeData& range_data);
+// Converts 'range_data' to a proto::RangeData. If 'pack_points' is true, the
+// points are written to the packed fields, which are more compact but ignored
+// by readers which predate them.
+proto::RangeData ToProto(const RangeData& range_data, bool pack_points = false);
 
 // Converts 'proto' to RangeData.
 RangeData FromProto(const proto::RangeData& proto);
@@ -16,20 +16,27 @@
 
 #include "cartographer/sensor/timed_point_cloud_data.h"
 
+#include "cartographer/sensor/packed_point_cloud.h"
 #include "cartographer/transform/proto/transform.pb.h"
 #include "cartographer/transform/transform.h"
+#include "glog/logging.h"
 
 namespace cartographer {
 namespace sensor {
 
 proto::TimedPointCloudData ToProto(
-    const TimedPointCloudData& timed_point_cloud_data) {
+    const TimedPointCloudData& timed_point_cloud_data, const bool pack_points) {
   proto::TimedPointCloudData proto;
   proto.set_timestamp(common::ToUniversal(timed_point_cloud_data.time));
   *proto.mutable_origin() = transform::ToProto(timed_point_cloud_data.origin);
-  proto.mutable_point_data()->Reserve(timed_point_cloud_data.ranges.size());
-  for (const TimedRangefinderPoint& range : timed_point_cloud_data.ranges) {
-    *proto.add_point_data() = ToProto(range);
+  if (pack_points) {
+    *proto.mutable_packed_point_data() =
+        PackPoints(timed_point_cloud_data.ranges, 0.f /* resolution */);
+  } else {
+    proto.mutable_point_data()->Reserve(timed_point_cloud_data.ranges.size());
+    for (const TimedRangefinderPoint& range : timed_point_cloud_data.ranges) {
+      *proto.add_point_data() = ToProto(range);
+    }
   }
   for (const float intensity : timed_point_cloud_data.intensities) {
     proto.add_intensities(intensity);
@@ -38,10 +45,16 @@ proto::TimedPointCloudData ToProto(
 }
 
 TimedPointCloudData FromProto(const proto::TimedPointCloudData& proto) {
-  CHECK(proto.intensities().size() == 0 ||
-        proto.intensities().size() == proto.point_data().size());
   TimedPointCloud timed_point_cloud;
-  if (proto.point_data().size() > 0) {
+  if (proto.has_packed_point_data()) {
+    if (!UnpackTimedPoints(proto.packed_point_data(), &timed_point_cloud)) {
+      LOG(ERROR) << "Dropping malformed packed point data.";
+      return TimedPointCloudData{common::FromUniversal(proto.timestamp()),
+                                 transform::ToEigen(proto.origin()),
+                                 {},
+                                 {}};
+    }
+  } else if (proto.point_data().size() > 0) {
     timed_point_cloud.reserve(proto.point_data().size());
     for (const auto& timed_point_proto : proto.point_data()) {
       timed_point_cloud.push_back(FromProto(timed_point_proto));
@@ -53,6 +66,9 @@ TimedPointCloudData FromProto(const proto::TimedPointCloudData& proto) {
       timed_point_cloud.push_back({timed_point.head<3>(), timed_point[3]});
     }
   }
+  CHECK(proto.intensities().size() == 0 ||
+        static_cast<size_t>(proto.intensities().size()) ==
+            timed_point_cloud.size());
   return TimedPointCloudData{common::FromUniversal(proto.timestamp()),
                              transform::ToEigen(proto.origin()),
                              timed_point_cloud,
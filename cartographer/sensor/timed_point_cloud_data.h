@@ -43,9 +43,12 @@ struct TimedPointCloudOriginData {
   std::vector<RangeMeasurement> ranges;
 };
 
-// Converts 'timed_point_cloud_data' to a proto::TimedPointCloudData.
+// Converts 'timed_point_cloud_data' to a proto::TimedPointCloudData. If
+// 'pack_points' is true, the points are written to the packed field, which is
+// more compact but ignored by readers which predate it.
 proto::TimedPointCloudData ToProto(
-    const TimedPointCloudData& timed_point_cloud_data);
+    const TimedPointCloudData& timed_point_cloud_data,
+    bool pack_points = false);
 
 // Converts 'proto' to TimedPointCloudData.
 TimedPointCloudData FromProto(const proto::TimedPointCloudData& proto);
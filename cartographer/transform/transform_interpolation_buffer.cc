@@ -49,10 +49,13 @@ void TransformInterpolationBuffer::SetSizeLimit(
   RemoveOldTransformsIfNeeded();
 }
 
-void TransformInterpolationBuffer::Clear() { timestamped_transforms_.clear(); }
+void TransformInterpolationBuffer::Clear() {
+  timestamped_transforms_.clear();
+  first_index_ = 0;
+}
 
 bool TransformInterpolationBuffer::Has(const common::Time time) const {
-  if (timestamped_transforms_.empty()) {
+  if (empty()) {
     return false;
   }
   return earliest_time() <= time && time <= latest_time();
@@ -62,7 +65,8 @@ transform::Rigid3d TransformInterpolationBuffer::Lookup(
     const common::Time time) const {
   CHECK(Has(time)) << "Missing transform for: " << time;
   const auto end = std::lower_bound(
-      timestamped_transforms_.begin(), timestamped_transforms_.end(), time,
+      timestamped_transforms_.begin() + first_index_,
+      timestamped_transforms_.end(), time,
       [](const TimestampedTransform& timestamped_transform,
          const common::Time time) {
         return timestamped_transform.time < time;
@@ -74,15 +78,32 @@ transform::Rigid3d TransformInterpolationBuffer::Lookup(
   return Interpolate(*start, *end, time).transform;
 }
 
+std::vector<transform::Rigid3d> TransformInterpolationBuffer::LookupSorted(
+    const std::vector<common::Time>& times) const {
+  std::vector<transform::Rigid3d> result;
+  result.reserve(times.size());
+  SortedLookupCursor cursor(this);
+  for (const common::Time time : times) {
+    result.push_back(cursor.Lookup(time));
+  }
+  return result;
+}
+
 void TransformInterpolationBuffer::RemoveOldTransformsIfNeeded() {
-  while (timestamped_transforms_.size() > buffer_size_limit_) {
-    timestamped_transforms_.pop_front();
+  if (size() > buffer_size_limit_) {
+    first_index_ += size() - buffer_size_limit_;
+  }
+  if (first_index_ > timestamped_transforms_.size() / 2) {
+    timestamped_transforms_.erase(
+        timestamped_transforms_.begin(),
+        timestamped_transforms_.begin() + first_index_);
+    first_index_ = 0;
   }
 }
 
 common::Time TransformInterpolationBuffer::earliest_time() const {
   CHECK(!empty()) << "Empty buffer.";
-  return timestamped_transforms_.front().time;
+  return at(0).time;
 }
 
 common::Time TransformInterpolationBuffer::latest_time() const {
@@ -90,16 +111,91 @@ common::Time TransformInterpolationBuffer::latest_time() const {
   return timestamped_transforms_.back().time;
 }
 
-bool TransformInterpolationBuffer::empty() const {
-  return timestamped_transforms_.empty();
-}
+bool TransformInterpolationBuffer::empty() const { return size() == 0; }
 
 size_t TransformInterpolationBuffer::size_limit() const {
   return buffer_size_limit_;
 }
 
 size_t TransformInterpolationBuffer::size() const {
-  return timestamped_transforms_.size();
+  return timestamped_transforms_.size() - first_index_;
+}
+
+TransformInterpolationBuffer::SortedLookupCursor::SortedLookupCursor(
+    const TransformInterpolationBuffer* const buffer)
+    : buffer_(buffer) {
+  CHECK(!buffer_->empty()) << "Empty buffer.";
+  last_time_ = buffer_->earliest_time();
+}
+
+transform::Rigid3d TransformInterpolationBuffer::SortedLookupCursor::Lookup(
+    const common::Time time) {
+  CHECK(buffer_->Has(time)) << "Missing transform for: " << time;
+  if (time < last_time_) {
+    index_ = std::lower_bound(
+                 buffer_->timestamped_transforms_.begin() +
+                     buffer_->first_index_,
+                 buffer_->timestamped_transforms_.end(), time,
+                 [](const TimestampedTransform& timestamped_transform,
+                    const common::Time time) {
+                   return timestamped_transform.time < time;
+                 }) -
+             (buffer_->timestamped_transforms_.begin() + buffer_->first_index_);
+  } else {
+    while (buffer_->at(index_).time < time) {
+      ++index_;
+    }
+  }
+  last_time_ = time;
+
+  const TimestampedTransform& end = buffer_->at(index_);
+  if (end.time == time) {
+    return end.transform;
+  }
+  if (segment_.end_index != index_) {
+    const TimestampedTransform& start = buffer_->at(index_ - 1);
+    segment_.end_index = index_;
+    segment_.start_time = start.time;
+    segment_.inverse_duration = 1. / common::ToSeconds(end.time - start.time);
+    segment_.start_translation = start.transform.translation();
+    segment_.translation_delta =
+        end.transform.translation() - start.transform.translation();
+    segment_.start_rotation = start.transform.rotation();
+    segment_.end_rotation = end.transform.rotation();
+  }
+  const double factor = common::ToSeconds(time - segment_.start_time) *
+                        segment_.inverse_duration;
+  return transform::Rigid3d(
+      segment_.start_translation + segment_.translation_delta * factor,
+      segment_.start_rotation.slerp(factor, segment_.end_rotation));
+}
+
+FixedRateTransformTable::FixedRateTransformTable(
+    const TransformInterpolationBuffer& buffer,
+    const common::Duration sampling_period)
+    : start_time_(buffer.earliest_time()),
+      end_time_(buffer.latest_time()),
+      sampling_period_(sampling_period) {
+  CHECK_GT(sampling_period_.count(), 0);
+  const size_t num_samples = (end_time_ - start_time_) / sampling_period_ + 1;
+  samples_.reserve(num_samples);
+  TransformInterpolationBuffer::SortedLookupCursor cursor(&buffer);
+  for (size_t i = 0; i < num_samples; ++i) {
+    samples_.push_back(
+        cursor.Lookup(start_time_ + static_cast<int64>(i) * sampling_period_));
+  }
+}
+
+bool FixedRateTransformTable::Has(const common::Time time) const {
+  return start_time_ <= time && time <= end_time_;
+}
+
+const transform::Rigid3d& FixedRateTransformTable::Lookup(
+    const common::Time time) const {
+  CHECK(Has(time)) << "Missing transform for: " << time;
+  const size_t index =
+      ((time - start_time_) + sampling_period_ / 2) / sampling_period_;
+  return samples_[std::min(index, samples_.size() - 1)];
 }
 
 }  // namespace transform
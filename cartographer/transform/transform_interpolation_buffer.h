@@ -17,8 +17,8 @@
 #ifndef CARTOGRAPHER_TRANSFORM_TRANSFORM_INTERPOLATION_BUFFER_H_
 #define CARTOGRAPHER_TRANSFORM_TRANSFORM_INTERPOLATION_BUFFER_H_
 
-#include <deque>
 #include <limits>
+#include <vector>
 
 #include "cartographer/common/time.h"
 #include "cartographer/mapping/proto/trajectory.pb.h"
@@ -56,6 +56,44 @@ class TransformInterpolationBuffer {
   // 'time' is available.
   transform::Rigid3d Lookup(common::Time time) const;
 
+  // Like 'Lookup' for each of 'times', which should be sorted. Much faster
+  // than individual lookups, see 'SortedLookupCursor'.
+  std::vector<transform::Rigid3d> LookupSorted(
+      const std::vector<common::Time>& times) const;
+
+  // Performs lookups for non-decreasing times. Instead of a binary search over
+  // the whole buffer, each lookup advances from where the previous one ended,
+  // and the interpolation setup is reused while queries stay between the same
+  // two transforms. A sequence of sorted lookups therefore costs O(1)
+  // amortized per lookup. Decreasing times are supported but fall back to a
+  // binary search. The cursor must not be used after the buffer is modified.
+  class SortedLookupCursor {
+   public:
+    explicit SortedLookupCursor(const TransformInterpolationBuffer* buffer);
+
+    // Same as 'TransformInterpolationBuffer::Lookup'.
+    transform::Rigid3d Lookup(common::Time time);
+
+   private:
+    // Interpolation between the transforms at 'segment_end_ - 1' and
+    // 'segment_end_', precomputed once per pair of transforms.
+    struct Segment {
+      size_t end_index = 0;
+      common::Time start_time;
+      double inverse_duration;
+      Eigen::Vector3d start_translation;
+      Eigen::Vector3d translation_delta;
+      Eigen::Quaterniond start_rotation;
+      Eigen::Quaterniond end_rotation;
+    };
+
+    const TransformInterpolationBuffer* const buffer_;
+    // Index of the first transform not older than the last query.
+    size_t index_ = 0;
+    common::Time last_time_;
+    Segment segment_;
+  };
+
   // Returns the timestamp of the earliest transform in the buffer or 0 if the
   // buffer is empty.
   common::Time earliest_time() const;
@@ -76,10 +114,42 @@ class TransformInterpolationBuffer {
  private:
   void RemoveOldTransformsIfNeeded();
 
-  std::deque<TimestampedTransform> timestamped_transforms_;
+  const TimestampedTransform& at(size_t index) const {
+    return timestamped_transforms_[first_index_ + index];
+  }
+
+  // The transforms are stored contiguously starting at 'first_index_'.
+  // Removing old transforms only advances 'first_index_', and the storage is
+  // compacted once more than half of it is unused.
+  std::vector<TimestampedTransform> timestamped_transforms_;
+  size_t first_index_ = 0;
   size_t buffer_size_limit_ = kUnlimitedBufferSize;
 };
 
+// Transforms of a 'TransformInterpolationBuffer' precomputed at a fixed rate.
+// A lookup is a single index computation, which makes this suitable for
+// per-point lookups in large point clouds. The returned transform is the
+// sample nearest to the query, so the result can deviate from an exact
+// interpolation by the motion within half a 'sampling_period'.
+class FixedRateTransformTable {
+ public:
+  FixedRateTransformTable(const TransformInterpolationBuffer& buffer,
+                          common::Duration sampling_period);
+
+  // Returns true if 'time' is within the time range of the buffer.
+  bool Has(common::Time time) const;
+
+  // Returns the precomputed transform nearest to 'time'. CHECK()s that 'time'
+  // is within the time range of the buffer.
+  const transform::Rigid3d& Lookup(common::Time time) const;
+
+ private:
+  common::Time start_time_;
+  common::Time end_time_;
+  common::Duration sampling_period_;
+  std::vector<transform::Rigid3d> samples_;
+};
+
 }  // namespace transform
 }  // namespace cartographer
 
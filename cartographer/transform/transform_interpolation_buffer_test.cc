@@ -86,6 +86,77 @@ TEST(TransformInterpolationBufferTest, testSetSizeLimit) {
   EXPECT_FALSE(buffer.Has(common::FromUniversal(1)));
 }
 
+TEST(TransformInterpolationBufferTest, testSizeLimitKeepsLatestTransforms) {
+  TransformInterpolationBuffer buffer;
+  buffer.SetSizeLimit(3);
+  for (int i = 0; i < 100; ++i) {
+    buffer.Push(common::FromUniversal(i),
+                transform::Rigid3d::Translation(Eigen::Vector3d(i, 0., 0.)));
+    EXPECT_EQ(buffer.size(), std::min(i + 1, 3));
+    EXPECT_EQ(buffer.earliest_time(),
+              common::FromUniversal(std::max(0, i - 2)));
+  }
+  EXPECT_THAT(buffer.Lookup(common::FromUniversal(98)),
+              IsNearly(transform::Rigid3d::Translation(
+                           Eigen::Vector3d(98., 0., 0.)),
+                       1e-9));
+}
+
+TransformInterpolationBuffer CreateRotatingBuffer() {
+  TransformInterpolationBuffer buffer;
+  for (int i = 0; i <= 10; ++i) {
+    buffer.Push(common::FromUniversal(100 * i),
+                transform::Rigid3d(
+                    Eigen::Vector3d(i, i * i, -i),
+                    Eigen::Quaterniond(Eigen::AngleAxisd(
+                        0.3 * i, Eigen::Vector3d(1., 2., 3.).normalized()))));
+  }
+  return buffer;
+}
+
+TEST(TransformInterpolationBufferTest, testLookupSorted) {
+  const TransformInterpolationBuffer buffer = CreateRotatingBuffer();
+  std::vector<common::Time> times;
+  for (int i = 0; i <= 1000; i += 7) {
+    times.push_back(common::FromUniversal(i));
+  }
+  times.push_back(common::FromUniversal(1000));
+  const std::vector<transform::Rigid3d> transforms =
+      buffer.LookupSorted(times);
+  ASSERT_EQ(transforms.size(), times.size());
+  for (size_t i = 0; i < times.size(); ++i) {
+    EXPECT_THAT(transforms[i], IsNearly(buffer.Lookup(times[i]), 1e-9));
+  }
+}
+
+TEST(TransformInterpolationBufferTest, testCursorWithDecreasingTimes) {
+  const TransformInterpolationBuffer buffer = CreateRotatingBuffer();
+  TransformInterpolationBuffer::SortedLookupCursor cursor(&buffer);
+  for (const int64 time : {550, 950, 120, 120, 0, 1000, 305}) {
+    EXPECT_THAT(cursor.Lookup(common::FromUniversal(time)),
+                IsNearly(buffer.Lookup(common::FromUniversal(time)), 1e-9));
+  }
+}
+
+TEST(TransformInterpolationBufferTest, testFixedRateTransformTable) {
+  const TransformInterpolationBuffer buffer = CreateRotatingBuffer();
+  const FixedRateTransformTable table(buffer, common::Duration(10));
+  EXPECT_FALSE(table.Has(common::FromUniversal(-1)));
+  EXPECT_TRUE(table.Has(common::FromUniversal(0)));
+  EXPECT_TRUE(table.Has(common::FromUniversal(1000)));
+  EXPECT_FALSE(table.Has(common::FromUniversal(1001)));
+  // Queries on the sampling grid are exact.
+  for (int i = 0; i <= 1000; i += 10) {
+    EXPECT_THAT(table.Lookup(common::FromUniversal(i)),
+                IsNearly(buffer.Lookup(common::FromUniversal(i)), 1e-9));
+  }
+  // Other queries return the nearest sample.
+  EXPECT_THAT(table.Lookup(common::FromUniversal(304)),
+              IsNearly(buffer.Lookup(common::FromUniversal(300)), 1e-9));
+  EXPECT_THAT(table.Lookup(common::FromUniversal(306)),
+              IsNearly(buffer.Lookup(common::FromUniversal(310)), 1e-9));
+}
+
 }  // namespace
 }  // namespace transform
 }  // namespace cartographer
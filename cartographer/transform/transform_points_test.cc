@@ -0,0 +1,76 @@
+/*
+ * Copyright 2016 The Cartographer Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cartographer/transform/transform_points.h"
+
+#include <random>
+#include <vector>
+
+#include "cartographer/transform/rigid_transform.h"
+#include "gtest/gtest.h"
+
+namespace cartographer {
+namespace transform {
+namespace {
+
+struct TimedPoint {
+  Eigen::Vector3f position;
+  float time;
+};
+
+TEST(TransformPointsTest, MatchesRigidTransformOperator) {
+  std::mt19937 prng(42);
+  std::uniform_real_distribution<float> distribution(-10.f, 10.f);
+  const Rigid3f transform(
+      Eigen::Vector3f(1.f, -2.f, 3.f),
+      RollPitchYaw(0.3, -0.7, 2.1).cast<float>());
+  // Use a size which is not a multiple of typical vector widths.
+  std::vector<Eigen::Vector3f> points;
+  for (int i = 0; i < 37; ++i) {
+    points.emplace_back(distribution(prng), distribution(prng),
+                        distribution(prng));
+  }
+  std::vector<Eigen::Vector3f> transformed(points.size());
+  TransformPoints(transform, points.data(), points.size(),
+                  transformed.data());
+  for (size_t i = 0; i < points.size(); ++i) {
+    EXPECT_TRUE(transformed[i].isApprox(transform * points[i], 1e-5f));
+  }
+
+  // Transforming in place gives the same result.
+  TransformPoints(transform, points.data(), points.size(), points.data());
+  EXPECT_EQ(points, transformed);
+}
+
+TEST(TransformPointsTest, KeepsOtherMembers) {
+  const Rigid3f transform(Eigen::Vector3f(0.5f, 0.f, -1.f),
+                          RollPitchYaw(0., 0., 1.5).cast<float>());
+  const std::vector<TimedPoint> points = {
+      {Eigen::Vector3f(1.f, 2.f, 3.f), -1.f},
+      {Eigen::Vector3f(-4.f, 0.f, 2.f), 0.f}};
+  std::vector<TimedPoint> transformed(points.size());
+  TransformPointPositions(transform, points.data(), points.size(),
+                          transformed.data());
+  for (size_t i = 0; i < points.size(); ++i) {
+    EXPECT_TRUE(transformed[i].position.isApprox(
+        transform * points[i].position, 1e-5f));
+    EXPECT_EQ(transformed[i].time, points[i].time);
+  }
+}
+
+}  // namespace
+}  // namespace transform
+}  // namespace cartographer
@@ -30,6 +30,7 @@ POSE_GRAPH = {
     loop_closure_translation_weight = 1.1e4,
     loop_closure_rotation_weight = 1e5,
     log_matches = true,
+    min_scan_descriptor_similarity_2d = 0.,
     fast_correlative_scan_matcher = {
       linear_search_window = 7.,
       angular_search_window = math.rad(30.),
@@ -83,6 +84,7 @@ POSE_GRAPH = {
     fixed_frame_pose_tolerant_loss_param_a = 1,
     fixed_frame_pose_tolerant_loss_param_b = 1,
     log_solver_summary = false,
+    discard_unused_sensor_data = false,
     use_online_imu_extrinsics_in_3d = true,
     fix_z_in_3d = false,
     ceres_solver_options = {
@@ -95,6 +97,8 @@ POSE_GRAPH = {
   global_sampling_ratio = 0.003,
   log_residual_histograms = true,
   global_constraint_search_after_n_seconds = 10.,
+  local_optimization_window_num_submaps = 0,
+  global_constraint_search_num_submaps = 0,
   --  overlapping_submaps_trimmer_2d = {
   --    fresh_submaps_count = 1,
   --    min_covered_area = 2,
@@ -40,6 +40,8 @@ TRAJECTORY_BUILDER_2D = {
     angular_search_window = math.rad(20.),
     translation_delta_cost_weight = 1e-1,
     rotation_delta_cost_weight = 1e-1,
+    batched_evaluation_3d = false,
+    num_threads_3d = 1,
   },
 
   ceres_scan_matcher = {
@@ -109,7 +111,9 @@ TRAJECTORY_BUILDER_2D = {
         update_weight_range_exponent = 0,
         update_weight_angle_scan_normal_to_ray_kernel_bandwidth = 0.5,
         update_weight_distance_cell_to_hit_kernel_bandwidth = 0.5,
+        num_threads = 1,
       },
     },
+    num_pyramid_levels = 0,
   },
 }
@@ -39,6 +39,8 @@ TRAJECTORY_BUILDER_3D = {
     angular_search_window = math.rad(1.),
     translation_delta_cost_weight = 1e-1,
     rotation_delta_cost_weight = 1e-1,
+    batched_evaluation_3d = false,
+    num_threads_3d = 1,
   },
 
   ceres_scan_matcher = {
@@ -98,6 +100,7 @@ TRAJECTORY_BUILDER_3D = {
     high_resolution_max_range = 20.,
     low_resolution = 0.45,
     num_range_data = 160,
+    max_intensity = 65535.,
     range_data_inserter = {
       hit_probability = 0.55,
       miss_probability = 0.49,